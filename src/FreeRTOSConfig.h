@@ -90,11 +90,11 @@ extern uint32_t SystemCoreClock;
 #define configUSE_TICK_HOOK				0
 #define configCPU_CLOCK_HZ				( SystemCoreClock )
 #define configTICK_RATE_HZ				( ( TickType_t ) 1000 )
-#define configMAX_PRIORITIES			( 5 )
-#define configMINIMAL_STACK_SIZE		( ( unsigned short ) 130 )
-#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 7 * 1024 ) )
+#define configMAX_PRIORITIES			( 8 )
+#define configMINIMAL_STACK_SIZE		( ( unsigned short ) 160 )
+#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 16 * 1024 ) )
 #define configMAX_TASK_NAME_LEN			( 10 )
-#define configUSE_TRACE_FACILITY		0
+#define configUSE_TRACE_FACILITY		1
 #define configUSE_16_BIT_TICKS			0
 #define configIDLE_SHOULD_YIELD			1
 #define configUSE_MUTEXES				1
@@ -102,10 +102,75 @@ extern uint32_t SystemCoreClock;
 #define configCHECK_FOR_STACK_OVERFLOW	2
 #define configUSE_RECURSIVE_MUTEXES		1
 #define configUSE_MALLOC_FAILED_HOOK	1
-#define configUSE_APPLICATION_TASK_TAG	0
+#define configUSE_APPLICATION_TASK_TAG	1
 #define configUSE_COUNTING_SEMAPHORES	1
 #define configGENERATE_RUN_TIME_STATS	0
 
+/* Tickless idle. The DD scheduler wraps the port's sleep function so that the
+sleep horizon never passes its next release or deadline, and counts each
+wakeup. See vDDSuppressTicksAndSleep() in main.c. */
+#define configUSE_TICKLESS_IDLE					1
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP	2
+extern void vDDSuppressTicksAndSleep( uint32_t xExpectedIdleTime );
+extern void vDDPostSleepProcessing( void );
+#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vDDSuppressTicksAndSleep( xExpectedIdleTime )
+#define configPOST_SLEEP_PROCESSING( xExpectedIdleTime ) vDDPostSleepProcessing()
+
+/* Heap telemetry. The allocator reports every block it hands out or takes
+back, see dd_heap.h. */
+extern void ddHeapTraceMalloc( void *pvAddress, size_t uiSize );
+extern void ddHeapTraceFree( void *pvAddress, size_t uiSize );
+#define traceMALLOC( pvAddress, uiSize ) ddHeapTraceMalloc( pvAddress, uiSize )
+#define traceFREE( pvAddress, uiSize ) ddHeapTraceFree( pvAddress, uiSize )
+
+/* Context switch cycle counts, see dd_cycles.h. */
+#ifndef DD_RELEASE
+extern void ddCyclesSwitchedOut( void );
+extern void ddCyclesSwitchedIn( void );
+#define DD_CYCLES_SWITCHED_OUT() ddCyclesSwitchedOut()
+#define DD_CYCLES_SWITCHED_IN() ddCyclesSwitchedIn()
+#else
+#define DD_CYCLES_SWITCHED_OUT()
+#define DD_CYCLES_SWITCHED_IN()
+#endif
+
+/* Scheduling timeline, see dd_trace.h. Tasks keep their trace ID in their
+application task tag, queues and timers in their trace facility number. */
+#ifndef DD_TRACE
+	#define DD_TRACE	1
+#endif
+
+#if DD_TRACE
+extern uint32_t ddTraceTaskCreated( const char *pcName, uint32_t ulPriority );
+extern void ddTraceTaskSwitchedIn( uint32_t ulTask );
+extern uint32_t ddTraceObjectCreated( void );
+extern void ddTraceQueueSend( uint32_t ulQueue, uint32_t ulWaiting );
+extern void ddTraceQueueReceive( uint32_t ulQueue, uint32_t ulWaiting );
+extern void ddTraceQueueBlock( uint32_t ulQueue );
+extern void ddTraceTimerExpired( uint32_t ulTimer );
+#define DD_TRACE_SWITCHED_IN() ddTraceTaskSwitchedIn( ( uint32_t ) pxCurrentTCB->pxTaskTag )
+#define traceTASK_CREATE( pxNewTCB ) ( pxNewTCB )->pxTaskTag = ( TaskHookFunction_t ) ddTraceTaskCreated( ( pxNewTCB )->pcTaskName, ( pxNewTCB )->uxPriority )
+#define traceQUEUE_CREATE( pxNewQueue ) ( pxNewQueue )->uxQueueNumber = ddTraceObjectCreated()
+#define traceQUEUE_SEND( pxQueue ) ddTraceQueueSend( ( pxQueue )->uxQueueNumber, ( pxQueue )->uxMessagesWaiting )
+#define traceQUEUE_SEND_FROM_ISR( pxQueue ) ddTraceQueueSend( ( pxQueue )->uxQueueNumber, ( pxQueue )->uxMessagesWaiting )
+#define traceQUEUE_RECEIVE( pxQueue ) ddTraceQueueReceive( ( pxQueue )->uxQueueNumber, ( pxQueue )->uxMessagesWaiting )
+#define traceQUEUE_RECEIVE_FROM_ISR( pxQueue ) ddTraceQueueReceive( ( pxQueue )->uxQueueNumber, ( pxQueue )->uxMessagesWaiting )
+#define traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue ) ddTraceQueueBlock( ( pxQueue )->uxQueueNumber )
+#define traceTIMER_CREATE( pxNewTimer ) ( pxNewTimer )->uxTimerNumber = ddTraceObjectCreated()
+#define traceTIMER_EXPIRED( pxTimer ) ddTraceTimerExpired( ( pxTimer )->uxTimerNumber )
+#else
+#define DD_TRACE_SWITCHED_IN()
+#endif
+
+/* Run time by task class for explaining deadline misses, see dd_miss.h, and
+by job for enforcing their budgets, see dd_budget.h. */
+extern void ddMissSwitchedOut( uint32_t ulTag );
+extern void ddBudgetSwitchedOut( void );
+extern void ddBudgetSwitchedIn( uint32_t ulTag );
+
+#define traceTASK_SWITCHED_OUT() { ddMissSwitchedOut( ( uint32_t ) pxCurrentTCB->pxTaskTag ); ddBudgetSwitchedOut(); DD_CYCLES_SWITCHED_OUT(); }
+#define traceTASK_SWITCHED_IN() { DD_CYCLES_SWITCHED_IN(); ddBudgetSwitchedIn( ( uint32_t ) pxCurrentTCB->pxTaskTag ); DD_TRACE_SWITCHED_IN(); }
+
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES 		0
 #define configMAX_CO_ROUTINE_PRIORITIES ( 2 )
@@ -125,6 +190,9 @@ to exclude the API function. */
 #define INCLUDE_vTaskSuspend			1
 #define INCLUDE_vTaskDelayUntil			1
 #define INCLUDE_vTaskDelay				1
+#define INCLUDE_uxTaskGetStackHighWaterMark		1
+#define INCLUDE_xTaskGetIdleTaskHandle			1
+#define INCLUDE_xTimerGetTimerDaemonTaskHandle	1
 
 /* Cortex-M specific definitions. */
 #ifdef __NVIC_PRIO_BITS
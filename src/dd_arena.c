@@ -0,0 +1,42 @@
+/*
+ * dd_arena.c
+ *
+ * Bump allocator. See dd_arena.h.
+ */
+
+#include "dd_arena.h"
+
+void ddArenaInit(dd_arena* arena, void* storage, size_t size)
+{
+	arena->base = (uint8_t*)storage;
+	arena->size = size;
+	arena->used = 0;
+	arena->peak = 0;
+	arena->allocs = 0;
+	arena->failures = 0;
+	arena->resets = 0;
+}
+
+void* ddArenaAlloc(dd_arena* arena, size_t size)
+{
+	size_t start = (arena->used + DD_ARENA_ALIGN - 1) & ~(size_t)(DD_ARENA_ALIGN - 1);
+
+	if (size == 0 || start > arena->size || size > arena->size - start)
+	{
+		arena->failures++;
+		return NULL;
+	}
+
+	arena->used = start + size;
+	arena->allocs++;
+	if (arena->used > arena->peak) arena->peak = arena->used;
+
+	return arena->base + start;
+}
+
+void ddArenaReset(dd_arena* arena)
+{
+	arena->used = 0;
+	arena->allocs = 0;
+	arena->resets++;
+}
@@ -0,0 +1,41 @@
+/*
+ * dd_arena.h
+ *
+ * Bump allocator over a fixed buffer, for allocations that all die at the
+ * same time. Allocating moves a pointer forward and there is no free; the
+ * whole arena is reset at once. The monitor uses one for the list replies
+ * of each cycle so that reporting never touches the FreeRTOS heap that job
+ * records and task stacks come from.
+ *
+ * Not thread safe: the owner must make sure allocations and resets do not
+ * overlap.
+ *
+ * No FreeRTOS dependencies.
+ */
+
+#ifndef DD_ARENA_H_
+#define DD_ARENA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Every allocation is aligned to this many bytes. */
+#define DD_ARENA_ALIGN		8
+
+typedef struct dd_arena
+{
+	uint8_t* base;
+	size_t size;
+	size_t used;
+	size_t peak;			// Most used in any one cycle
+	uint32_t allocs;		// In the current cycle
+	uint32_t failures;		// Since init
+	uint32_t resets;
+} dd_arena;
+
+void ddArenaInit(dd_arena* arena, void* storage, size_t size);
+void* ddArenaAlloc(dd_arena* arena, size_t size);
+void ddArenaReset(dd_arena* arena);
+
+#endif /* DD_ARENA_H_ */
@@ -0,0 +1,67 @@
+/*
+ * dd_boot.c
+ *
+ * Boot-time profile. See dd_boot.h.
+ */
+
+#include <stdio.h>
+
+#include "stm32f4xx.h"
+#include "dd_boot.h"
+
+typedef struct dd_boot_mark
+{
+	uint32_t cycles;		// Cycle counter when the stage completed, 0 if it has not
+	uint32_t hz;			// Core clock when the stage completed
+} dd_boot_mark;
+
+static const char* const stage_names[DD_BOOT_STAGE_COUNT] =
+{
+	"Reset", "Memory Ready", "SystemInit", "Main", "Clock Ready", "Scheduler Ready",
+	"Tasks Created", "Scheduler Running", "First Dispatch"
+};
+
+/* Zeroed with .bss, after which the first two stages are stamped. */
+static dd_boot_mark boot_marks[DD_BOOT_STAGE_COUNT];
+
+/*
+ * Stamps a stage the first time it completes. Returns true for that first
+ * time, so callers can run deferred work exactly once.
+ */
+bool ddBootStamp(dd_boot_stage stage)
+{
+	uint32_t cycles = DWT->CYCCNT;
+
+	if (boot_marks[stage].cycles != 0)
+	{
+		return false;
+	}
+
+	boot_marks[stage].cycles = cycles;
+	boot_marks[stage].hz = ((RCC->CFGR & RCC_CFGR_SWS) == RCC_CFGR_SWS_PLL) ? SystemCoreClock : HSI_VALUE;
+	return true;
+}
+
+void ddBootPrintProfile(void)
+{
+	dd_boot_mark prev = { 0, HSI_VALUE };
+	uint64_t total_us = 0;
+
+	for (uint32_t i = DD_BOOT_RESET + 1; i < DD_BOOT_STAGE_COUNT; i++)
+	{
+		if (boot_marks[i].cycles == 0)
+		{
+			printf("Boot %s: not reached\n", stage_names[i]);
+			continue;
+		}
+
+		uint32_t cycles = boot_marks[i].cycles - prev.cycles;
+		uint32_t us = (uint32_t)(((uint64_t)cycles * 1000000) / prev.hz);
+
+		total_us += us;
+		printf("Boot %s: +%u cycles, +%u us, %u us since reset\n", stage_names[i],
+				(unsigned int)cycles, (unsigned int)us, (unsigned int)total_us);
+
+		prev = boot_marks[i];
+	}
+}
@@ -0,0 +1,48 @@
+/*
+ * dd_boot.h
+ *
+ * Boot-time profile, from reset to the first DD job dispatch. Reset_Handler
+ * starts the DWT cycle counter as its first instruction, and each boot stage
+ * stamps the counter once as it completes. The core runs from the 16 MHz
+ * HSI until the PLL is selected, so each interval is converted to time at
+ * the clock that was running when it started.
+ *
+ * Building with -DDD_FAST_BOOT shortens the boot:
+ *  - Reset_Handler starts the HSE oscillator before copying .data and
+ *    zeroing .bss, and SystemInit() only starts the PLL, so the oscillator
+ *    and the PLL lock while the C runtime is set up. main() switches to the
+ *    PLL (SystemClockFinish()) before anything depends on the clock.
+ *  - The monitor task, which only reports, is created by the scheduler after
+ *    the first DD job has been dispatched instead of before the scheduler
+ *    starts.
+ */
+
+#ifndef DD_BOOT_H_
+#define DD_BOOT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* startup_stm32f4xx.s stamps MEMORY_READY and SYSTEM_INIT by number. */
+typedef enum dd_boot_stage
+{
+	DD_BOOT_RESET = 0,				// Cycle counter started
+	DD_BOOT_MEMORY_READY = 1,		// .data copied and .bss zeroed
+	DD_BOOT_SYSTEM_INIT = 2,		// SystemInit() returned
+	DD_BOOT_MAIN = 3,				// Static constructors run, main() entered
+	DD_BOOT_CLOCK_READY,			// Running from the PLL
+	DD_BOOT_SCHEDULER_READY,		// initScheduler() returned
+	DD_BOOT_TASKS_CREATED,			// Generators created, kernel about to start
+	DD_BOOT_SCHEDULER_RUNNING,		// First pass of the DD scheduler task
+	DD_BOOT_FIRST_DISPATCH,			// First DD job placed in the active list
+	DD_BOOT_STAGE_COUNT
+} dd_boot_stage;
+
+bool ddBootStamp(dd_boot_stage stage);
+void ddBootPrintProfile(void);
+
+/* Provided by system_stm32f4xx.c. Without DD_FAST_BOOT they do nothing. */
+void SystemClockStart(void);
+void SystemClockFinish(void);
+
+#endif /* DD_BOOT_H_ */
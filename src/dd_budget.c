@@ -0,0 +1,144 @@
+/*
+ * dd_budget.c
+ *
+ * Execution budgets for DD jobs. See dd_budget.h.
+ */
+
+#include "dd_clock.h"
+#include "dd_miss.h"
+#include "dd_budget.h"
+
+static const char* const policy_names[DD_BUDGET_POLICY_COUNT] = { "Demote", "Suspend", "Abort" };
+
+/* Updated by the switch hooks with interrupts masked; the clock interrupt clears the expiry. */
+static dd_slot budget_running = DD_SLOT_NONE;
+static uint32_t budget_switch_time;
+static dd_time_t budget_expiry = DD_TIME_NEVER;
+
+static dd_budget* budgets = NULL;
+static uint32_t budget_count = 0;
+static dd_budget_arm budget_arm = NULL;
+
+/* Written by the scheduler only. */
+static uint32_t budget_exhausted = 0;
+
+void ddBudgetInit(dd_budget* storage, uint32_t count, dd_budget_arm arm)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		storage[i].budget = 0;
+		storage[i].used = 0;
+		storage[i].exhausted = false;
+	}
+
+	budgets = storage;
+	budget_count = count;
+	budget_arm = arm;
+}
+
+/* Gives the job in slot its budget as it reaches the active list, before it first runs. */
+void ddBudgetStart(dd_slot slot, uint32_t budget)
+{
+	if (slot >= budget_count)
+	{
+		return;
+	}
+
+	budgets[slot].budget = budget;
+	budgets[slot].used = 0;
+	budgets[slot].exhausted = false;
+}
+
+/* Forgets the job in slot as it leaves the active list. */
+void ddBudgetStop(dd_slot slot)
+{
+	if (slot < budget_count && budgets[slot].exhausted)
+	{
+		budgets[slot].exhausted = false;
+		budget_exhausted--;
+	}
+}
+
+/*
+ * Returns true once, the first time the job in slot is found past its
+ * budget. Called by the scheduler, which runs above every job, so the time
+ * each job has run is up to date.
+ */
+bool ddBudgetOverrun(dd_slot slot)
+{
+	if (slot >= budget_count || budgets[slot].exhausted || budgets[slot].used < budgets[slot].budget)
+	{
+		return false;
+	}
+
+	budgets[slot].exhausted = true;
+	budget_exhausted++;
+	return true;
+}
+
+bool ddBudgetExhausted(dd_slot slot)
+{
+	return slot < budget_count && budgets[slot].exhausted;
+}
+
+bool ddBudgetAnyExhausted(void)
+{
+	return budget_exhausted > 0;
+}
+
+uint32_t ddBudgetUsed(dd_slot slot)
+{
+	return (slot < budget_count) ? budgets[slot].used : 0;
+}
+
+/* When the running job's budget runs out, or DD_TIME_NEVER. Read with the clock interrupt masked, or from it. */
+dd_time_t ddBudgetExpiry(void)
+{
+	return budget_expiry;
+}
+
+/* Called from the clock interrupt once the expiry has passed, so it is reported once. */
+void ddBudgetExpired(void)
+{
+	budget_expiry = DD_TIME_NEVER;
+}
+
+void ddBudgetSwitchedIn(uint32_t tag)
+{
+	dd_slot slot = DD_MISS_TAG_SLOT(tag);
+
+	if (DD_MISS_TAG_CLASS(tag) != DD_MISS_CLASS_JOB || slot >= budget_count)
+	{
+		return;
+	}
+
+	dd_budget* budget = &budgets[slot];
+	dd_time_t now = ddClockNow();
+
+	budget_running = slot;
+	budget_switch_time = (uint32_t)now;
+
+	// A job already past its budget has been reported, or is about to be
+	if (!budget->exhausted && budget->used < budget->budget)
+	{
+		budget_expiry = now + (budget->budget - budget->used);
+		budget_arm();
+	}
+}
+
+void ddBudgetSwitchedOut(void)
+{
+	if (budget_running == DD_SLOT_NONE)
+	{
+		return;
+	}
+
+	budgets[budget_running].used += (uint32_t)ddClockNow() - budget_switch_time;
+	budget_running = DD_SLOT_NONE;
+	budget_expiry = DD_TIME_NEVER;
+}
+
+const char* ddBudgetPolicyName(dd_budget_policy policy)
+{
+	return (policy < DD_BUDGET_POLICY_COUNT) ? policy_names[policy] : "Unknown";
+}
@@ -0,0 +1,64 @@
+/*
+ * dd_budget.h
+ *
+ * Execution budgets for DD jobs. Each job may run for its declared
+ * execution time plus a margin for the interrupts and kernel calls charged
+ * to it. The context switch hooks charge the time a job runs to its slot,
+ * and while it runs the clock's compare event is also armed for the moment
+ * its budget runs out, so the scheduler hears of an overrun within
+ * microseconds rather than at the job's deadline. The scheduler then acts
+ * by the budget policy:
+ *
+ *   DD_BUDGET_DEMOTE   The job is mapped below every job within its budget
+ *                      and finishes in whatever time they leave it. A job
+ *                      holding a resource keeps its place until it lets go.
+ *   DD_BUDGET_SUSPEND  The job is suspended where it is, gives back its
+ *                      resources and is stopped at its deadline.
+ *   DD_BUDGET_ABORT    The job is stopped at once and moved to the overdue
+ *                      list.
+ *
+ * Jobs are found by the slot in their task tag, see dd_miss.h. Switches
+ * cost one clock read, and arming the compare event when a job comes in.
+ */
+
+#ifndef DD_BUDGET_H_
+#define DD_BUDGET_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "dd_jobs.h"
+
+typedef enum dd_budget_policy
+{
+	DD_BUDGET_DEMOTE,
+	DD_BUDGET_SUSPEND,
+	DD_BUDGET_ABORT,
+	DD_BUDGET_POLICY_COUNT
+} dd_budget_policy;
+
+/* Budget of the job in one slot. */
+typedef struct dd_budget
+{
+	uint32_t budget;		// us
+	uint32_t used;			// us run up to its last switch out
+	bool exhausted;
+} dd_budget;
+
+/* Re-arms the clock's compare event, called by the switch hook with the clock interrupt masked. */
+typedef void (*dd_budget_arm)(void);
+
+void ddBudgetInit(dd_budget* budgets, uint32_t count, dd_budget_arm arm);
+void ddBudgetStart(dd_slot slot, uint32_t budget);
+void ddBudgetStop(dd_slot slot);
+bool ddBudgetOverrun(dd_slot slot);
+bool ddBudgetExhausted(dd_slot slot);
+bool ddBudgetAnyExhausted(void);
+uint32_t ddBudgetUsed(dd_slot slot);
+dd_time_t ddBudgetExpiry(void);
+void ddBudgetExpired(void);
+void ddBudgetSwitchedIn(uint32_t tag);
+void ddBudgetSwitchedOut(void);
+const char* ddBudgetPolicyName(dd_budget_policy policy);
+
+#endif /* DD_BUDGET_H_ */
@@ -0,0 +1,112 @@
+/*
+ * dd_clock.c
+ *
+ * Microsecond time base and one-shot compare event. See dd_clock.h.
+ */
+
+#include "dd_clock.h"
+
+#ifdef HOST_BUILD
+
+#include <time.h>
+
+void ddClockInit(dd_clock_handler handler, uint32_t irq_priority)
+{
+	(void)handler;
+	(void)irq_priority;
+}
+
+dd_time_t ddClockNow(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (dd_time_t)now.tv_sec * 1000000 + (dd_time_t)now.tv_nsec / 1000;
+}
+
+#else
+
+#include "stm32f4xx.h"
+
+/* TIM2 is on APB1, which runs at HCLK / 4, and timers on a divided APB bus
+are clocked at twice the bus clock. */
+#define DD_CLOCK_TIMER_HZ		( SystemCoreClock / 2 )
+
+static dd_time_counter counter;
+static dd_clock_handler compare_handler = NULL;
+
+/* Reads the extended counter. Interrupts must be masked. */
+static inline dd_time_t ddClockRead(void)
+{
+	return ddTimeExtend(&counter, TIM2->CNT);
+}
+
+void ddClockInit(dd_clock_handler handler, uint32_t irq_priority)
+{
+	compare_handler = handler;
+
+	RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
+
+	TIM2->CR1 = 0;
+	TIM2->PSC = DD_CLOCK_TIMER_HZ / 1000000 - 1;
+	TIM2->ARR = 0xFFFFFFFF;
+	TIM2->CNT = 0;
+	TIM2->DIER = 0;
+	TIM2->EGR = TIM_EGR_UG;		// Loads the prescaler
+	TIM2->SR = 0;
+	TIM2->CR1 = TIM_CR1_CEN;
+
+	// A handler that uses the FromISR API needs a priority at or below the kernel's syscall priority
+	NVIC_SetPriority(TIM2_IRQn, irq_priority);
+	NVIC_EnableIRQ(TIM2_IRQn);
+}
+
+dd_time_t ddClockNow(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	dd_time_t now = ddClockRead();
+	__set_PRIMASK(primask);
+
+	return now;
+}
+
+void ddClockArm(dd_time_t when)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	when = ddClockArmTarget(ddClockRead(), when);
+
+	TIM2->CCR1 = (uint32_t)when;
+	TIM2->SR = ~TIM_SR_CC1IF;
+	TIM2->DIER |= TIM_DIER_CC1IE;
+
+	// A compare value the counter has already passed would not match until the next wrap
+	if (ddClockArmPassed(ddClockRead(), when))
+	{
+		TIM2->EGR = TIM_EGR_CC1G;
+	}
+
+	__set_PRIMASK(primask);
+}
+
+void ddClockDisarm(void)
+{
+	TIM2->DIER &= ~TIM_DIER_CC1IE;
+}
+
+void TIM2_IRQHandler(void)
+{
+	if (TIM2->SR & TIM_SR_CC1IF)
+	{
+		TIM2->SR = ~TIM_SR_CC1IF;
+		TIM2->DIER &= ~TIM_DIER_CC1IE;
+
+		if (compare_handler != NULL)
+		{
+			compare_handler();
+		}
+	}
+}
+
+#endif /* HOST_BUILD */
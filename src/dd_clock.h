@@ -0,0 +1,47 @@
+/*
+ * dd_clock.h
+ *
+ * Microsecond time base for the DD scheduler. On the target TIM2 runs as a
+ * free-running 32-bit counter at 1 MHz, extended to 64 bits in software,
+ * and its channel 1 compare raises a one-shot interrupt at the next
+ * scheduling event (a generator release or the earliest active deadline),
+ * so scheduling decisions are not limited to the kernel tick. The host
+ * build reads CLOCK_MONOTONIC instead and has no compare event.
+ */
+
+#ifndef DD_CLOCK_H_
+#define DD_CLOCK_H_
+
+#include "dd_jobs.h"
+
+typedef void (*dd_clock_handler)(void);
+
+/* The compare register is 32 bits, so events further away than this are
+armed in steps. This also makes sure the counter is read at least twice per
+wrap, which the 64-bit extension relies on. */
+#define DD_CLOCK_MAX_ARM_US		( 1UL << 31 )
+
+/* Where ddClockArm() sets the compare for an event at when, with the clock
+read at now: the event itself, or the furthest step it may arm. */
+static inline dd_time_t ddClockArmTarget(dd_time_t now, dd_time_t when)
+{
+	return ddTimeBefore(now + DD_CLOCK_MAX_ARM_US, when) ? now + DD_CLOCK_MAX_ARM_US : when;
+}
+
+/* Whether the counter, read at now after the compare was set to target, has
+already passed it. The compare would then not match until the next wrap, so
+ddClockArm() forces the event instead. */
+static inline bool ddClockArmPassed(dd_time_t now, dd_time_t target)
+{
+	return !ddTimeBefore(now, target);
+}
+
+void ddClockInit(dd_clock_handler handler, uint32_t irq_priority);
+dd_time_t ddClockNow(void);
+
+#ifndef HOST_BUILD
+void ddClockArm(dd_time_t when);
+void ddClockDisarm(void);
+#endif
+
+#endif /* DD_CLOCK_H_ */
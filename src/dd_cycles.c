@@ -0,0 +1,82 @@
+/*
+ * dd_cycles.c
+ *
+ * Hot path cycle counters. See dd_cycles.h.
+ */
+
+#include "dd_cycles.h"
+
+#ifndef DD_RELEASE
+
+#include <stdio.h>
+
+#define DD_CYCLE_PROBE_NAME(probe, name)	name,
+
+static const char* const probe_names[DD_CYCLE_PROBE_COUNT] =
+{
+	DD_CYCLE_PROBE_TABLE(DD_CYCLE_PROBE_NAME)
+};
+
+dd_cycle_stats dd_cycle_probes[DD_CYCLE_PROBE_COUNT];
+
+void ddCyclesInit(void)
+{
+#ifndef HOST_BUILD
+	// Reset_Handler normally starts the counter for the boot profile already
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+	for (uint32_t i = 0; i < DD_CYCLE_PROBE_COUNT; i++)
+	{
+		dd_cycle_probes[i].count = 0;
+		dd_cycle_probes[i].min = UINT32_MAX;
+		dd_cycle_probes[i].max = 0;
+		dd_cycle_probes[i].sum = 0;
+	}
+}
+
+/* Context switch hooks, see FreeRTOSConfig.h. They time the kernel choosing
+the next task, not the register save and restore around it. */
+static uint32_t switch_start;
+
+void ddCyclesSwitchedOut(void)
+{
+	switch_start = ddCyclesNow();
+}
+
+void ddCyclesSwitchedIn(void)
+{
+	ddCyclesRecord(DD_CYCLES_SWITCH, ddCyclesNow() - switch_start);
+}
+
+/* Copies a probe's counters. Returns false if it has not run yet. */
+bool ddCyclesGet(dd_cycle_probe probe, dd_cycle_stats* stats)
+{
+	*stats = dd_cycle_probes[probe];
+	return stats->count > 0;
+}
+
+void ddCyclesPrint(void)
+{
+#ifdef HOST_BUILD
+	const char* unit = "ns";
+#else
+	const char* unit = "cycles";
+#endif
+
+	for (uint32_t i = 0; i < DD_CYCLE_PROBE_COUNT; i++)
+	{
+		dd_cycle_stats stats;
+
+		if (!ddCyclesGet((dd_cycle_probe)i, &stats))
+		{
+			continue;
+		}
+
+		printf("Cycles %s: Count = %u, Min = %u, Avg = %u, Max = %u %s\n", probe_names[i], (unsigned int)stats.count,
+				(unsigned int)stats.min, (unsigned int)(stats.sum / stats.count), (unsigned int)stats.max, unit);
+	}
+}
+
+#endif /* DD_RELEASE */
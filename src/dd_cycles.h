@@ -0,0 +1,106 @@
+/*
+ * dd_cycles.h
+ *
+ * Cycle counts for the scheduler's hot paths. Each probe in
+ * DD_CYCLE_PROBE_TABLE keeps the count, minimum, maximum and sum of the
+ * cycles spent between its DD_CYCLES_BEGIN and DD_CYCLES_END. The target
+ * reads the DWT cycle counter, the host build reads CLOCK_MONOTONIC in
+ * nanoseconds instead.
+ *
+ * Building with -DDD_RELEASE compiles every probe out: the macros expand to
+ * nothing and the counters are not defined.
+ *
+ * A probe is updated from one context only (the scheduler task, or the
+ * context switch for DD_CYCLES_SWITCH), or with interrupts masked
+ * (DD_CYCLES_TRACE), so updates take no lock; a report can see one probe's
+ * fields mid-update.
+ */
+
+#ifndef DD_CYCLES_H_
+#define DD_CYCLES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DD_CYCLE_PROBE_TABLE(DD_PROBE) \
+	DD_PROBE( DD_CYCLES_INSERT,		"taskListInsert"  ) \
+	DD_PROBE( DD_CYCLES_REMOVE,		"taskListRemove"  ) \
+	DD_PROBE( DD_CYCLES_CLEANUP,	"taskListCleanup" ) \
+	DD_PROBE( DD_CYCLES_SWITCH,		"Context Switch"  ) \
+	DD_PROBE( DD_CYCLES_TRACE,		"Trace Event"     )
+
+#define DD_CYCLE_PROBE_ENUM(probe, name)	probe,
+
+typedef enum dd_cycle_probe
+{
+	DD_CYCLE_PROBE_TABLE(DD_CYCLE_PROBE_ENUM)
+	DD_CYCLE_PROBE_COUNT
+} dd_cycle_probe;
+
+typedef struct dd_cycle_stats
+{
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+} dd_cycle_stats;
+
+#ifdef DD_RELEASE
+
+#define DD_CYCLES_BEGIN(probe)
+#define DD_CYCLES_END(probe)
+
+static inline void ddCyclesInit(void) {}
+static inline bool ddCyclesGet(dd_cycle_probe probe, dd_cycle_stats* stats) { (void)probe; (void)stats; return false; }
+static inline void ddCyclesPrint(void) {}
+
+#else
+
+#ifdef HOST_BUILD
+
+#include <time.h>
+
+static inline uint32_t ddCyclesNow(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)((uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec);
+}
+
+#else
+
+#include "stm32f4xx.h"
+
+static inline uint32_t ddCyclesNow(void)
+{
+	return DWT->CYCCNT;
+}
+
+#endif /* HOST_BUILD */
+
+extern dd_cycle_stats dd_cycle_probes[DD_CYCLE_PROBE_COUNT];
+
+/* Wraps of the 32-bit counter cancel out in the subtraction. */
+static inline void ddCyclesRecord(dd_cycle_probe probe, uint32_t cycles)
+{
+	dd_cycle_stats* stats = &dd_cycle_probes[probe];
+
+	stats->count++;
+	stats->sum += cycles;
+	if (cycles < stats->min) stats->min = cycles;
+	if (cycles > stats->max) stats->max = cycles;
+}
+
+#define DD_CYCLES_BEGIN(probe)		uint32_t probe##_start = ddCyclesNow()
+#define DD_CYCLES_END(probe)		ddCyclesRecord(probe, ddCyclesNow() - probe##_start)
+
+void ddCyclesInit(void);
+bool ddCyclesGet(dd_cycle_probe probe, dd_cycle_stats* stats);
+void ddCyclesPrint(void);
+void ddCyclesSwitchedOut(void);
+void ddCyclesSwitchedIn(void);
+
+#endif /* DD_RELEASE */
+
+#endif /* DD_CYCLES_H_ */
@@ -0,0 +1,198 @@
+/*
+ * dd_heap.c
+ *
+ * FreeRTOS heap telemetry. See dd_heap.h.
+ */
+
+#include <stdio.h>
+
+#include "dd_heap.h"
+
+typedef struct dd_heap_block
+{
+	void* address;			// NULL for an unused entry
+	uint16_t size;
+	uint8_t site;
+} dd_heap_block;
+
+static const char* const site_names[DD_HEAP_SITE_COUNT] = { "Kernel", "Job Records", "Task Stacks" };
+
+/* The trace hooks run inside the allocator with the scheduler suspended, and
+these are only written with it suspended as well. */
+static dd_heap_block heap_blocks[DD_HEAP_MAX_BLOCKS];
+static dd_heap_stats heap_stats = { configTOTAL_HEAP_SIZE, configTOTAL_HEAP_SIZE, configTOTAL_HEAP_SIZE, 0, 0, 0,
+									DD_HEAP_SITE_KERNEL, 0, { { 0 } } };
+static dd_heap_site heap_site = DD_HEAP_SITE_KERNEL;
+static bool heap_probing = false;
+
+void* ddHeapAlloc(dd_heap_site site, size_t size)
+{
+	void* block;
+
+	vTaskSuspendAll();
+	heap_site = site;
+	block = pvPortMalloc(size);
+	heap_site = DD_HEAP_SITE_KERNEL;
+	( void ) xTaskResumeAll();
+
+	return block;
+}
+
+BaseType_t ddHeapTaskCreate(TaskFunction_t func, const char* name, uint16_t stack_depth, void* parameters,
+							UBaseType_t priority, TaskHandle_t* handle)
+{
+	BaseType_t created;
+
+	// A higher priority task created here only runs once the scheduler is resumed
+	vTaskSuspendAll();
+	heap_site = DD_HEAP_SITE_TASK;
+	created = xTaskCreate(func, name, stack_depth, parameters, priority, handle);
+	heap_site = DD_HEAP_SITE_KERNEL;
+	( void ) xTaskResumeAll();
+
+	return created;
+}
+
+void ddHeapTraceMalloc(void* block, size_t size)
+{
+	dd_heap_site_stats* site = &(heap_stats.sites[heap_site]);
+
+	if (heap_probing)
+	{
+		return;
+	}
+
+	if (block == NULL)
+	{
+		site->failures++;
+		heap_stats.failures++;
+		heap_stats.last_failed_site = heap_site;
+		heap_stats.last_failed_size = size;
+		return;
+	}
+
+	heap_stats.free_bytes = xPortGetFreeHeapSize();
+	if (heap_stats.free_bytes < heap_stats.min_free_bytes) heap_stats.min_free_bytes = heap_stats.free_bytes;
+
+	for (uint32_t i = 0; i < DD_HEAP_MAX_BLOCKS; i++)
+	{
+		if (heap_blocks[i].address == NULL)
+		{
+			heap_blocks[i].address = block;
+			heap_blocks[i].size = (uint16_t)size;
+			heap_blocks[i].site = (uint8_t)heap_site;
+
+			site->allocs++;
+			site->live_blocks++;
+			site->live_bytes += size;
+			if (site->live_bytes > site->peak_bytes) site->peak_bytes = site->live_bytes;
+			return;
+		}
+	}
+
+	heap_stats.untracked++;
+}
+
+void ddHeapTraceFree(void* block, size_t size)
+{
+	( void ) size;
+
+	if (heap_probing)
+	{
+		return;
+	}
+
+	heap_stats.free_bytes = xPortGetFreeHeapSize();
+
+	for (uint32_t i = 0; i < DD_HEAP_MAX_BLOCKS; i++)
+	{
+		if (heap_blocks[i].address == block)
+		{
+			dd_heap_site_stats* site = &(heap_stats.sites[heap_blocks[i].site]);
+
+			site->frees++;
+			site->live_blocks--;
+			site->live_bytes -= heap_blocks[i].size;
+			heap_blocks[i].address = NULL;
+			return;
+		}
+	}
+}
+
+/*
+ * Finds the largest block that can be allocated by bisecting on trial
+ * allocations, and updates the fragmentation index from it.
+ */
+void ddHeapSample(void)
+{
+	size_t low = 0;
+	size_t high;
+
+	vTaskSuspendAll();
+	heap_probing = true;
+
+	high = xPortGetFreeHeapSize();
+	while (low < high)
+	{
+		size_t mid = low + (high - low + 1) / 2;
+		void* block = pvPortMalloc(mid);
+
+		if (block != NULL)
+		{
+			vPortFree(block);
+			low = mid;
+		}
+		else
+		{
+			high = mid - 1;
+		}
+	}
+
+	heap_probing = false;
+	heap_stats.free_bytes = xPortGetFreeHeapSize();
+	heap_stats.largest_free = low;
+	heap_stats.fragmentation = (heap_stats.free_bytes == 0) ? 0 : (uint32_t)(1000 - (low * 1000) / heap_stats.free_bytes);
+	( void ) xTaskResumeAll();
+}
+
+/* True while ddHeapSample() is making trial allocations that may fail. */
+bool ddHeapProbing(void)
+{
+	return heap_probing;
+}
+
+void ddHeapGetStats(dd_heap_stats* stats)
+{
+	vTaskSuspendAll();
+	*stats = heap_stats;
+	( void ) xTaskResumeAll();
+}
+
+void ddHeapPrintStats(void)
+{
+	dd_heap_stats stats;
+
+	ddHeapGetStats(&stats);
+
+	printf("Heap: Free = %u, Min Free = %u, Largest Block = %u, Fragmentation = %u.%u%%, Failures = %u\n",
+			(unsigned int)stats.free_bytes, (unsigned int)stats.min_free_bytes, (unsigned int)stats.largest_free,
+			(unsigned int)(stats.fragmentation / 10), (unsigned int)(stats.fragmentation % 10), (unsigned int)stats.failures);
+
+	for (uint32_t i = 0; i < DD_HEAP_SITE_COUNT; i++)
+	{
+		printf("Heap %s: Live = %u B in %u, Peak = %u B, Allocs = %u, Frees = %u, Failures = %u\n", site_names[i],
+				(unsigned int)stats.sites[i].live_bytes, (unsigned int)stats.sites[i].live_blocks,
+				(unsigned int)stats.sites[i].peak_bytes, (unsigned int)stats.sites[i].allocs,
+				(unsigned int)stats.sites[i].frees, (unsigned int)stats.sites[i].failures);
+	}
+
+	if (stats.failures > 0)
+	{
+		printf("Heap: last failure was %u B for %s\n", (unsigned int)stats.last_failed_size, site_names[stats.last_failed_site]);
+	}
+
+	if (stats.untracked > 0)
+	{
+		printf("Heap: %u blocks were not tracked, raise DD_HEAP_MAX_BLOCKS\n", (unsigned int)stats.untracked);
+	}
+}
@@ -0,0 +1,75 @@
+/*
+ * dd_heap.h
+ *
+ * Telemetry for the FreeRTOS heap. The kernel's traceMALLOC and traceFREE
+ * hooks (see FreeRTOSConfig.h) report every block to ddHeapTraceMalloc()
+ * and ddHeapTraceFree(), which keep a table of the live blocks and charge
+ * each one to the call site that allocated it. Allocations made through
+ * ddHeapAlloc() and ddHeapTaskCreate() are charged to the site passed in,
+ * everything else (queues, semaphores, the timer service) to the kernel.
+ *
+ * The largest free block is found by probing the heap with trial
+ * allocations, which takes a few microseconds with the scheduler suspended,
+ * so it is only sampled from a background job (see ddHeapSample()). Probes
+ * that fail reach vApplicationMallocFailedHook(), which checks
+ * ddHeapProbing() so that only real failures stop the system.
+ */
+
+#ifndef DD_HEAP_H_
+#define DD_HEAP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../FreeRTOS_Source/include/FreeRTOS.h"
+#include "../FreeRTOS_Source/include/task.h"
+
+typedef enum dd_heap_site
+{
+	DD_HEAP_SITE_KERNEL,		// Anything not allocated through this module
+	DD_HEAP_SITE_JOB_RECORD,	// createTask()
+	DD_HEAP_SITE_TASK,			// xTaskCreate(): TCB and stack
+	DD_HEAP_SITE_COUNT
+} dd_heap_site;
+
+/* Live blocks tracked at once. Blocks beyond this are counted as untracked
+and are not charged to a site when freed. */
+#define DD_HEAP_MAX_BLOCKS		64
+
+typedef struct dd_heap_site_stats
+{
+	uint32_t live_bytes;		// Including the allocator's block header
+	uint32_t live_blocks;
+	uint32_t peak_bytes;
+	uint32_t allocs;
+	uint32_t frees;
+	uint32_t failures;
+} dd_heap_site_stats;
+
+typedef struct dd_heap_stats
+{
+	size_t free_bytes;
+	size_t min_free_bytes;		// Lowest free size seen after any allocation
+	size_t largest_free;		// Largest allocation that succeeded at the last sample
+	uint32_t fragmentation;		// 1000 - 1000 * largest_free / free_bytes, at the last sample
+	uint32_t untracked;
+	uint32_t failures;
+	dd_heap_site last_failed_site;
+	size_t last_failed_size;
+	dd_heap_site_stats sites[DD_HEAP_SITE_COUNT];
+} dd_heap_stats;
+
+void* ddHeapAlloc(dd_heap_site site, size_t size);
+BaseType_t ddHeapTaskCreate(TaskFunction_t func, const char* name, uint16_t stack_depth, void* parameters,
+							UBaseType_t priority, TaskHandle_t* handle);
+
+void ddHeapTraceMalloc(void* block, size_t size);
+void ddHeapTraceFree(void* block, size_t size);
+
+void ddHeapSample(void);
+bool ddHeapProbing(void);
+void ddHeapGetStats(dd_heap_stats* stats);
+void ddHeapPrintStats(void);
+
+#endif /* DD_HEAP_H_ */
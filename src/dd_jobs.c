@@ -0,0 +1,160 @@
+/*
+ * dd_jobs.c
+ *
+ * Job slot table and slot lists. See dd_jobs.h.
+ */
+
+#include "dd_jobs.h"
+
+void ddJobTableInit(dd_job_table* table)
+{
+	table->free_head = DD_SLOT_NONE;
+	table->free_count = 0;
+
+	// Build the free list so that slot 0 is handed out first
+	for (uint32_t i = table->capacity; i-- > 0; )
+	{
+		table->deadline[i] = 0;
+		table->handle[i] = NULL;
+		table->t_class[i] = 0;
+		table->prev[i] = DD_SLOT_NONE;
+		table->linked[i] = 0;
+		table->next[i] = table->free_head;
+		table->free_head = (dd_slot)i;
+		table->free_count++;
+	}
+}
+
+dd_slot ddJobAlloc(dd_job_table* table)
+{
+	dd_slot slot = table->free_head;
+
+	if (slot == DD_SLOT_NONE)
+	{
+		return DD_SLOT_NONE;
+	}
+
+	table->free_head = table->next[slot];
+	table->free_count--;
+	table->next[slot] = DD_SLOT_NONE;
+	table->prev[slot] = DD_SLOT_NONE;
+	table->linked[slot] = 0;
+
+	return slot;
+}
+
+void ddJobFree(dd_job_table* table, dd_slot slot)
+{
+	table->handle[slot] = NULL;
+	table->next[slot] = table->free_head;
+	table->prev[slot] = DD_SLOT_NONE;
+	table->free_head = slot;
+	table->free_count++;
+}
+
+void ddSlotListInit(dd_slot_list* list)
+{
+	list->list_length = 0;
+	list->list_head = DD_SLOT_NONE;
+	list->list_tail = DD_SLOT_NONE;
+}
+
+static inline bool ddSlotBefore(const dd_job_table* table, dd_slot a, dd_slot b)
+{
+	// Earlier deadline first, ties broken by class
+	return ddTimeBefore(table->deadline[a], table->deadline[b]) ||
+		   ((table->deadline[a] == table->deadline[b]) && (table->t_class[a] < table->t_class[b]));
+}
+
+static void ddSlotListInsertAfter(dd_job_table* table, dd_slot_list* list, dd_slot after, dd_slot slot)
+{
+	dd_slot before = (after == DD_SLOT_NONE) ? list->list_head : table->next[after];
+
+	table->prev[slot] = after;
+	table->next[slot] = before;
+
+	if (after == DD_SLOT_NONE) list->list_head = slot;
+	else table->next[after] = slot;
+
+	if (before == DD_SLOT_NONE) list->list_tail = slot;
+	else table->prev[before] = slot;
+
+	table->linked[slot] = 1;
+	(list->list_length)++;
+}
+
+void ddSlotListInsertOrdered(dd_job_table* table, dd_slot_list* list, dd_slot slot)
+{
+	// New jobs usually have the latest deadline, so search from the tail
+	dd_slot after = list->list_tail;
+
+	while (after != DD_SLOT_NONE && ddSlotBefore(table, slot, after))
+	{
+		after = table->prev[after];
+	}
+
+	ddSlotListInsertAfter(table, list, after, slot);
+}
+
+void ddSlotListPushBack(dd_job_table* table, dd_slot_list* list, dd_slot slot)
+{
+	ddSlotListInsertAfter(table, list, list->list_tail, slot);
+}
+
+void ddSlotListRemove(dd_job_table* table, dd_slot_list* list, dd_slot slot)
+{
+	dd_slot prev = table->prev[slot];
+	dd_slot next = table->next[slot];
+
+	if (prev == DD_SLOT_NONE) list->list_head = next;
+	else table->next[prev] = next;
+
+	if (next == DD_SLOT_NONE) list->list_tail = prev;
+	else table->prev[next] = prev;
+
+	table->next[slot] = DD_SLOT_NONE;
+	table->prev[slot] = DD_SLOT_NONE;
+	table->linked[slot] = 0;
+	(list->list_length)--;
+}
+
+bool ddSlotListContains(const dd_job_table* table, const dd_slot_list* list, dd_slot slot)
+{
+	for (dd_slot cur = list->list_head; cur != DD_SLOT_NONE; cur = table->next[cur])
+	{
+		if (cur == slot)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Moves every job whose deadline is before now from the front of a deadline
+ * ordered list to the back of another, oldest first, calling expired for
+ * each one. Returns the number of jobs moved.
+ */
+uint32_t ddSlotListExpire(dd_job_table* table, dd_slot_list* from, dd_slot_list* to, dd_time_t now,
+						  dd_slot_visit expired, void* context)
+{
+	uint32_t moved = 0;
+
+	// The list is in deadline order, so stop at the first job that is still on time
+	while (from->list_head != DD_SLOT_NONE && ddTimeBefore(table->deadline[from->list_head], now))
+	{
+		dd_slot slot = from->list_head;
+
+		ddSlotListRemove(table, from, slot);
+		ddSlotListPushBack(table, to, slot);
+		moved++;
+
+		if (expired != NULL)
+		{
+			expired(slot, context);
+		}
+	}
+
+	return moved;
+}
@@ -0,0 +1,110 @@
+/*
+ * dd_jobs.h
+ *
+ * Job slot table for the DD scheduler. The keys that the scheduling scans
+ * read (deadline, class, task handle and the list links) are kept in
+ * separate arrays indexed by job slot, so walking a list streams through a
+ * few small contiguous arrays instead of hopping between malloc'd dd_task
+ * records. The dd_task records keep the cold metadata and the slot number.
+ *
+ * Lists are doubly linked through the next/prev arrays. Free slots are kept
+ * on a free list threaded through the next array.
+ *
+ * No FreeRTOS dependencies, so the host build can benchmark it directly.
+ */
+
+#ifndef DD_JOBS_H_
+#define DD_JOBS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef uint16_t dd_slot;
+
+/* Monotonic 64-bit time in microseconds, see dd_clock.h. */
+typedef uint64_t dd_time_t;
+
+/* Marks an event that is not scheduled. Compare against it explicitly, the
+wrap-safe comparisons do not order it after other times. */
+#define DD_TIME_NEVER	( (dd_time_t)UINT64_MAX )
+
+/* Extends a wrapping 32-bit microsecond counter to dd_time_t. */
+typedef struct dd_time_counter
+{
+	uint32_t last;		// Last raw count seen
+	uint32_t high;		// Number of times the raw count has wrapped
+} dd_time_counter;
+
+#define DD_SLOT_NONE	( (dd_slot)0xFFFF )
+
+/*
+ * Returns the 64-bit count for a raw 32-bit count. The raw count must be
+ * read at least once per wrap, and callers must serialise access to the
+ * counter.
+ */
+static inline dd_time_t ddTimeExtend(dd_time_counter* counter, uint32_t raw)
+{
+	if (raw < counter->last)
+	{
+		counter->high++;
+	}
+
+	counter->last = raw;
+	return ((dd_time_t)counter->high << 32) | raw;
+}
+
+/* Wrap-safe a < b, for times less than 2^63 us apart. */
+static inline bool ddTimeBefore(dd_time_t a, dd_time_t b)
+{
+	return (int64_t)(a - b) < 0;
+}
+
+typedef struct dd_job_table
+{
+	uint32_t capacity;
+	dd_time_t* deadline;
+	void** handle;
+	uint8_t* t_class;
+	dd_slot* next;
+	dd_slot* prev;
+	uint8_t* linked;		// Non-zero while the slot is on a list
+	dd_slot free_head;
+	uint32_t free_count;
+} dd_job_table;
+
+typedef struct dd_slot_list
+{
+	uint32_t list_length;
+	dd_slot list_head;
+	dd_slot list_tail;
+} dd_slot_list;
+
+/* Defines a statically allocated job table called name. */
+#define DD_JOB_TABLE_DEFINE(name, slots) \
+	static dd_time_t name##_deadline[slots]; \
+	static void* name##_handle[slots]; \
+	static uint8_t name##_class[slots]; \
+	static dd_slot name##_next[slots]; \
+	static dd_slot name##_prev[slots]; \
+	static uint8_t name##_linked[slots]; \
+	static dd_job_table name = { (slots), name##_deadline, name##_handle, name##_class, \
+								 name##_next, name##_prev, name##_linked, DD_SLOT_NONE, 0 }
+
+void ddJobTableInit(dd_job_table* table);
+dd_slot ddJobAlloc(dd_job_table* table);
+void ddJobFree(dd_job_table* table, dd_slot slot);
+
+void ddSlotListInit(dd_slot_list* list);
+void ddSlotListInsertOrdered(dd_job_table* table, dd_slot_list* list, dd_slot slot);
+void ddSlotListPushBack(dd_job_table* table, dd_slot_list* list, dd_slot slot);
+void ddSlotListRemove(dd_job_table* table, dd_slot_list* list, dd_slot slot);
+bool ddSlotListContains(const dd_job_table* table, const dd_slot_list* list, dd_slot slot);
+
+/* Called for each job ddSlotListExpire moves. */
+typedef void (*dd_slot_visit)(dd_slot slot, void* context);
+
+uint32_t ddSlotListExpire(dd_job_table* table, dd_slot_list* from, dd_slot_list* to, dd_time_t now,
+						  dd_slot_visit expired, void* context);
+
+#endif /* DD_JOBS_H_ */
@@ -0,0 +1,245 @@
+/*
+ * dd_jobs_bench.c
+ *
+ * Host benchmark for the job slot table (host build only). Compares list
+ * walks over the slot table from dd_jobs.c with the same walks over the
+ * previous layout: malloc'd dd_task records linked through next/prev
+ * pointers. Each run builds an ordered list of jobs with random deadlines,
+ * then repeats the two scans the scheduler does most: a full walk summing
+ * the deadlines (slack computation) and churn at the head (remove the
+ * earliest job, reinsert it with a later deadline).
+ *
+ * Usage: dd_jobs_bench [soa|aos] [jobs] [passes]
+ * With no mode both layouts are run at 1000 and 10000 jobs. Give one mode to
+ * compare them under perf stat -e cache-misses,cycles. The checksum only
+ * keeps the walks from being optimised away; ties are ordered differently
+ * by the two layouts, so it differs between them.
+ */
+
+#ifdef HOST_BUILD
+
+#include "dd_jobs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* The dd_task record as it was before the split, with the same field sizes
+as on the target plus the host pointer width. */
+typedef struct fat_task
+{
+	void* t_handle;
+	void* task_func;
+	uint32_t type;
+	uint32_t t_class;
+	uint32_t task_id;
+	const char* name;
+	uint32_t execution_time;
+	uint32_t executed_time;
+	dd_time_t release_time;
+	dd_time_t absolute_deadline;
+	dd_time_t completion_time;
+	void* aperiodic_timer;
+	struct fat_task* next;
+	struct fat_task* prev;
+} fat_task;
+
+typedef struct fat_list
+{
+	uint32_t list_length;
+	fat_task* list_head;
+	fat_task* list_tail;
+} fat_list;
+
+static uint32_t benchRandom(uint32_t* state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+static double benchNowSeconds(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+/*-------------------------- Pointer List -----------------------------------*/
+
+static void fatListInsert(fat_list* list, fat_task* new_task)
+{
+	fat_task* cur = list->list_tail;
+
+	while (cur != NULL && cur->absolute_deadline > new_task->absolute_deadline)
+	{
+		cur = cur->prev;
+	}
+
+	new_task->prev = cur;
+	new_task->next = (cur == NULL) ? list->list_head : cur->next;
+
+	if (new_task->next != NULL) new_task->next->prev = new_task;
+	else list->list_tail = new_task;
+
+	if (cur != NULL) cur->next = new_task;
+	else list->list_head = new_task;
+
+	list->list_length++;
+}
+
+static fat_task* fatListRemoveFront(fat_list* list)
+{
+	fat_task* head = list->list_head;
+
+	list->list_head = head->next;
+	if (list->list_head != NULL) list->list_head->prev = NULL;
+	else list->list_tail = NULL;
+
+	head->next = NULL;
+	head->prev = NULL;
+	list->list_length--;
+	return head;
+}
+
+static uint64_t benchFat(uint32_t jobs, uint32_t passes, uint32_t seed)
+{
+	fat_list list = { 0, NULL, NULL };
+	fat_task** records = (fat_task**)malloc(jobs * sizeof(fat_task*));
+	void** spacers = (void**)malloc(jobs * sizeof(void*));
+	uint64_t checksum = 0;
+
+	// Interleave other allocations, as the FreeRTOS heap does with stacks and TCBs
+	for (uint32_t i = 0; i < jobs; i++)
+	{
+		records[i] = (fat_task*)calloc(1, sizeof(fat_task));
+		spacers[i] = malloc(64 + benchRandom(&seed) % 256);
+		records[i]->task_id = i;
+		records[i]->absolute_deadline = benchRandom(&seed) % (jobs * 16);
+		fatListInsert(&list, records[i]);
+	}
+
+	for (uint32_t pass = 0; pass < passes; pass++)
+	{
+		for (fat_task* cur = list.list_head; cur != NULL; cur = cur->next)
+		{
+			checksum += cur->absolute_deadline;
+		}
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			fat_task* head = fatListRemoveFront(&list);
+			head->absolute_deadline += jobs * 16;
+			fatListInsert(&list, head);
+		}
+	}
+
+	for (uint32_t i = 0; i < jobs; i++)
+	{
+		free(records[i]);
+		free(spacers[i]);
+	}
+
+	free(records);
+	free(spacers);
+	return checksum;
+}
+
+/*-------------------------- Slot Table -------------------------------------*/
+
+static uint64_t benchSlots(uint32_t jobs, uint32_t passes, uint32_t seed)
+{
+	dd_job_table table;
+	dd_slot_list list;
+	uint64_t checksum = 0;
+
+	table.capacity = jobs;
+	table.deadline = (dd_time_t*)malloc(jobs * sizeof(dd_time_t));
+	table.handle = (void**)malloc(jobs * sizeof(void*));
+	table.t_class = (uint8_t*)malloc(jobs);
+	table.next = (dd_slot*)malloc(jobs * sizeof(dd_slot));
+	table.prev = (dd_slot*)malloc(jobs * sizeof(dd_slot));
+	table.linked = (uint8_t*)malloc(jobs);
+
+	ddJobTableInit(&table);
+	ddSlotListInit(&list);
+
+	for (uint32_t i = 0; i < jobs; i++)
+	{
+		dd_slot slot = ddJobAlloc(&table);
+		table.deadline[slot] = benchRandom(&seed) % (jobs * 16);
+		table.handle[slot] = NULL;
+		table.t_class[slot] = 0;
+		ddSlotListInsertOrdered(&table, &list, slot);
+	}
+
+	for (uint32_t pass = 0; pass < passes; pass++)
+	{
+		for (dd_slot cur = list.list_head; cur != DD_SLOT_NONE; cur = table.next[cur])
+		{
+			checksum += table.deadline[cur];
+		}
+
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			dd_slot head = list.list_head;
+			ddSlotListRemove(&table, &list, head);
+			table.deadline[head] += jobs * 16;
+			ddSlotListInsertOrdered(&table, &list, head);
+		}
+	}
+
+	free(table.deadline);
+	free(table.handle);
+	free(table.t_class);
+	free(table.next);
+	free(table.prev);
+	free(table.linked);
+	return checksum;
+}
+
+static void benchRun(bool use_slots, uint32_t jobs, uint32_t passes)
+{
+	double start = benchNowSeconds();
+	uint64_t checksum = use_slots ? benchSlots(jobs, passes, 12345) : benchFat(jobs, passes, 12345);
+	double elapsed = benchNowSeconds() - start;
+
+	printf("%-6s %7u %8u %12.1f %20llu\n", use_slots ? "soa" : "aos", (unsigned int)jobs, (unsigned int)passes,
+			elapsed * 1e9 / ((double)jobs * passes), (unsigned long long)checksum);
+}
+
+int main(int argc, char** argv)
+{
+	static const uint32_t job_counts[] = {1000, 10000};
+
+	printf("%-6s %7s %8s %12s %20s\n", "layout", "jobs", "passes", "ns/job/pass", "checksum");
+
+	if (argc > 1)
+	{
+		// A slot index must fit below DD_SLOT_NONE
+		uint32_t jobs = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : 10000;
+		uint32_t passes = (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 10) : 2000;
+
+		if (jobs == 0 || jobs >= DD_SLOT_NONE || (strcmp(argv[1], "soa") != 0 && strcmp(argv[1], "aos") != 0))
+		{
+			printf("Usage: %s [soa|aos] [jobs < %u] [passes]\n", argv[0], (unsigned int)DD_SLOT_NONE);
+			return 1;
+		}
+
+		benchRun(strcmp(argv[1], "soa") == 0, jobs, passes);
+		return 0;
+	}
+
+	for (uint32_t i = 0; i < sizeof(job_counts) / sizeof(job_counts[0]); i++)
+	{
+		uint32_t passes = 20000000 / job_counts[i];
+		benchRun(false, job_counts[i], passes);
+		benchRun(true, job_counts[i], passes);
+	}
+
+	return 0;
+}
+
+#endif /* HOST_BUILD */
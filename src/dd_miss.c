@@ -0,0 +1,345 @@
+/*
+ * dd_miss.c
+ *
+ * Deadline miss analysis. See dd_miss.h.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../FreeRTOS_Source/include/FreeRTOS.h"
+#include "../FreeRTOS_Source/include/task.h"
+
+#include "dd_clock.h"
+#include "dd_miss.h"
+
+static const char* const cause_names[DD_MISS_CAUSE_COUNT] = { "Overload", "Priority Inversion", "Scheduler Overhead", "Timer Lag" };
+
+/* Updated by the switch hook with interrupts masked. */
+static uint32_t miss_busy[DD_MISS_CLASS_COUNT];
+static uint32_t miss_switch_time;
+
+static dd_miss_window* miss_windows = NULL;
+static uint32_t miss_window_count = 0;
+static const dd_job_table* miss_table = NULL;
+static const dd_slot_list* miss_active = NULL;
+
+/* Written by the scheduler only, read by the monitor with the scheduler suspended. */
+static dd_miss_report miss_reports[DD_MISS_REPORT_LENGTH];
+static uint32_t miss_reports_written = 0;
+static uint32_t miss_reports_printed = 0;
+static dd_miss_tally miss_tallies[DD_MISS_MAX_GENERATORS];
+
+static inline dd_miss_class ddMissClass(uint32_t tag)
+{
+	uint32_t cls = DD_MISS_TAG_CLASS(tag);
+
+	return (cls < DD_MISS_CLASS_COUNT) ? (dd_miss_class)cls : DD_MISS_CLASS_BACKGROUND;
+}
+
+/* Copies the class totals, counting the running task up to now. Call in a critical section. */
+static void ddMissSnapshot(uint32_t* busy, uint32_t* now)
+{
+	*now = (uint32_t)ddClockNow();
+	memcpy(busy, miss_busy, sizeof(miss_busy));
+	busy[ddMissClass((uint32_t)xTaskGetApplicationTaskTag(NULL))] += *now - miss_switch_time;
+}
+
+void ddMissInit(dd_miss_window* windows, uint32_t count, const dd_job_table* table, const dd_slot_list* active)
+{
+	memset(windows, 0, count * sizeof(dd_miss_window));
+	memset(miss_busy, 0, sizeof(miss_busy));
+	memset(miss_tallies, 0, sizeof(miss_tallies));
+
+	miss_windows = windows;
+	miss_window_count = count;
+	miss_table = table;
+	miss_active = active;
+	miss_switch_time = (uint32_t)ddClockNow();
+}
+
+/* Gives a task its class, keeping the trace ID in the low half of its tag. A NULL handle is the calling task. */
+void ddMissSetClass(void* handle, dd_miss_class cls, dd_slot slot)
+{
+	uint32_t tag = (uint32_t)xTaskGetApplicationTaskTag((TaskHandle_t)handle);
+
+	tag = (tag & 0xFFFF) | ((uint32_t)cls << 16) | ((uint32_t)(slot & 0xFF) << 24);
+	vTaskSetApplicationTaskTag((TaskHandle_t)handle, (TaskHookFunction_t)tag);
+}
+
+/* Opens the window of a job as it reaches the active list. */
+void ddMissJobReleased(dd_slot slot, void* handle, uint8_t task_id)
+{
+	if (slot >= miss_window_count)
+	{
+		return;
+	}
+
+	dd_miss_window* window = &miss_windows[slot];
+
+	ddMissSetClass(handle, DD_MISS_CLASS_JOB, slot);
+
+	taskENTER_CRITICAL();
+	ddMissSnapshot(window->busy, &window->inserted);
+	window->inverted = 0;
+	window->blocked = 0;
+	memset(window->runner_time, 0, sizeof(window->runner_time));
+	memset(window->runner_id, 0, sizeof(window->runner_id));
+	window->runner_other = 0;
+	window->task_id = task_id;
+	taskEXIT_CRITICAL();
+}
+
+/* Adds time a generator's job ran to a window's list, or to its other jobs once the list is full. */
+static void ddMissChargeRunner(dd_miss_window* window, uint8_t task_id, uint32_t ran)
+{
+	for (uint32_t i = 0; i < DD_MISS_MAX_RUNNERS; i++)
+	{
+		if (window->runner_id[i] == task_id)
+		{
+			window->runner_time[i] += ran;
+			return;
+		}
+
+		if (window->runner_id[i] == 0)
+		{
+			window->runner_id[i] = task_id;
+			window->runner_time[i] = ran;
+			return;
+		}
+	}
+
+	window->runner_other += ran;
+}
+
+/*
+ * Scores the causes of a miss over the job's window, tallies its top cause
+ * against its generator and keeps the report for the monitor. Called by the
+ * scheduler as it moves the job to the overdue list. Returns the top cause.
+ */
+dd_miss_cause ddMissAnalyse(const dd_miss_job* job, dd_time_t now)
+{
+	uint32_t busy[DD_MISS_CLASS_COUNT];
+	uint32_t ran[DD_MISS_CLASS_COUNT];
+	uint32_t time;
+
+	if (job->slot >= miss_window_count)
+	{
+		return DD_MISS_CAUSE_COUNT;
+	}
+
+	dd_miss_window* window = &miss_windows[job->slot];
+	dd_miss_report* report = &miss_reports[miss_reports_written % DD_MISS_REPORT_LENGTH];
+
+	taskENTER_CRITICAL();
+	ddMissSnapshot(busy, &time);
+	uint32_t inverted = window->inverted;
+	uint32_t blocked = window->blocked;
+	memcpy(report->runner_time, window->runner_time, sizeof(report->runner_time));
+	memcpy(report->runner_id, window->runner_id, sizeof(report->runner_id));
+	report->runner_other = window->runner_other;
+	taskEXIT_CRITICAL();
+
+	for (uint32_t i = 0; i < DD_MISS_CLASS_COUNT; i++)
+	{
+		ran[i] = busy[i] - window->busy[i];
+	}
+
+	// The job's own execution is in the job class too, and inverted time is counted once, as inversion
+	uint32_t other_jobs = (ran[DD_MISS_CLASS_JOB] > job->executed_time) ? ran[DD_MISS_CLASS_JOB] - job->executed_time : 0;
+	int32_t lag = (int32_t)(window->inserted - (uint32_t)job->release);
+
+	report->scores[DD_MISS_OVERLOAD] = (other_jobs > inverted) ? other_jobs - inverted : 0;
+	report->scores[DD_MISS_INVERSION] = inverted + blocked;
+	report->scores[DD_MISS_SCHEDULER] = ran[DD_MISS_CLASS_SCHEDULER] + ran[DD_MISS_CLASS_RELEASE];
+	report->scores[DD_MISS_TIMER_LAG] = (lag > 0) ? (uint32_t)lag : 0;
+
+	// Rank the causes that took any time, highest first
+	uint32_t ranked = 0;
+
+	for (uint32_t cause = 0; cause < DD_MISS_CAUSE_COUNT; cause++)
+	{
+		uint32_t pos = ranked;
+
+		if (report->scores[cause] == 0)
+		{
+			continue;
+		}
+
+		while (pos > 0 && report->scores[report->ranked[pos - 1]] < report->scores[cause])
+		{
+			report->ranked[pos] = report->ranked[pos - 1];
+			pos--;
+		}
+
+		report->ranked[pos] = (uint8_t)cause;
+		ranked++;
+	}
+
+	for (uint32_t i = ranked; i < DD_MISS_CAUSE_COUNT; i++)
+	{
+		report->ranked[i] = DD_MISS_CAUSE_COUNT;
+	}
+
+	report->task_id = job->task_id;
+	report->active_jobs = job->active_jobs;
+	report->queued_commands = job->queued_commands;
+	report->deadline_ms = (uint32_t)(job->deadline / 1000);
+	report->window = (uint32_t)(job->deadline - job->release);
+	report->execution_time = job->execution_time;
+	report->executed_time = job->executed_time;
+	report->detect_lag = (uint32_t)(now - job->deadline);
+	miss_reports_written++;
+
+	if (job->task_id >= 1 && job->task_id <= DD_MISS_MAX_GENERATORS)
+	{
+		dd_miss_tally* tally = &miss_tallies[job->task_id - 1];
+
+		tally->misses++;
+		tally->by_cause[report->ranked[0]]++;
+		tally->shortfall_total += (job->executed_time < job->execution_time) ? job->execution_time - job->executed_time : 0;
+	}
+
+	return (dd_miss_cause)report->ranked[0];
+}
+
+/* Context switch hook, see FreeRTOSConfig.h. Charges the outgoing task's time to its class. */
+void ddMissSwitchedOut(uint32_t tag)
+{
+	uint32_t now = (uint32_t)ddClockNow();
+	uint32_t ran = now - miss_switch_time;
+	dd_miss_class cls = ddMissClass(tag);
+
+	miss_switch_time = now;
+	miss_busy[cls] += ran;
+
+	if (miss_active == NULL || miss_active->list_head == DD_SLOT_NONE)
+	{
+		return;
+	}
+
+	// Anything below the scheduler and the release path that is not the earliest deadline job holds it up
+	dd_slot head = miss_active->list_head;
+	dd_slot ran_slot = DD_MISS_TAG_SLOT(tag);
+
+	if (cls == DD_MISS_CLASS_JOB && ran_slot < miss_window_count)
+	{
+		// A job's run lands in the window of every other job still waiting on its deadline. The walk is
+		// bounded, as the scheduler can be switched out part way through relinking the list
+		dd_slot cur_slot = head;
+
+		for (uint32_t walked = 0; cur_slot < miss_window_count && walked < miss_window_count; walked++)
+		{
+			dd_slot next_slot = miss_table->next[cur_slot];
+
+			if ((cur_slot & 0xFF) != ran_slot)
+			{
+				ddMissChargeRunner(&miss_windows[cur_slot], miss_windows[ran_slot].task_id, ran);
+			}
+
+			cur_slot = next_slot;
+		}
+	}
+
+	if (cls == DD_MISS_CLASS_JOB && ran_slot != (head & 0xFF))
+	{
+		miss_windows[head].inverted += ran;
+	}
+	else if (cls == DD_MISS_CLASS_BACKGROUND || cls == DD_MISS_CLASS_IDLE)
+	{
+		miss_windows[head].blocked += ran;
+	}
+}
+
+void ddMissPrint(void)
+{
+	// Only the monitor prints, so the snapshot stays off its stack
+	static dd_miss_report reports[DD_MISS_REPORT_LENGTH];
+	static dd_miss_tally tallies[DD_MISS_MAX_GENERATORS];
+	uint32_t count;
+	uint32_t skipped;
+
+	vTaskSuspendAll();
+
+	memcpy(tallies, miss_tallies, sizeof(tallies));
+	count = miss_reports_written - miss_reports_printed;
+	skipped = (count > DD_MISS_REPORT_LENGTH) ? count - DD_MISS_REPORT_LENGTH : 0;
+	count -= skipped;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		reports[i] = miss_reports[(miss_reports_written - count + i) % DD_MISS_REPORT_LENGTH];
+	}
+
+	miss_reports_printed = miss_reports_written;
+
+	xTaskResumeAll();
+
+	for (uint32_t i = 0; i < DD_MISS_MAX_GENERATORS; i++)
+	{
+		dd_miss_tally* tally = &tallies[i];
+
+		if (tally->misses == 0)
+		{
+			continue;
+		}
+
+		// Two lines, since printf formats each one on the caller's stack
+		printf("Misses Generator %u: Count = %u, Avg Shortfall = %u us\n", (unsigned int)(i + 1),
+				(unsigned int)tally->misses, (unsigned int)(tally->shortfall_total / tally->misses));
+		printf("  Overload = %u, Priority Inversion = %u, Scheduler Overhead = %u, Timer Lag = %u, Unexplained = %u\n",
+				(unsigned int)tally->by_cause[DD_MISS_OVERLOAD], (unsigned int)tally->by_cause[DD_MISS_INVERSION],
+				(unsigned int)tally->by_cause[DD_MISS_SCHEDULER], (unsigned int)tally->by_cause[DD_MISS_TIMER_LAG],
+				(unsigned int)tally->by_cause[DD_MISS_CAUSE_COUNT]);
+	}
+
+	if (skipped > 0)
+	{
+		printf("Misses not shown: %u\n", (unsigned int)skipped);
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		dd_miss_report* report = &reports[i];
+
+		printf("Miss Task ID = %u, Deadline = %u ms: Executed = %u of %u us, Active = %u, Queued = %u, Detect Lag = %u us\n",
+				(unsigned int)report->task_id, (unsigned int)report->deadline_ms, (unsigned int)report->executed_time,
+				(unsigned int)report->execution_time, (unsigned int)report->active_jobs,
+				(unsigned int)report->queued_commands, (unsigned int)report->detect_lag);
+
+		if (report->ranked[0] == DD_MISS_CAUSE_COUNT)
+		{
+			printf("  Unexplained\n");
+			continue;
+		}
+
+		for (uint32_t rank = 0; rank < DD_MISS_CAUSE_COUNT && report->ranked[rank] != DD_MISS_CAUSE_COUNT; rank++)
+		{
+			uint32_t score = report->scores[report->ranked[rank]];
+			uint32_t percent = (report->window == 0) ? 0 : (uint32_t)((uint64_t)score * 100 / report->window);
+
+			printf("  %u. %s = %u us (%u%% of window)\n", (unsigned int)(rank + 1),
+					cause_names[report->ranked[rank]], (unsigned int)score, (unsigned int)percent);
+		}
+
+		if (report->runner_id[0] == 0)
+		{
+			continue;
+		}
+
+		// One short printf per job, so the line never needs a wide format buffer
+		printf("  Ran in window:");
+
+		for (uint32_t j = 0; j < DD_MISS_MAX_RUNNERS && report->runner_id[j] != 0; j++)
+		{
+			printf(" Task ID %u = %u us", (unsigned int)report->runner_id[j], (unsigned int)report->runner_time[j]);
+		}
+
+		if (report->runner_other > 0)
+		{
+			printf(" Other = %u us", (unsigned int)report->runner_other);
+		}
+
+		printf("\n");
+	}
+}
@@ -0,0 +1,129 @@
+/*
+ * dd_miss.h
+ *
+ * Deadline miss analysis. The context switch hook charges the time each task
+ * ran to its class (DD jobs, the scheduler, the release path, background
+ * tasks or idle), and to the job at the head of the active list as blocking
+ * when something other than that job ran below the scheduler. When a job is
+ * released the class totals are copied into its window, so when it misses
+ * its deadline the scheduler can tell how the CPU was spent between its
+ * release and its deadline with one subtraction per class. Each window also
+ * lists the generators whose jobs ran inside it and for how long, so a miss
+ * names the jobs that took its time as well as the class they fall in.
+ *
+ * Each miss is explained by four causes, each scored in microseconds of the
+ * window it took away, and ranked:
+ *
+ *   Overload            Other DD jobs ran ahead of it with earlier deadlines.
+ *   Priority Inversion  It was the earliest deadline but another job, a
+ *                       background task or idle ran instead.
+ *   Scheduler Overhead  The scheduler task and the generators ran.
+ *   Timer Lag           The job reached the active list after its release.
+ *
+ * Misses are tallied per generator by their top cause, and the last few are
+ * kept in full for the monitor. Switches cost one clock read and a few adds,
+ * plus a walk of the active list when a DD job is switched out; the analysis
+ * itself only runs on a miss.
+ *
+ * A task's class lives in bits 16 to 23 of its application task tag and a
+ * job's slot in bits 24 to 31, above the trace ID (see dd_trace.h). Tasks
+ * that are never given a class count as background.
+ */
+
+#ifndef DD_MISS_H_
+#define DD_MISS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "dd_jobs.h"
+
+/* Generators that get a row of tallies. */
+#define DD_MISS_MAX_GENERATORS		8
+
+/* Misses kept in full between two reports. */
+#define DD_MISS_REPORT_LENGTH		4
+
+/* Jobs listed per window; later ones are added up as other jobs. */
+#define DD_MISS_MAX_RUNNERS			4
+
+typedef enum dd_miss_class
+{
+	DD_MISS_CLASS_BACKGROUND,	// The monitor and anything untagged
+	DD_MISS_CLASS_IDLE,
+	DD_MISS_CLASS_SCHEDULER,
+	DD_MISS_CLASS_RELEASE,		// Generators and the timer service task
+	DD_MISS_CLASS_JOB,
+	DD_MISS_CLASS_COUNT
+} dd_miss_class;
+
+typedef enum dd_miss_cause
+{
+	DD_MISS_OVERLOAD,
+	DD_MISS_INVERSION,
+	DD_MISS_SCHEDULER,
+	DD_MISS_TIMER_LAG,
+	DD_MISS_CAUSE_COUNT			// Also marks a miss none of the causes explain
+} dd_miss_cause;
+
+#define DD_MISS_TAG_CLASS(tag)		( ( (uint32_t)(tag) >> 16 ) & 0xFF )
+#define DD_MISS_TAG_SLOT(tag)		( (dd_slot)( (uint32_t)(tag) >> 24 ) )
+
+/* Class totals when a job was released, one per job slot. */
+typedef struct dd_miss_window
+{
+	uint32_t busy[DD_MISS_CLASS_COUNT];	// us, wrapping
+	uint32_t inserted;					// Low 32 bits of the time it reached the active list
+	uint32_t inverted;					// us other jobs ran while it was the earliest deadline
+	uint32_t blocked;					// us background tasks or idle ran while it was
+	uint32_t runner_time[DD_MISS_MAX_RUNNERS];	// us each listed generator's jobs ran in the window
+	uint32_t runner_other;						// us jobs ran once the list was full
+	uint8_t runner_id[DD_MISS_MAX_RUNNERS];		// Generator task IDs, 0 for an unused entry
+	uint8_t task_id;							// Generator of the job itself
+} dd_miss_window;
+
+/* What the scheduler knows about a job when it misses. */
+typedef struct dd_miss_job
+{
+	dd_slot slot;
+	uint8_t task_id;
+	uint8_t active_jobs;		// Jobs left in the active list
+	uint32_t queued_commands;	// Commands waiting in the scheduler ring
+	dd_time_t release;
+	dd_time_t deadline;
+	uint32_t execution_time;	// us
+	uint32_t executed_time;		// us
+} dd_miss_job;
+
+typedef struct dd_miss_report
+{
+	uint8_t task_id;
+	uint8_t active_jobs;
+	uint8_t ranked[DD_MISS_CAUSE_COUNT];	// Causes with a score, highest first, then DD_MISS_CAUSE_COUNT
+	uint32_t queued_commands;
+	uint32_t deadline_ms;
+	uint32_t window;						// us from release to deadline
+	uint32_t execution_time;
+	uint32_t executed_time;
+	uint32_t detect_lag;					// us from the deadline to the scheduler noticing
+	uint32_t scores[DD_MISS_CAUSE_COUNT];	// us
+	uint32_t runner_time[DD_MISS_MAX_RUNNERS];
+	uint32_t runner_other;
+	uint8_t runner_id[DD_MISS_MAX_RUNNERS];
+} dd_miss_report;
+
+typedef struct dd_miss_tally
+{
+	uint32_t misses;
+	uint32_t by_cause[DD_MISS_CAUSE_COUNT + 1];	// By top cause, the last entry for unexplained misses
+	uint64_t shortfall_total;					// us of execution the jobs did not get
+} dd_miss_tally;
+
+void ddMissInit(dd_miss_window* windows, uint32_t count, const dd_job_table* table, const dd_slot_list* active);
+void ddMissSetClass(void* handle, dd_miss_class cls, dd_slot slot);
+void ddMissJobReleased(dd_slot slot, void* handle, uint8_t task_id);
+dd_miss_cause ddMissAnalyse(const dd_miss_job* job, dd_time_t now);
+void ddMissSwitchedOut(uint32_t tag);
+void ddMissPrint(void);
+
+#endif /* DD_MISS_H_ */
@@ -0,0 +1,113 @@
+/*
+ * dd_overload.c
+ *
+ * Overload policies. See dd_overload.h.
+ */
+
+#include "dd_overload.h"
+
+static const char* const policy_names[DD_OVERLOAD_POLICY_COUNT] = { "None", "Drop Late", "Skip Over", "Value" };
+
+void ddMkInit(dd_mk_history* history, uint8_t m, uint8_t k)
+{
+	// A generator starts with a clean record
+	history->outcomes = UINT32_MAX;
+	history->k = (k > 32) ? 32 : k;
+	history->m = (m > history->k) ? history->k : m;
+}
+
+void ddMkRecord(dd_mk_history* history, bool met)
+{
+	history->outcomes = (history->outcomes << 1) | (met ? 1 : 0);
+}
+
+static uint32_t ddMkMet(uint32_t outcomes, uint32_t jobs)
+{
+	uint32_t mask = (jobs >= 32) ? UINT32_MAX : (1UL << jobs) - 1;
+
+	return (uint32_t)__builtin_popcount(outcomes & mask);
+}
+
+/* Whether the next job can be dropped with m of the last k still met. */
+bool ddMkSkippable(const dd_mk_history* history)
+{
+	return history->k > 0 && ddMkMet(history->outcomes, history->k - 1) >= history->m;
+}
+
+/* Whether fewer than m of the last k jobs met their deadline. */
+bool ddMkViolated(const dd_mk_history* history)
+{
+	return history->k > 0 && ddMkMet(history->outcomes, history->k) < history->m;
+}
+
+/* Returns the first job that cannot finish by its deadline in EDF order, or DD_OVERLOAD_KEEP_ALL. */
+uint32_t ddOverloadFirstMiss(const dd_overload_job* jobs, uint32_t count)
+{
+	int64_t demand = 0;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		demand += jobs[i].remaining;
+
+		if (demand > jobs[i].deadline)
+		{
+			return i;
+		}
+	}
+
+	return DD_OVERLOAD_KEEP_ALL;
+}
+
+/*
+ * Returns the job the policy drops so that the others have a better chance,
+ * or DD_OVERLOAD_KEEP_ALL if every job can make its deadline (or the policy
+ * is DD_OVERLOAD_NONE). Call again after dropping it.
+ */
+uint32_t ddOverloadShed(dd_overload_policy policy, const dd_overload_job* jobs, uint32_t count)
+{
+	uint32_t first_miss = ddOverloadFirstMiss(jobs, count);
+	uint32_t late = DD_OVERLOAD_KEEP_ALL;
+	uint32_t best = DD_OVERLOAD_KEEP_ALL;
+
+	if (policy == DD_OVERLOAD_NONE || first_miss == DD_OVERLOAD_KEEP_ALL)
+	{
+		return DD_OVERLOAD_KEEP_ALL;
+	}
+
+	for (uint32_t i = 0; i <= first_miss; i++)
+	{
+		const dd_overload_job* job = &jobs[i];
+
+		if (job->remaining == 0)
+		{
+			continue;
+		}
+
+		// The job predicted to miss, or the last one before it that still has work
+		late = i;
+
+		if (policy == DD_OVERLOAD_SKIP_OVER)
+		{
+			if (job->skippable && (best == DD_OVERLOAD_KEEP_ALL || job->remaining > jobs[best].remaining))
+			{
+				best = i;
+			}
+		}
+		else if (policy == DD_OVERLOAD_VALUE)
+		{
+			// Lowest value density, compared without dividing
+			if (best == DD_OVERLOAD_KEEP_ALL ||
+				(uint64_t)job->value * jobs[best].remaining < (uint64_t)jobs[best].value * job->remaining)
+			{
+				best = i;
+			}
+		}
+	}
+
+	return (best != DD_OVERLOAD_KEEP_ALL) ? best : late;
+}
+
+const char* ddOverloadPolicyName(dd_overload_policy policy)
+{
+	return (policy < DD_OVERLOAD_POLICY_COUNT) ? policy_names[policy] : "Unknown";
+}
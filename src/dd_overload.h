@@ -0,0 +1,68 @@
+/*
+ * dd_overload.h
+ *
+ * Overload policies for the DD scheduler. Without one, a job that cannot
+ * make its deadline keeps its place in the active list until the deadline
+ * passes, and the time it ran is wasted. With one, the scheduler checks
+ * after every step (each admission and each dispatch) whether every active
+ * job can still finish in EDF order, and sheds jobs until they can:
+ *
+ *   DD_OVERLOAD_DROP_LATE  The first job predicted to miss is dropped.
+ *   DD_OVERLOAD_SKIP_OVER  Jobs of (m,k)-firm generators are dropped while
+ *                          at least m of every k consecutive jobs still
+ *                          meet their deadline, largest demand first;
+ *                          otherwise as DD_OVERLOAD_DROP_LATE.
+ *   DD_OVERLOAD_VALUE      The job with the lowest value per microsecond
+ *                          of execution left is dropped.
+ *
+ * Only jobs up to the first predicted miss are candidates: dropping a later
+ * one does not help it. Jobs with no execution left are never dropped.
+ *
+ * No FreeRTOS dependencies, so the host benchmark (dd_overload_bench.c)
+ * runs the same policies.
+ */
+
+#ifndef DD_OVERLOAD_H_
+#define DD_OVERLOAD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DD_OVERLOAD_KEEP_ALL	UINT32_MAX
+
+typedef enum dd_overload_policy
+{
+	DD_OVERLOAD_NONE,
+	DD_OVERLOAD_DROP_LATE,
+	DD_OVERLOAD_SKIP_OVER,
+	DD_OVERLOAD_VALUE,
+	DD_OVERLOAD_POLICY_COUNT
+} dd_overload_policy;
+
+/* A job as the overload check sees it. Jobs are passed in EDF order. */
+typedef struct dd_overload_job
+{
+	int32_t deadline;		// us from now, negative once passed
+	uint32_t remaining;		// us of execution left
+	uint32_t value;			// Worth of completing it, in any unit
+	bool skippable;			// Dropping it keeps its generator's (m,k) constraint
+} dd_overload_job;
+
+/* Recent deadline outcomes of one generator. */
+typedef struct dd_mk_history
+{
+	uint32_t outcomes;		// Bit i set if the job i releases back met its deadline
+	uint8_t m;
+	uint8_t k;				// 0 for a generator that has no (m,k) constraint
+} dd_mk_history;
+
+void ddMkInit(dd_mk_history* history, uint8_t m, uint8_t k);
+void ddMkRecord(dd_mk_history* history, bool met);
+bool ddMkSkippable(const dd_mk_history* history);
+bool ddMkViolated(const dd_mk_history* history);
+
+uint32_t ddOverloadFirstMiss(const dd_overload_job* jobs, uint32_t count);
+uint32_t ddOverloadShed(dd_overload_policy policy, const dd_overload_job* jobs, uint32_t count);
+const char* ddOverloadPolicyName(dd_overload_policy policy);
+
+#endif /* DD_OVERLOAD_H_ */
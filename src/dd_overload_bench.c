@@ -0,0 +1,324 @@
+/*
+ * dd_overload_bench.c
+ *
+ * Host benchmark for the overload policies (host build only). Random
+ * periodic task sets are run under EDF in a simulation with 1 us steps, at
+ * loads from 80% to past 200%, once with each policy from dd_overload.c:
+ *
+ *   - Jobs still running at their deadline are stopped, as on the target.
+ *   - The policy runs on every release (admission) and whenever a job is
+ *     stopped (dispatch), like schedulerShedOverload() on the target.
+ *
+ * A third of the tasks are critical and hard; the others are normal or
+ * background and (m,k)-firm. Useful work is the execution time of the jobs
+ * that met their deadline, as a share of the CPU. Value weighs it by class,
+ * as a share of the value released. Violations are jobs that ended with
+ * fewer than m of their task's last k jobs met.
+ *
+ * Usage: dd_overload_bench [sets] [seconds per set] [max load %]
+ */
+
+#ifdef HOST_BUILD
+
+#include "dd_overload.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_TASKS				6
+#define BENCH_NONE				( -1 )
+
+static const uint32_t class_values[] = { 100, 10, 1 };
+
+typedef struct bench_task
+{
+	/* Task parameters, us */
+	uint32_t period;
+	uint32_t execution;
+	uint32_t value;					// Per us of execution
+	uint8_t m;
+	uint8_t k;						// 0 for a hard task
+
+	/* Current job */
+	bool active;
+	uint64_t deadline;
+	uint64_t next_release;
+	uint32_t executed;
+	dd_mk_history history;
+} bench_task;
+
+typedef struct bench_result
+{
+	uint64_t jobs;
+	uint64_t completed;
+	uint64_t shed;
+	uint64_t missed;
+	uint64_t hard_missed;			// Missed or shed jobs of hard tasks
+	uint64_t violations;
+	uint64_t useful;				// us
+	uint64_t wasted;				// us run by jobs that did not complete
+	uint64_t value_done;
+	uint64_t value_released;
+	uint64_t time;					// us simulated
+} bench_result;
+
+static uint32_t benchRandom(uint32_t* state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+/* Uniform in [low, high]. */
+static uint32_t benchRange(uint32_t* state, uint32_t low, uint32_t high)
+{
+	return low + benchRandom(state) % (high - low + 1);
+}
+
+/*-------------------------- Task Sets --------------------------------------*/
+
+/* Draws a task set with the given total utilisation (UUniFast, redrawn until no task exceeds 1). */
+static void benchMakeTaskSet(uint32_t* rng, bench_task* tasks, uint32_t count, double utilisation)
+{
+	double shares[BENCH_TASKS];
+	bool valid;
+
+	do
+	{
+		double remaining = utilisation;
+
+		valid = true;
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			shares[i] = remaining;
+
+			if (i + 1 < count)
+			{
+				double r = (double)(benchRandom(rng) % 1000000) / 1000000.0;
+				double next = remaining * pow(r, 1.0 / (count - 1 - i));
+
+				shares[i] = remaining - next;
+				remaining = next;
+			}
+
+			if (shares[i] > 1.0) valid = false;
+		}
+	} while (!valid);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		bench_task* task = &tasks[i];
+		uint32_t t_class = (i < count / 3) ? 0 : 1 + benchRandom(rng) % 2;
+
+		memset(task, 0, sizeof(*task));
+
+		task->period = benchRange(rng, 20, 200) * 100;
+		task->execution = (uint32_t)(shares[i] * task->period);
+		if (task->execution < 20) task->execution = 20;
+		if (task->execution > task->period) task->execution = task->period;
+		task->value = class_values[t_class];
+
+		if (t_class != 0)
+		{
+			task->k = (uint8_t)benchRange(rng, 2, 5);
+			task->m = (uint8_t)benchRange(rng, 1, task->k - 1);
+		}
+
+		task->next_release = benchRandom(rng) % task->period;
+	}
+}
+
+/*-------------------------- Simulation -------------------------------------*/
+
+static void benchEndJob(bench_task* task, bench_result* result, bool met)
+{
+	task->active = false;
+	ddMkRecord(&task->history, met);
+
+	if (met)
+	{
+		result->completed++;
+		result->useful += task->execution;
+		result->value_done += (uint64_t)task->value * task->execution;
+	}
+	else
+	{
+		result->wasted += task->executed;
+		if (task->k == 0) result->hard_missed++;
+	}
+
+	if (ddMkViolated(&task->history)) result->violations++;
+}
+
+/* Sheds jobs until the rest fit, the way schedulerShedOverload() does. */
+static void benchShed(bench_task* tasks, uint32_t count, dd_overload_policy policy, uint64_t now, bench_result* result)
+{
+	dd_overload_job jobs[BENCH_TASKS];
+	uint32_t order[BENCH_TASKS];
+
+	while (1)
+	{
+		uint32_t active = 0;
+
+		// Active jobs in deadline order, ties by task index like the target's insertion order
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t pos = active;
+
+			if (!tasks[i].active)
+			{
+				continue;
+			}
+
+			while (pos > 0 && tasks[order[pos - 1]].deadline > tasks[i].deadline)
+			{
+				order[pos] = order[pos - 1];
+				pos--;
+			}
+
+			order[pos] = i;
+			active++;
+		}
+
+		for (uint32_t i = 0; i < active; i++)
+		{
+			bench_task* task = &tasks[order[i]];
+
+			jobs[i].deadline = (int32_t)(task->deadline - now);
+			jobs[i].remaining = task->execution - task->executed;
+			jobs[i].value = task->value * task->execution;
+			jobs[i].skippable = ddMkSkippable(&task->history);
+		}
+
+		uint32_t victim = ddOverloadShed(policy, jobs, active);
+
+		if (victim == DD_OVERLOAD_KEEP_ALL)
+		{
+			return;
+		}
+
+		result->shed++;
+		benchEndJob(&tasks[order[victim]], result, false);
+	}
+}
+
+static void benchRun(bench_task* tasks, uint32_t count, dd_overload_policy policy, uint64_t duration, bench_result* result)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		ddMkInit(&tasks[i].history, tasks[i].m, tasks[i].k);
+	}
+
+	for (uint64_t now = 0; now < duration; now++)
+	{
+		bool changed = false;
+		int32_t pick = BENCH_NONE;
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			bench_task* task = &tasks[i];
+
+			if (task->active && task->deadline <= now)
+			{
+				result->missed++;
+				benchEndJob(task, result, false);
+				changed = true;
+			}
+
+			if (task->next_release == now)
+			{
+				task->active = true;
+				task->deadline = now + task->period;
+				task->next_release += task->period;
+				task->executed = 0;
+				result->jobs++;
+				result->value_released += (uint64_t)task->value * task->execution;
+				changed = true;
+			}
+		}
+
+		if (changed)
+		{
+			benchShed(tasks, count, policy, now, result);
+		}
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (tasks[i].active && (pick == BENCH_NONE || tasks[i].deadline < tasks[pick].deadline))
+			{
+				pick = (int32_t)i;
+			}
+		}
+
+		if (pick != BENCH_NONE && ++tasks[pick].executed == tasks[pick].execution)
+		{
+			benchEndJob(&tasks[pick], result, true);
+		}
+	}
+
+	result->time += duration;
+}
+
+/*-------------------------- Main -------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+	uint32_t sets = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 20;
+	uint32_t seconds = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : 1;
+	uint32_t max_load = (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 10) : 220;
+
+	if (sets == 0 || seconds == 0 || max_load < 80)
+	{
+		printf("Usage: %s [sets] [seconds per set] [max load %% >= 80]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%u task sets of %u tasks per load, %u s each\n", (unsigned int)sets, (unsigned int)BENCH_TASKS, (unsigned int)seconds);
+	printf("%-5s %-10s %9s %9s %8s %8s %9s %9s %8s %11s %10s\n", "load", "policy", "jobs", "completed", "shed",
+		   "missed", "useful %", "wasted %", "value %", "hard misses", "violations");
+
+	for (uint32_t load = 80; load <= max_load; load += 20)
+	{
+		bench_result results[DD_OVERLOAD_POLICY_COUNT];
+		uint32_t rng = 0x5eed1234 + load;
+
+		memset(results, 0, sizeof(results));
+
+		for (uint32_t set = 0; set < sets; set++)
+		{
+			bench_task tasks[BENCH_TASKS];
+
+			benchMakeTaskSet(&rng, tasks, BENCH_TASKS, load / 100.0);
+
+			for (uint32_t policy = 0; policy < DD_OVERLOAD_POLICY_COUNT; policy++)
+			{
+				bench_task run[BENCH_TASKS];
+
+				// Every policy sees the same releases
+				memcpy(run, tasks, sizeof(run));
+				benchRun(run, BENCH_TASKS, (dd_overload_policy)policy, (uint64_t)seconds * 1000000, &results[policy]);
+			}
+		}
+
+		for (uint32_t policy = 0; policy < DD_OVERLOAD_POLICY_COUNT; policy++)
+		{
+			bench_result* result = &results[policy];
+
+			printf("%4u%% %-10s %9llu %9llu %8llu %8llu %9.1f %9.1f %8.1f %11llu %10llu\n", (unsigned int)load,
+				   ddOverloadPolicyName((dd_overload_policy)policy), (unsigned long long)result->jobs,
+				   (unsigned long long)result->completed, (unsigned long long)result->shed,
+				   (unsigned long long)result->missed, 100.0 * result->useful / result->time,
+				   100.0 * result->wasted / result->time,
+				   (result->value_released == 0) ? 0.0 : 100.0 * result->value_done / result->value_released,
+				   (unsigned long long)result->hard_missed, (unsigned long long)result->violations);
+		}
+	}
+
+	return 0;
+}
+
+#endif /* HOST_BUILD */
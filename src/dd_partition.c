@@ -0,0 +1,730 @@
+/*
+ * dd_partition.c
+ *
+ * Partitioned EDF on a pthread per core. See dd_partition.h.
+ */
+
+#ifdef HOST_BUILD
+
+#include "dd_partition.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct part_run part_run;
+
+typedef struct part_job
+{
+	dd_time_t deadline;
+	uint32_t execution_time;
+} part_job;
+
+/*
+ * Chase-Lev style deque with a single producer, the aperiodic arrival thread,
+ * pushing at the bottom. Arrivals are in deadline order, so the owner takes
+ * from the top like the thieves do, with the same compare and swap.
+ */
+typedef struct part_deque
+{
+	_Atomic uint64_t top;		// Oldest job, next to take
+	_Atomic uint64_t bottom;	// Next free position
+	part_job items[DD_PARTITION_DEQUE_SIZE];
+} part_deque;
+
+typedef struct part_core
+{
+	part_run* run;
+	uint32_t id;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+
+	dd_job_table table;
+	dd_slot_list ready;
+	uint32_t* remaining;		// Execution left per slot, us
+	uint32_t queued;			// Sum of remaining over the ready list, us
+
+	uint32_t utilisation;		// Admitted utilisation in thousandths
+	uint32_t num_tasks;
+	uint32_t tasks[DD_PARTITION_MAX_TASKS];
+	dd_time_t next_release[DD_PARTITION_MAX_TASKS];
+
+	uint64_t released;
+	uint64_t completed;
+	uint64_t misses;
+	uint64_t rejected;
+	uint64_t busy_us;
+	uint64_t steals;
+
+	part_deque deque;			// Aperiodic jobs under DD_APERIODIC_STEAL
+} part_core;
+
+struct part_run
+{
+	const dd_partition_config* config;
+	const dd_part_task* tasks;
+	part_core cores[DD_PARTITION_MAX_CORES];
+	part_core central;			// Queue shared by all cores under DD_APERIODIC_CENTRAL, never run
+	uint32_t aperiodic_home;
+	uint64_t migrations;
+	uint64_t aperiodic_rejected;
+	atomic_bool stop;
+};
+
+/*-------------------------- Admission --------------------------------------*/
+
+uint32_t ddPartitionUtilisation(const dd_part_task* task)
+{
+	// Rounded up, so the admission test stays safe
+	return (uint32_t)(((uint64_t)task->execution_time * 1000 + task->period - 1) / task->period);
+}
+
+/*
+ * First-fit decreasing: tasks are taken from the largest utilisation down
+ * and placed on the first core they fit on, with EDF's bound of 1 per core.
+ * Returns the number of tasks placed.
+ */
+uint32_t ddPartitionAssign(const dd_part_task* tasks, uint32_t num_tasks, uint32_t num_cores,
+						   uint8_t* core_of, uint32_t* utilisation)
+{
+	uint32_t order[DD_PARTITION_MAX_TASKS + 1];
+	uint32_t placed = 0;
+
+	for (uint32_t i = 0; i < num_tasks; i++)
+	{
+		uint32_t pos = i;
+
+		// Insertion sort by decreasing utilisation
+		while (pos > 0 && ddPartitionUtilisation(&tasks[order[pos - 1]]) < ddPartitionUtilisation(&tasks[i]))
+		{
+			order[pos] = order[pos - 1];
+			pos--;
+		}
+
+		order[pos] = i;
+	}
+
+	memset(utilisation, 0, num_cores * sizeof(uint32_t));
+
+	for (uint32_t i = 0; i < num_tasks; i++)
+	{
+		uint32_t task_util = ddPartitionUtilisation(&tasks[order[i]]);
+
+		core_of[order[i]] = DD_PARTITION_UNPLACED;
+
+		for (uint32_t c = 0; c < num_cores; c++)
+		{
+			if (utilisation[c] + task_util <= 1000)
+			{
+				utilisation[c] += task_util;
+				core_of[order[i]] = (uint8_t)c;
+				placed++;
+				break;
+			}
+		}
+	}
+
+	return placed;
+}
+
+/*-------------------------- Run Queues -------------------------------------*/
+
+static bool partCoreInit(part_core* core)
+{
+	uint32_t slots = DD_PARTITION_CORE_SLOTS;
+
+	memset(core, 0, sizeof(part_core));
+
+	core->table.capacity = slots;
+	core->table.deadline = (dd_time_t*)malloc(slots * sizeof(dd_time_t));
+	core->table.handle = (void**)malloc(slots * sizeof(void*));
+	core->table.t_class = (uint8_t*)malloc(slots);
+	core->table.next = (dd_slot*)malloc(slots * sizeof(dd_slot));
+	core->table.prev = (dd_slot*)malloc(slots * sizeof(dd_slot));
+	core->table.linked = (uint8_t*)malloc(slots);
+	core->remaining = (uint32_t*)malloc(slots * sizeof(uint32_t));
+
+	if (core->table.deadline == NULL || core->table.handle == NULL || core->table.t_class == NULL ||
+		core->table.next == NULL || core->table.prev == NULL || core->table.linked == NULL || core->remaining == NULL)
+	{
+		return false;
+	}
+
+	ddJobTableInit(&(core->table));
+	ddSlotListInit(&(core->ready));
+	atomic_init(&(core->deque.top), 0);
+	atomic_init(&(core->deque.bottom), 0);
+
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&(core->wake), &attr);
+	pthread_condattr_destroy(&attr);
+	pthread_mutex_init(&(core->lock), NULL);
+
+	return true;
+}
+
+static void partCoreFree(part_core* core)
+{
+	pthread_mutex_destroy(&(core->lock));
+	pthread_cond_destroy(&(core->wake));
+
+	free(core->table.deadline);
+	free(core->table.handle);
+	free(core->table.t_class);
+	free(core->table.next);
+	free(core->table.prev);
+	free(core->table.linked);
+	free(core->remaining);
+}
+
+/* Queues a job on the core. The core's lock must be held. */
+static bool partPush(part_core* core, dd_time_t deadline, uint32_t execution_time)
+{
+	dd_slot slot = ddJobAlloc(&(core->table));
+
+	if (slot == DD_SLOT_NONE)
+	{
+		core->rejected++;
+		return false;
+	}
+
+	core->table.deadline[slot] = deadline;
+	core->table.handle[slot] = NULL;
+	core->table.t_class[slot] = 0;
+	core->remaining[slot] = execution_time;
+	core->queued += execution_time;
+	core->released++;
+
+	ddSlotListInsertOrdered(&(core->table), &(core->ready), slot);
+	return true;
+}
+
+/* Releases every periodic job of the core that is due. The lock must be held. */
+static void partReleaseDue(part_core* core, dd_time_t now)
+{
+	for (uint32_t i = 0; i < core->num_tasks; i++)
+	{
+		const dd_part_task* task = &(core->run->tasks[core->tasks[i]]);
+
+		while (!ddTimeBefore(now, core->next_release[i]))
+		{
+			partPush(core, core->next_release[i] + task->period, task->execution_time);
+			core->next_release[i] += task->period;
+		}
+	}
+}
+
+/* Drops jobs whose deadline has passed; the list is in deadline order. The lock must be held. */
+static void partDropMissed(part_core* core, dd_time_t now)
+{
+	while (core->ready.list_head != DD_SLOT_NONE && ddTimeBefore(core->table.deadline[core->ready.list_head], now))
+	{
+		dd_slot slot = core->ready.list_head;
+
+		ddSlotListRemove(&(core->table), &(core->ready), slot);
+		core->queued -= core->remaining[slot];
+		core->misses++;
+		ddJobFree(&(core->table), slot);
+	}
+}
+
+static dd_time_t partNextRelease(const part_core* core, dd_time_t now)
+{
+	dd_time_t next = now + 10000;
+
+	for (uint32_t i = 0; i < core->num_tasks; i++)
+	{
+		if (ddTimeBefore(core->next_release[i], next))
+		{
+			next = core->next_release[i];
+		}
+	}
+
+	return next;
+}
+
+/*-------------------------- Aperiodic Deques ------------------------------*/
+
+static bool partDequePush(part_deque* deque, const part_job* job)
+{
+	uint64_t bottom = atomic_load_explicit(&(deque->bottom), memory_order_relaxed);
+	uint64_t top = atomic_load_explicit(&(deque->top), memory_order_acquire);
+
+	if (bottom - top >= DD_PARTITION_DEQUE_SIZE)
+	{
+		return false;
+	}
+
+	deque->items[bottom & (DD_PARTITION_DEQUE_SIZE - 1)] = *job;
+	atomic_store_explicit(&(deque->bottom), bottom + 1, memory_order_release);
+	return true;
+}
+
+/* Deadline of the oldest job, for picking a victim. Only a hint, it may be taken meanwhile. */
+static bool partDequePeek(part_deque* deque, dd_time_t* deadline)
+{
+	uint64_t top = atomic_load_explicit(&(deque->top), memory_order_acquire);
+	uint64_t bottom = atomic_load_explicit(&(deque->bottom), memory_order_acquire);
+
+	if (top >= bottom)
+	{
+		return false;
+	}
+
+	*deadline = deque->items[top & (DD_PARTITION_DEQUE_SIZE - 1)].deadline;
+	return true;
+}
+
+/* Takes the oldest job. Fails if the deque is empty or another core took it first. */
+static bool partDequeTake(part_deque* deque, part_job* job)
+{
+	uint64_t top = atomic_load_explicit(&(deque->top), memory_order_acquire);
+	uint64_t bottom = atomic_load_explicit(&(deque->bottom), memory_order_acquire);
+
+	if (top >= bottom)
+	{
+		return false;
+	}
+
+	// The producer does not reuse the slot until top has moved past it
+	*job = deque->items[top & (DD_PARTITION_DEQUE_SIZE - 1)];
+	return atomic_compare_exchange_strong_explicit(&(deque->top), &top, top + 1, memory_order_acq_rel, memory_order_relaxed);
+}
+
+/* Queues a job pulled from elsewhere, or counts it as missed. The lock must be held. */
+static bool partAdmitPulled(part_core* core, const part_job* job, dd_time_t now)
+{
+	if (ddTimeBefore(job->deadline, now))
+	{
+		core->released++;
+		core->misses++;
+		return false;
+	}
+
+	return partPush(core, job->deadline, job->execution_time);
+}
+
+/*
+ * Steals for an idle core from the core whose oldest aperiodic job has the
+ * earliest deadline. The lock of the stealing core must be held.
+ */
+static bool partSteal(part_core* core, dd_time_t now)
+{
+	part_run* run = core->run;
+
+	for (uint32_t attempt = 0; attempt < 2 * run->config->num_cores; attempt++)
+	{
+		uint32_t victim = DD_PARTITION_MAX_CORES;
+		dd_time_t best = 0;
+		part_job job;
+
+		for (uint32_t c = 0; c < run->config->num_cores; c++)
+		{
+			dd_time_t deadline;
+
+			if (c != core->id && partDequePeek(&(run->cores[c].deque), &deadline) &&
+				(victim == DD_PARTITION_MAX_CORES || ddTimeBefore(deadline, best)))
+			{
+				victim = c;
+				best = deadline;
+			}
+		}
+
+		if (victim == DD_PARTITION_MAX_CORES)
+		{
+			return false;
+		}
+
+		if (partDequeTake(&(run->cores[victim].deque), &job))
+		{
+			core->steals++;
+
+			if (partAdmitPulled(core, &job, now))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Under the global policies, moves the aperiodic job with the earliest
+ * deadline onto this core's run queue when it is due before the core's own
+ * head. The lock must be held.
+ */
+static void partPullAperiodic(part_core* core, dd_time_t now)
+{
+	part_run* run = core->run;
+	part_job job;
+
+	if (run->config->policy == DD_APERIODIC_STEAL)
+	{
+		dd_time_t own;
+
+		while (partDequePeek(&(core->deque), &own) &&
+			   (core->ready.list_head == DD_SLOT_NONE || ddTimeBefore(own, core->table.deadline[core->ready.list_head])))
+		{
+			if (partDequeTake(&(core->deque), &job) && partAdmitPulled(core, &job, now))
+			{
+				break;
+			}
+		}
+
+		if (core->ready.list_head == DD_SLOT_NONE)
+		{
+			partSteal(core, now);
+		}
+	}
+	else if (run->config->policy == DD_APERIODIC_CENTRAL)
+	{
+		part_core* central = &(run->central);
+
+		// Cores always take their own lock first, then the central one
+		pthread_mutex_lock(&(central->lock));
+		partDropMissed(central, now);
+
+		dd_slot head = central->ready.list_head;
+
+		if (head != DD_SLOT_NONE &&
+			(core->ready.list_head == DD_SLOT_NONE || ddTimeBefore(central->table.deadline[head], core->table.deadline[core->ready.list_head])))
+		{
+			job.deadline = central->table.deadline[head];
+			job.execution_time = central->remaining[head];
+
+			ddSlotListRemove(&(central->table), &(central->ready), head);
+			central->queued -= central->remaining[head];
+			ddJobFree(&(central->table), head);
+
+			partAdmitPulled(core, &job, now);
+		}
+
+		pthread_mutex_unlock(&(central->lock));
+	}
+}
+
+/*-------------------------- Cores ------------------------------------------*/
+
+static uint64_t partThreadCpuUs(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+/* Spins for budget microseconds of this thread's CPU time. */
+static uint32_t partSpin(uint32_t budget)
+{
+	uint64_t start = partThreadCpuUs();
+	uint64_t ran = 0;
+
+	while (ran < budget)
+	{
+		ran = partThreadCpuUs() - start;
+	}
+
+	return (uint32_t)ran;
+}
+
+static void* partCoreMain(void* arg)
+{
+	part_core* core = (part_core*)arg;
+
+	while (!atomic_load(&(core->run->stop)))
+	{
+		dd_time_t now = ddClockNow();
+
+		pthread_mutex_lock(&(core->lock));
+
+		partReleaseDue(core, now);
+		partDropMissed(core, now);
+		partPullAperiodic(core, now);
+
+		dd_slot head = core->ready.list_head;
+
+		if (head == DD_SLOT_NONE)
+		{
+			// Idle until the next release, or until an aperiodic job is pushed
+			dd_time_t wake = partNextRelease(core, now);
+			struct timespec until = { (time_t)(wake / 1000000), (long)(wake % 1000000) * 1000 };
+
+			pthread_cond_timedwait(&(core->wake), &(core->lock), &until);
+			pthread_mutex_unlock(&(core->lock));
+			continue;
+		}
+
+		uint32_t budget = (core->remaining[head] < DD_PARTITION_SLICE_US) ? core->remaining[head] : DD_PARTITION_SLICE_US;
+
+		// Only this core removes jobs from its list, so the head stays valid while unlocked
+		pthread_mutex_unlock(&(core->lock));
+		uint32_t ran = partSpin(budget);
+		pthread_mutex_lock(&(core->lock));
+
+		if (ran > core->remaining[head]) ran = core->remaining[head];
+
+		core->remaining[head] -= ran;
+		core->queued -= ran;
+		core->busy_us += ran;
+
+		if (core->remaining[head] == 0)
+		{
+			if (ddTimeBefore(core->table.deadline[head], ddClockNow())) core->misses++;
+			else core->completed++;
+
+			ddSlotListRemove(&(core->table), &(core->ready), head);
+			ddJobFree(&(core->table), head);
+		}
+
+		pthread_mutex_unlock(&(core->lock));
+	}
+
+	return NULL;
+}
+
+static uint32_t partRandom(uint32_t* state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+/* Releases aperiodic jobs with exponentially distributed gaps, placed by the configured policy. */
+static void* partAperiodicMain(void* arg)
+{
+	part_run* run = (part_run*)arg;
+	const dd_partition_config* config = run->config;
+	uint32_t rng_state = (config->seed == 0) ? 1 : config->seed;
+
+	dd_time_t arrival = ddClockNow();
+
+	while (!atomic_load(&(run->stop)))
+	{
+		double u = (partRandom(&rng_state) + 1.0) / 4294967297.0;
+
+		// Arrival times are absolute, so time spent placing jobs does not slow the stream down
+		arrival += (dd_time_t)(-log(u) * config->aperiodic_interarrival);
+		struct timespec until = { (time_t)(arrival / 1000000), (long)(arrival % 1000000) * 1000 };
+
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL);
+
+		uint32_t target = run->aperiodic_home;
+		part_job job = { ddClockNow() + config->aperiodic_deadline, config->aperiodic_execution };
+
+		if (config->policy == DD_APERIODIC_STEAL || config->policy == DD_APERIODIC_CENTRAL)
+		{
+			if (config->policy == DD_APERIODIC_STEAL)
+			{
+				if (!partDequePush(&(run->cores[target].deque), &job)) run->aperiodic_rejected++;
+			}
+			else
+			{
+				pthread_mutex_lock(&(run->central.lock));
+				partPush(&(run->central), job.deadline, job.execution_time);
+				pthread_mutex_unlock(&(run->central.lock));
+			}
+
+			// Any idle core may pick the job up
+			for (uint32_t c = 0; c < config->num_cores; c++)
+			{
+				pthread_mutex_lock(&(run->cores[c].lock));
+				pthread_cond_signal(&(run->cores[c].wake));
+				pthread_mutex_unlock(&(run->cores[c].lock));
+			}
+
+			continue;
+		}
+
+		if (config->policy == DD_APERIODIC_LEAST_LOADED)
+		{
+			uint32_t least = UINT32_MAX;
+
+			for (uint32_t c = 0; c < config->num_cores; c++)
+			{
+				pthread_mutex_lock(&(run->cores[c].lock));
+				uint32_t queued = run->cores[c].queued;
+				pthread_mutex_unlock(&(run->cores[c].lock));
+
+				if (queued < least)
+				{
+					least = queued;
+					target = c;
+				}
+			}
+
+			if (target != run->aperiodic_home) run->migrations++;
+		}
+
+		part_core* core = &(run->cores[target]);
+
+		pthread_mutex_lock(&(core->lock));
+		partPush(core, job.deadline, job.execution_time);
+		pthread_cond_signal(&(core->wake));
+		pthread_mutex_unlock(&(core->lock));
+	}
+
+	return NULL;
+}
+
+/*-------------------------- Runs -------------------------------------------*/
+
+bool ddPartitionRun(const dd_partition_config* config, const dd_part_task* tasks, uint32_t num_tasks,
+					dd_partition_report* report)
+{
+	uint8_t core_of[DD_PARTITION_MAX_TASKS + 1];
+	uint32_t utilisation[DD_PARTITION_MAX_CORES];
+	dd_part_task all_tasks[DD_PARTITION_MAX_TASKS + 1];
+	uint32_t num_all = num_tasks;
+	bool aperiodic = (config->aperiodic_interarrival != 0);
+
+	if (config->num_cores == 0 || config->num_cores > DD_PARTITION_MAX_CORES || num_tasks > DD_PARTITION_MAX_TASKS)
+	{
+		printf("ddPartitionRun: unsupported number of cores or tasks.\n");
+		return false;
+	}
+
+	// The aperiodic stream is admitted like a task with its mean load
+	memcpy(all_tasks, tasks, num_tasks * sizeof(dd_part_task));
+
+	if (aperiodic)
+	{
+		all_tasks[num_all].period = config->aperiodic_interarrival;
+		all_tasks[num_all].execution_time = config->aperiodic_execution;
+		num_all++;
+	}
+
+	part_run* run = (part_run*)calloc(1, sizeof(part_run));
+
+	if (run == NULL)
+	{
+		printf("ddPartitionRun: out of memory.\n");
+		return false;
+	}
+
+	run->config = config;
+	run->tasks = all_tasks;
+	atomic_init(&(run->stop), false);
+
+	memset(report, 0, sizeof(dd_partition_report));
+	report->num_cores = config->num_cores;
+	report->admitted = ddPartitionAssign(all_tasks, num_all, config->num_cores, core_of, utilisation);
+	report->unplaced = num_all - report->admitted;
+
+	// An aperiodic stream that did not fit is still run, from the least loaded core
+	run->aperiodic_home = 0;
+
+	if (!partCoreInit(&(run->central)))
+	{
+		printf("ddPartitionRun: out of memory.\n");
+		free(run);
+		return false;
+	}
+
+	for (uint32_t c = 0; c < config->num_cores; c++)
+	{
+		if (!partCoreInit(&(run->cores[c])))
+		{
+			printf("ddPartitionRun: out of memory.\n");
+			free(run);
+			return false;
+		}
+
+		run->cores[c].run = run;
+		run->cores[c].id = c;
+		run->cores[c].utilisation = utilisation[c];
+
+		if (utilisation[c] < utilisation[run->aperiodic_home]) run->aperiodic_home = c;
+	}
+
+	if (aperiodic && core_of[num_tasks] != DD_PARTITION_UNPLACED)
+	{
+		run->aperiodic_home = core_of[num_tasks];
+	}
+
+	// Every periodic task releases its first job together, shortly after the threads start
+	dd_time_t start = ddClockNow() + 1000;
+
+	for (uint32_t i = 0; i < num_tasks; i++)
+	{
+		if (core_of[i] == DD_PARTITION_UNPLACED) continue;
+
+		part_core* core = &(run->cores[core_of[i]]);
+		core->tasks[core->num_tasks] = i;
+		core->next_release[core->num_tasks] = start;
+		core->num_tasks++;
+	}
+
+	pthread_t aperiodic_thread;
+
+	for (uint32_t c = 0; c < config->num_cores; c++)
+	{
+		pthread_create(&(run->cores[c].thread), NULL, partCoreMain, &(run->cores[c]));
+	}
+
+	if (aperiodic)
+	{
+		pthread_create(&aperiodic_thread, NULL, partAperiodicMain, run);
+	}
+
+	struct timespec duration = { (time_t)(config->duration_ms / 1000), (long)(config->duration_ms % 1000) * 1000000 };
+	nanosleep(&duration, NULL);
+	atomic_store(&(run->stop), true);
+
+	if (aperiodic)
+	{
+		pthread_join(aperiodic_thread, NULL);
+	}
+
+	for (uint32_t c = 0; c < config->num_cores; c++)
+	{
+		part_core* core = &(run->cores[c]);
+
+		pthread_mutex_lock(&(core->lock));
+		pthread_cond_signal(&(core->wake));
+		pthread_mutex_unlock(&(core->lock));
+		pthread_join(core->thread, NULL);
+
+		report->released += core->released;
+		report->completed += core->completed;
+		report->misses += core->misses;
+		report->rejected += core->rejected;
+		report->steals += core->steals;
+		report->busy[c] = (double)core->busy_us / (config->duration_ms * 1000.0);
+
+		partCoreFree(core);
+	}
+
+	report->rejected += run->central.rejected + run->aperiodic_rejected;
+	report->migrations = run->migrations;
+	partCoreFree(&(run->central));
+	report->jobs_per_second = report->completed * 1000.0 / config->duration_ms;
+
+	free(run);
+	return true;
+}
+
+void ddPartitionReport(const dd_partition_report* report)
+{
+	uint64_t finished = report->completed + report->misses;
+	double busy = 0.0;
+
+	for (uint32_t c = 0; c < report->num_cores; c++)
+	{
+		busy += report->busy[c];
+	}
+
+	printf("%5u %8u %8u %12.1f %9.2f %10llu %8llu %9.2f\n", (unsigned int)report->num_cores,
+			(unsigned int)report->admitted, (unsigned int)report->unplaced, report->jobs_per_second,
+			(finished == 0) ? 0.0 : 100.0 * report->misses / finished,
+			(unsigned long long)report->migrations, (unsigned long long)report->steals, busy / report->num_cores);
+}
+
+#endif /* HOST_BUILD */
@@ -0,0 +1,93 @@
+/*
+ * dd_partition.h
+ *
+ * Partitioned EDF for multi-core runs of the DD scheduler (host build only).
+ * Each simulated core is a pthread with its own run queue, a slot table and
+ * deadline-ordered slot list from dd_jobs.h, guarded by a per-core lock.
+ * Periodic tasks are bound to a core at admission by first-fit decreasing
+ * bin packing on utilisation, so a core never needs another core's lock to
+ * run. Aperiodic jobs arrive as a Poisson stream and are placed by one of
+ * the dd_aperiodic_policy policies below.
+ *
+ * Under DD_APERIODIC_STEAL the aperiodic jobs are scheduled globally: they
+ * queue on a lock-free deque per core, each core runs whichever of its own
+ * deque and run queue has the earlier deadline, and an idle core steals
+ * from the core whose oldest queued job has the earliest deadline.
+ *
+ * Jobs execute by spinning, and execution is charged in thread CPU time so
+ * that an oversubscribed host shows up as misses rather than as jobs that
+ * finish early.
+ */
+
+#ifndef DD_PARTITION_H_
+#define DD_PARTITION_H_
+
+#ifdef HOST_BUILD
+
+#include "dd_clock.h"
+
+#define DD_PARTITION_MAX_CORES		8
+#define DD_PARTITION_MAX_TASKS		64
+
+/* Jobs that can be queued on one core at once. */
+#define DD_PARTITION_CORE_SLOTS		256
+
+/* Longest a core runs one job before checking for releases and preemption. */
+#define DD_PARTITION_SLICE_US		200
+
+/* Aperiodic jobs that can wait on one core's deque, a power of two. */
+#define DD_PARTITION_DEQUE_SIZE		256
+
+typedef enum dd_aperiodic_policy
+{
+	DD_APERIODIC_HOME,			// Partitioned: every job runs on the core the stream was admitted on
+	DD_APERIODIC_LEAST_LOADED,	// Partitioned: each job migrates to the core with the least queued work
+	DD_APERIODIC_STEAL,			// Global: per-core lock-free deques, idle cores steal
+	DD_APERIODIC_CENTRAL		// Global: one locked queue shared by all cores, as with a single scheduler
+} dd_aperiodic_policy;
+
+typedef struct dd_part_task
+{
+	uint32_t period;			// us
+	uint32_t execution_time;	// us
+} dd_part_task;
+
+typedef struct dd_partition_config
+{
+	uint32_t num_cores;
+	uint32_t duration_ms;
+	dd_aperiodic_policy policy;
+	uint32_t aperiodic_interarrival;	// Mean us between arrivals, 0 for none
+	uint32_t aperiodic_execution;		// us
+	uint32_t aperiodic_deadline;		// Relative, us
+	uint32_t seed;
+} dd_partition_config;
+
+typedef struct dd_partition_report
+{
+	uint32_t num_cores;
+	uint32_t admitted;
+	uint32_t unplaced;			// Tasks that did not fit on any core
+	uint64_t released;
+	uint64_t completed;
+	uint64_t misses;
+	uint64_t rejected;
+	uint64_t migrations;		// Aperiodic jobs placed away from their home core
+	uint64_t steals;			// Aperiodic jobs taken from another core's deque
+	double jobs_per_second;
+	double busy[DD_PARTITION_MAX_CORES];	// Fraction of the run each core executed jobs
+} dd_partition_report;
+
+/* Marks a task that did not fit on any core. */
+#define DD_PARTITION_UNPLACED		0xFF
+
+uint32_t ddPartitionUtilisation(const dd_part_task* task);
+uint32_t ddPartitionAssign(const dd_part_task* tasks, uint32_t num_tasks, uint32_t num_cores,
+						   uint8_t* core_of, uint32_t* utilisation);
+bool ddPartitionRun(const dd_partition_config* config, const dd_part_task* tasks, uint32_t num_tasks,
+					dd_partition_report* report);
+void ddPartitionReport(const dd_partition_report* report);
+
+#endif /* HOST_BUILD */
+
+#endif /* DD_PARTITION_H_ */
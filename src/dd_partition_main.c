@@ -0,0 +1,136 @@
+/*
+ * dd_partition_main.c
+ *
+ * Scaling runs for partitioned EDF (host build only).
+ *
+ * Usage: dd_partition [-c max cores] [-d duration ms] [-s time divisor] [-a interarrival us]
+ *                     [-p home|least|steal|central|all]
+ *
+ * For each core count from 1 to the maximum, the selected DD task set is
+ * replicated once per core, with its times divided by the time divisor, and
+ * run alongside an aperiodic stream (disabled with -a 0). -p selects how
+ * aperiodic jobs are placed, see dd_aperiodic_policy; all runs every policy
+ * for each core count.
+ */
+
+#ifdef HOST_BUILD
+
+#include "dd_partition.h"
+#include "dd_task_sets.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DD_PART_TASK_ENTRY(period, execution, type, t_class)	{ (period), (execution) },
+
+static const dd_part_task task_set[] =
+{
+	DD_TASK_SET_TABLE(DD_PART_TASK_ENTRY)
+};
+
+#define TASK_SET_SIZE	( sizeof(task_set) / sizeof(task_set[0]) )
+
+static const char* const policy_names[] = { "home", "least", "steal", "central" };
+
+#define NUM_POLICIES	( sizeof(policy_names) / sizeof(policy_names[0]) )
+
+int main(int argc, char** argv)
+{
+	dd_partition_config config;
+	uint32_t max_cores = DD_PARTITION_MAX_CORES;
+	uint32_t divisor = 100;
+	uint32_t first_policy = DD_APERIODIC_HOME;
+	uint32_t last_policy = DD_APERIODIC_HOME;
+	int arg = 1;
+
+	config.num_cores = 1;
+	config.duration_ms = 2000;
+	config.policy = DD_APERIODIC_HOME;
+	config.aperiodic_interarrival = 10000;
+	config.aperiodic_execution = 500;
+	config.aperiodic_deadline = 5000;
+	config.seed = 1;
+
+	while (arg < argc && argv[arg][0] == '-')
+	{
+		if (arg + 1 >= argc)
+		{
+			break;
+		}
+
+		if (strcmp(argv[arg], "-p") == 0)
+		{
+			first_policy = 0;
+			last_policy = NUM_POLICIES - 1;
+
+			for (uint32_t p = 0; p < NUM_POLICIES; p++)
+			{
+				if (strcmp(argv[arg + 1], policy_names[p]) == 0) first_policy = last_policy = p;
+			}
+
+			if (first_policy != last_policy && strcmp(argv[arg + 1], "all") != 0) break;
+
+			arg += 2;
+			continue;
+		}
+
+		uint32_t value = (uint32_t)strtoul(argv[arg + 1], NULL, 10);
+
+		if (strcmp(argv[arg], "-c") == 0) max_cores = value;
+		else if (strcmp(argv[arg], "-d") == 0) config.duration_ms = value;
+		else if (strcmp(argv[arg], "-s") == 0) divisor = value;
+		else if (strcmp(argv[arg], "-a") == 0) config.aperiodic_interarrival = value;
+		else break;
+
+		arg += 2;
+	}
+
+	if (arg != argc || max_cores == 0 || max_cores > DD_PARTITION_MAX_CORES || divisor == 0 ||
+		max_cores * TASK_SET_SIZE > DD_PARTITION_MAX_TASKS || config.duration_ms == 0)
+	{
+		printf("Usage: %s [-c max cores <= %u] [-d duration ms] [-s time divisor] [-a interarrival us]\n"
+			   "       [-p home|least|steal|central|all]\n", argv[0], (unsigned int)DD_PARTITION_MAX_CORES);
+		return 1;
+	}
+
+	dd_part_task tasks[DD_PARTITION_MAX_TASKS];
+
+	printf("%-8s %5s %8s %8s %12s %9s %10s %8s %9s\n", "policy", "cores", "admitted", "unplaced", "jobs/s", "miss %",
+			"migrated", "steals", "busy");
+
+	for (uint32_t cores = 1; cores <= max_cores; cores++)
+	{
+		dd_partition_report report;
+		uint32_t num_tasks = 0;
+
+		for (uint32_t copy = 0; copy < cores; copy++)
+		{
+			for (uint32_t i = 0; i < TASK_SET_SIZE; i++)
+			{
+				tasks[num_tasks].period = task_set[i].period / divisor;
+				tasks[num_tasks].execution_time = task_set[i].execution_time / divisor;
+				num_tasks++;
+			}
+		}
+
+		config.num_cores = cores;
+
+		for (uint32_t p = first_policy; p <= last_policy; p++)
+		{
+			config.policy = (dd_aperiodic_policy)p;
+
+			if (!ddPartitionRun(&config, tasks, num_tasks, &report))
+			{
+				return 1;
+			}
+
+			printf("%-8s ", policy_names[p]);
+			ddPartitionReport(&report);
+		}
+	}
+
+	return 0;
+}
+
+#endif /* HOST_BUILD */
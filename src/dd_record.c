@@ -0,0 +1,152 @@
+/*
+ * dd_record.c
+ *
+ * Scheduler event log. See dd_record.h.
+ */
+
+#include "dd_record.h"
+
+bool ddRecorderInit(dd_recorder* recorder, dd_record* storage, uint32_t length)
+{
+	if (storage == NULL || length == 0 || (length & (length - 1)) != 0)
+	{
+		return false;
+	}
+
+	ddAtomicInit(&(recorder->head), 0);
+	ddAtomicInit(&(recorder->tail), 0);
+	recorder->mask = length - 1;
+	recorder->lost = 0;
+	recorder->last_time = 0;
+	recorder->records = storage;
+
+	return true;
+}
+
+static bool ddRecorderPut(dd_recorder* recorder, const dd_record* record)
+{
+	uint32_t head = ddAtomicLoad(&(recorder->head));
+
+	if (head - ddAtomicLoad(&(recorder->tail)) > recorder->mask)
+	{
+		return false;
+	}
+
+	recorder->records[head & recorder->mask] = *record;
+	ddAtomicStore(&(recorder->head), head + 1);
+	return true;
+}
+
+static uint32_t ddRecorderSpace(dd_recorder* recorder)
+{
+	return recorder->mask + 1 - (ddAtomicLoad(&(recorder->head)) - ddAtomicLoad(&(recorder->tail)));
+}
+
+void ddRecord(dd_recorder* recorder, dd_record_type type, dd_time_t now, dd_slot slot,
+			  uint8_t task_id, uint8_t t_class, uint32_t arg)
+{
+	dd_time_t delta = now - recorder->last_time;
+	uint32_t needed = 1 + (recorder->lost != 0) + (uint32_t)(delta / UINT32_MAX);
+	dd_record record = { 0, 0, DD_SLOT_NONE, 0, 0 };
+
+	// Nothing is written unless the whole step fits, so the deltas always add up
+	if (ddRecorderSpace(recorder) < needed)
+	{
+		recorder->lost++;
+		return;
+	}
+
+	if (recorder->lost != 0)
+	{
+		record.type_class = DD_RECORD_LOST;
+		record.arg = recorder->lost;
+		ddRecorderPut(recorder, &record);
+		recorder->lost = 0;
+	}
+
+	while (delta > UINT32_MAX)
+	{
+		record.type_class = DD_RECORD_TIME;
+		record.delta = UINT32_MAX;
+		record.arg = 0;
+		ddRecorderPut(recorder, &record);
+		delta -= UINT32_MAX;
+	}
+
+	record.type_class = (uint8_t)((t_class << 4) | (type & 0x0F));
+	record.task_id = task_id;
+	record.slot = slot;
+	record.delta = (uint32_t)delta;
+	record.arg = arg;
+	ddRecorderPut(recorder, &record);
+
+	recorder->last_time = now;
+}
+
+uint32_t ddRecorderDrain(dd_recorder* recorder, dd_record* out, uint32_t max)
+{
+	uint32_t tail = ddAtomicLoad(&(recorder->tail));
+	uint32_t head = ddAtomicLoad(&(recorder->head));
+	uint32_t count = 0;
+
+	while (tail != head && count < max)
+	{
+		out[count++] = recorder->records[tail & recorder->mask];
+		tail++;
+	}
+
+	ddAtomicStore(&(recorder->tail), tail);
+	return count;
+}
+
+void ddHexEncode(const void* data, uint32_t size, char* out)
+{
+	static const char digits[] = "0123456789abcdef";
+	const uint8_t* bytes = (const uint8_t*)data;
+
+	for (uint32_t i = 0; i < size; i++)
+	{
+		out[2 * i] = digits[bytes[i] >> 4];
+		out[2 * i + 1] = digits[bytes[i] & 0x0F];
+	}
+
+	out[2 * size] = '\0';
+}
+
+void ddRecordEncodeHex(const dd_record* record, char* out)
+{
+	ddHexEncode(record, sizeof(dd_record), out);
+}
+
+static int ddHexDigit(char c)
+{
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+bool ddHexDecode(const char* in, void* data, uint32_t size)
+{
+	uint8_t* bytes = (uint8_t*)data;
+
+	for (uint32_t i = 0; i < size; i++)
+	{
+		int high = ddHexDigit(in[2 * i]);
+		int low = (high < 0) ? -1 : ddHexDigit(in[2 * i + 1]);
+
+		if (low < 0)
+		{
+			return false;
+		}
+
+		bytes[i] = (uint8_t)((high << 4) | low);
+	}
+
+	return true;
+}
+
+bool ddRecordDecodeHex(const char* in, dd_record* record)
+{
+	return ddHexDecode(in, record, sizeof(dd_record));
+}
@@ -0,0 +1,85 @@
+/*
+ * dd_record.h
+ *
+ * Compact binary log of the DD scheduler's input events, for replaying a
+ * run on the host (see dd_replay.h). The scheduler records one 12-byte
+ * record per step that can change its lists: every command it handles, and
+ * every clock wakeup that moved jobs to the overdue list. Each record holds
+ * the time the step's cleanup ran, as a delta from the previous record.
+ *
+ * The log is a single producer, single consumer ring: the scheduler task
+ * writes and the monitor drains it to the console as DDLOG hex lines. When
+ * the ring is full records are dropped and a LOST record marks the gap.
+ *
+ * With each active list request the scheduler also logs one CYCLES record
+ * per hot path probe (see dd_cycles.h), unless built with DD_RELEASE.
+ *
+ * Jobs the overload policy sheds (see dd_overload.h) get a SHED record each,
+ * and jobs the budget policy aborts (see dd_budget.h) an ABORT record, after
+ * the record of the step that stopped them.
+ *
+ * No FreeRTOS dependencies, so the replayer can share it.
+ */
+
+#ifndef DD_RECORD_H_
+#define DD_RECORD_H_
+
+#include "dd_ring.h"
+#include "dd_jobs.h"
+
+typedef enum dd_record_type
+{
+	DD_RECORD_BOOT,			// arg: job slots << 16 | overdue list length << 8 | active list length
+	DD_RECORD_WAKE,			// Cleanup without a command
+	DD_RECORD_CREATE,		// arg: deadline relative to the record
+	DD_RECORD_DELETE,
+	DD_RECORD_ACTIVE,		// List requests, where the console shows a list
+	DD_RECORD_COMPLETED,
+	DD_RECORD_OVERDUE,
+	DD_RECORD_TIME,			// Only carries time, for gaps longer than a delta holds
+	DD_RECORD_LOST,			// arg: records dropped since the previous record
+	DD_RECORD_CYCLES,		// task_id: dd_cycle_probe, slot: average (saturated), arg: maximum
+	DD_RECORD_SHED,			// Moved to the overdue list by the overload policy, arg: us it had run
+	DD_RECORD_ABORT			// Moved there on running out of budget, arg: us it had run
+} dd_record_type;
+
+typedef struct __attribute__((packed)) dd_record
+{
+	uint8_t type_class;		// Type in the low nibble, task class in the high nibble
+	uint8_t task_id;
+	uint16_t slot;
+	uint32_t delta;			// us since the previous record
+	uint32_t arg;
+} dd_record;
+
+_Static_assert( sizeof(dd_record) == 12, "dd_record must stay packed" );
+
+#define DD_RECORD_TYPE(record)		( (dd_record_type)((record)->type_class & 0x0F) )
+#define DD_RECORD_CLASS(record)		( (uint8_t)((record)->type_class >> 4) )
+
+/* Characters in the hex form of one record. */
+#define DD_RECORD_HEX_LENGTH		( 2 * sizeof(dd_record) )
+
+typedef struct dd_recorder
+{
+	dd_atomic_u32 head;		// Next record to write, owned by the producer
+	dd_atomic_u32 tail;		// Next record to read, owned by the consumer
+	uint32_t mask;			// Length - 1
+	uint32_t lost;			// Dropped since the last record written
+	dd_time_t last_time;	// Time of the last record written
+	dd_record* records;
+} dd_recorder;
+
+bool ddRecorderInit(dd_recorder* recorder, dd_record* storage, uint32_t length);
+void ddRecord(dd_recorder* recorder, dd_record_type type, dd_time_t now, dd_slot slot,
+			  uint8_t task_id, uint8_t t_class, uint32_t arg);
+uint32_t ddRecorderDrain(dd_recorder* recorder, dd_record* out, uint32_t max);
+
+void ddRecordEncodeHex(const dd_record* record, char* out);
+bool ddRecordDecodeHex(const char* in, dd_record* record);
+
+/* The hex form of any packed record, also used for trace events. */
+void ddHexEncode(const void* data, uint32_t size, char* out);
+bool ddHexDecode(const char* in, void* data, uint32_t size);
+
+#endif /* DD_RECORD_H_ */
@@ -0,0 +1,267 @@
+/*
+ * dd_replay.c
+ *
+ * Host replay of the DD scheduler's event log. See dd_replay.h.
+ */
+
+#ifdef HOST_BUILD
+
+#include "dd_replay.h"
+#include "dd_cycles.h"
+
+DD_JOB_TABLE_DEFINE(replay_table, DD_REPLAY_MAX_SLOTS);
+
+static const char* const list_titles[] = { "Active", "Completed", "Overdue" };
+
+#define DD_CYCLE_PROBE_NAME(probe, name)	name,
+
+static const char* const probe_names[DD_CYCLE_PROBE_COUNT] =
+{
+	DD_CYCLE_PROBE_TABLE(DD_CYCLE_PROBE_NAME)
+};
+
+void ddReplayInit(dd_replay* replay, FILE* out)
+{
+	ddJobTableInit(&replay_table);
+	ddSlotListInit(&(replay->active_list));
+	ddSlotListInit(&(replay->completed_list));
+	ddSlotListInit(&(replay->overdue_list));
+	memset(replay->task_id, 0, sizeof(replay->task_id));
+	memset(&(replay->report), 0, sizeof(replay->report));
+
+	replay->now = 0;
+	replay->booted = false;
+	replay->max_slots = DD_REPLAY_MAX_SLOTS;
+	replay->overdue_max = UINT32_MAX;
+	replay->task_range = UINT32_MAX;
+	replay->out = out;
+}
+
+static void replayTrimOverdue(dd_replay* replay)
+{
+	while (replay->overdue_list.list_length > replay->overdue_max)
+	{
+		ddSlotListRemove(&replay_table, &(replay->overdue_list), replay->overdue_list.list_head);
+	}
+}
+
+/* Mirrors schedulerCleanup(): expire missed jobs, then trim the overdue list. */
+static void replayCleanup(dd_replay* replay)
+{
+	replay->report.misses += ddSlotListExpire(&replay_table, &(replay->active_list), &(replay->overdue_list),
+											  replay->now, NULL, NULL);
+	replayTrimOverdue(replay);
+}
+
+/* Prints a list the way printDDTaskList() does on the target. */
+static void replayPrintList(dd_replay* replay, const dd_slot_list* list, const char* title)
+{
+	if (replay->out == NULL)
+	{
+		return;
+	}
+
+	fprintf(replay->out, "%s Task List: \n", title);
+
+	if (list->list_length == 0)
+	{
+		fprintf(replay->out, "List is empty.\n");
+	}
+
+	for (dd_slot cur_slot = list->list_head; cur_slot != DD_SLOT_NONE; cur_slot = replay_table.next[cur_slot])
+	{
+		fprintf(replay->out, "Task ID = %u, Deadline = %u ms \n", (unsigned int)replay->task_id[cur_slot],
+				(unsigned int)(replay_table.deadline[cur_slot] / 1000));
+	}
+
+	fprintf(replay->out, "\n");
+}
+
+static void replayCreate(dd_replay* replay, const dd_record* record)
+{
+	dd_slot slot = record->slot;
+
+	if (slot >= replay->max_slots || replay_table.linked[slot])
+	{
+		replay->report.errors++;
+		return;
+	}
+
+	// Mirrors taskListInsert(), which turns jobs away once every priority level is taken
+	if (replay->active_list.list_length >= replay->task_range)
+	{
+		replay->report.rejected++;
+		return;
+	}
+
+	replay_table.deadline[slot] = replay->now + (dd_time_t)(int64_t)(int32_t)record->arg;
+	replay_table.t_class[slot] = DD_RECORD_CLASS(record);
+	replay->task_id[slot] = record->task_id;
+	ddSlotListInsertOrdered(&replay_table, &(replay->active_list), slot);
+}
+
+static void replayDelete(dd_replay* replay, const dd_record* record)
+{
+	dd_slot slot = record->slot;
+
+	// Mirrors schedulerComplete(), which only logs jobs still in the active list
+	if (slot >= replay->max_slots || !ddSlotListContains(&replay_table, &(replay->active_list), slot))
+	{
+		replay->report.errors++;
+		return;
+	}
+
+	ddSlotListRemove(&replay_table, &(replay->active_list), slot);
+}
+
+/* Mirrors taskListDrop(), part of the step recorded just before. */
+static void replayDrop(dd_replay* replay, const dd_record* record)
+{
+	dd_slot slot = record->slot;
+
+	if (slot >= replay->max_slots || !ddSlotListContains(&replay_table, &(replay->active_list), slot))
+	{
+		replay->report.errors++;
+		return;
+	}
+
+	ddSlotListRemove(&replay_table, &(replay->active_list), slot);
+	ddSlotListPushBack(&replay_table, &(replay->overdue_list), slot);
+	replayTrimOverdue(replay);
+
+	if (DD_RECORD_TYPE(record) == DD_RECORD_SHED) replay->report.shed++;
+	else replay->report.aborted++;
+}
+
+void ddReplayStep(dd_replay* replay, const dd_record* record)
+{
+	dd_record_type type = DD_RECORD_TYPE(record);
+
+	replay->now += record->delta;
+	replay->report.records++;
+
+	if (replay->report.records == 1)
+	{
+		replay->report.first_time = replay->now;
+	}
+
+	replay->report.last_time = replay->now;
+
+	if (type == DD_RECORD_BOOT)
+	{
+		// A reset on the target starts a new run, with fresh lists
+		dd_time_t now = replay->now;
+		dd_replay_report report = replay->report;
+
+		ddReplayInit(replay, replay->out);
+		replay->now = now;
+		replay->report = report;
+		replay->booted = true;
+		replay->max_slots = record->arg >> 16;
+		replay->overdue_max = (record->arg >> 8) & 0xFF;
+		replay->task_range = record->arg & 0xFF;
+
+		if (replay->max_slots > DD_REPLAY_MAX_SLOTS)
+		{
+			replay->max_slots = DD_REPLAY_MAX_SLOTS;
+			replay->report.errors++;
+		}
+
+		return;
+	}
+
+	if (type == DD_RECORD_TIME)
+	{
+		return;
+	}
+
+	if (type == DD_RECORD_LOST)
+	{
+		replay->report.lost += record->arg;
+		return;
+	}
+
+	if (type == DD_RECORD_CYCLES)
+	{
+		// Counted on the target, nothing to replay
+		if (replay->out != NULL && record->task_id < DD_CYCLE_PROBE_COUNT)
+		{
+			fprintf(replay->out, "Cycles %s: Avg = %u, Max = %u\n", probe_names[record->task_id],
+					(unsigned int)record->slot, (unsigned int)record->arg);
+		}
+
+		return;
+	}
+
+	if (type == DD_RECORD_SHED || type == DD_RECORD_ABORT)
+	{
+		replayDrop(replay, record);
+		return;
+	}
+
+	// Completions are handled before the cleanup of their pass, see schedulerComplete()
+	if (type == DD_RECORD_DELETE)
+	{
+		replayDelete(replay, record);
+		replay->report.commands++;
+		return;
+	}
+
+	// Every other record is one step of the scheduler loop
+	replayCleanup(replay);
+
+	switch (type)
+	{
+		case DD_RECORD_WAKE:
+			replay->report.wakes++;
+			return;
+
+		case DD_RECORD_CREATE:
+			replayCreate(replay, record);
+			break;
+
+		case DD_RECORD_ACTIVE:
+			replayPrintList(replay, &(replay->active_list), list_titles[0]);
+			break;
+
+		case DD_RECORD_COMPLETED:
+			replayPrintList(replay, &(replay->completed_list), list_titles[1]);
+			break;
+
+		case DD_RECORD_OVERDUE:
+			replayPrintList(replay, &(replay->overdue_list), list_titles[2]);
+			break;
+
+		default:
+			replay->report.errors++;
+			return;
+	}
+
+	replay->report.commands++;
+}
+
+void ddReplayReport(const dd_replay_report* report)
+{
+	double simulated = (double)(report->last_time - report->first_time) / 1e6;
+
+	printf("Records = %llu, Commands = %llu, Wakeups = %llu, Misses = %llu, Shed = %llu, Aborted = %llu, Rejected = %llu\n",
+		   (unsigned long long)report->records, (unsigned long long)report->commands,
+		   (unsigned long long)report->wakes, (unsigned long long)report->misses,
+		   (unsigned long long)report->shed, (unsigned long long)report->aborted,
+		   (unsigned long long)report->rejected);
+	printf("Simulated = %.3f s, Replayed in %.3f s, Speedup = %.0fx\n", simulated, report->wall_seconds,
+		   (report->wall_seconds > 0.0) ? simulated / report->wall_seconds : 0.0);
+
+	if (report->lost > 0)
+	{
+		printf("Incomplete log: the target dropped %llu records, lists after the gap may differ\n",
+			   (unsigned long long)report->lost);
+	}
+
+	if (report->errors > 0)
+	{
+		printf("Inconsistent log: %llu records did not fit the replayed lists\n", (unsigned long long)report->errors);
+	}
+}
+
+#endif /* HOST_BUILD */
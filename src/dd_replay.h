@@ -0,0 +1,66 @@
+/*
+ * dd_replay.h
+ *
+ * Replays a DD scheduler event log (see dd_record.h) on the host (host build
+ * only). The job lists are rebuilt in the recorded job slots with the same
+ * dd_jobs.h list operations the scheduler task uses, and each recorded step
+ * runs the scheduler's cleanup at the recorded time before applying its
+ * command, except a completion, which the scheduler handles before any
+ * cleanup. The active and overdue lists go through the same states as they
+ * did on the target. The list requests print the lists in the format
+ * of the target console, so a replay can be compared against a capture.
+ *
+ * Nothing waits on a clock, so a replay runs as fast as the records can be
+ * read.
+ */
+
+#ifndef DD_REPLAY_H_
+#define DD_REPLAY_H_
+
+#ifdef HOST_BUILD
+
+#include <stdio.h>
+
+#include "dd_record.h"
+
+/* Job slots the replayer can track, at least the target's DD_MAX_JOBS. */
+#define DD_REPLAY_MAX_SLOTS		1024
+
+typedef struct dd_replay_report
+{
+	uint64_t records;
+	uint64_t commands;		// CREATE, DELETE and list requests
+	uint64_t wakes;
+	uint64_t misses;		// Jobs moved to the overdue list at their deadline
+	uint64_t shed;			// Jobs moved there early by the overload policy
+	uint64_t aborted;		// Jobs moved there on running out of budget
+	uint64_t rejected;		// CREATEs the full active list turned away
+	uint64_t lost;			// Records the target dropped
+	uint64_t errors;		// Records that do not fit the lists as replayed
+	dd_time_t first_time;
+	dd_time_t last_time;
+	double wall_seconds;
+} dd_replay_report;
+
+typedef struct dd_replay
+{
+	dd_time_t now;
+	bool booted;
+	uint32_t max_slots;
+	uint32_t overdue_max;
+	uint32_t task_range;
+	dd_slot_list active_list;
+	dd_slot_list completed_list;
+	dd_slot_list overdue_list;
+	uint8_t task_id[DD_REPLAY_MAX_SLOTS];
+	FILE* out;				// Where list requests are printed, NULL for none
+	dd_replay_report report;
+} dd_replay;
+
+void ddReplayInit(dd_replay* replay, FILE* out);
+void ddReplayStep(dd_replay* replay, const dd_record* record);
+void ddReplayReport(const dd_replay_report* report);
+
+#endif /* HOST_BUILD */
+
+#endif /* DD_REPLAY_H_ */
@@ -0,0 +1,124 @@
+/*
+ * dd_replay_main.c
+ *
+ * Replays a DD scheduler event log (host build only).
+ *
+ * Usage: dd_replay [-b] [-q] [file]
+ *
+ * Reads a console capture from the file, or stdin, and replays every
+ * "DDLOG" line in it; other lines are ignored. -b reads raw dd_record
+ * structures instead. -q skips printing the lists, for timing long captures.
+ */
+
+#ifdef HOST_BUILD
+
+#include "dd_replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DD_REPLAY_LINE_LENGTH	4096
+
+static const char log_prefix[] = "DDLOG ";
+
+static double replayWallSeconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static void replayText(dd_replay* replay, FILE* in)
+{
+	char line[DD_REPLAY_LINE_LENGTH];
+	dd_record record;
+
+	while (fgets(line, sizeof(line), in) != NULL)
+	{
+		// The prefix may follow other console output on the same line
+		char* hex = strstr(line, log_prefix);
+
+		if (hex == NULL)
+		{
+			continue;
+		}
+
+		for (hex += strlen(log_prefix); ddRecordDecodeHex(hex, &record); hex += DD_RECORD_HEX_LENGTH)
+		{
+			ddReplayStep(replay, &record);
+		}
+	}
+}
+
+static void replayBinary(dd_replay* replay, FILE* in)
+{
+	dd_record record;
+
+	while (fread(&record, sizeof(record), 1, in) == 1)
+	{
+		ddReplayStep(replay, &record);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	static dd_replay replay;
+	bool binary = false;
+	bool quiet = false;
+	FILE* in = stdin;
+	int arg = 1;
+
+	while (arg < argc && argv[arg][0] == '-')
+	{
+		if (strcmp(argv[arg], "-b") == 0) binary = true;
+		else if (strcmp(argv[arg], "-q") == 0) quiet = true;
+		else break;
+
+		arg++;
+	}
+
+	if (arg < argc - 1 || (arg < argc && argv[arg][0] == '-'))
+	{
+		printf("Usage: %s [-b] [-q] [file]\n", argv[0]);
+		return 1;
+	}
+
+	if (arg < argc && (in = fopen(argv[arg], binary ? "rb" : "r")) == NULL)
+	{
+		printf("Cannot open %s\n", argv[arg]);
+		return 1;
+	}
+
+	ddReplayInit(&replay, quiet ? NULL : stdout);
+
+	double start = replayWallSeconds();
+
+	if (binary)
+	{
+		replayBinary(&replay, in);
+	}
+	else
+	{
+		replayText(&replay, in);
+	}
+
+	replay.report.wall_seconds = replayWallSeconds() - start;
+
+	if (in != stdin)
+	{
+		fclose(in);
+	}
+
+	if (!replay.booted)
+	{
+		printf("No BOOT record, the capture started mid-run\n");
+	}
+
+	ddReplayReport(&replay.report);
+	return (replay.report.errors == 0) ? 0 : 2;
+}
+
+#endif /* HOST_BUILD */
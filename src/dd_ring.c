@@ -0,0 +1,170 @@
+/*
+ * dd_ring.c
+ *
+ * Non-blocking MPSC ring for scheduler submissions. See dd_ring.h.
+ *
+ * Slot i starts with sequence number i. A producer that claims position pos
+ * writes its item and then sets the sequence to pos + 1, which tells the
+ * consumer the item is ready. After reading it the consumer sets the sequence
+ * to pos + capacity, which hands the slot to the producer one lap later.
+ *
+ * A producer stopped between claiming a slot and publishing it would leave
+ * the consumer waiting at that slot for good. DD tasks are suspended and
+ * deleted by other tasks and by the budget interrupt, so on the target the
+ * push runs in a critical section. It only covers the claim and the copy of
+ * one item, and the producer still never blocks.
+ */
+
+#include "dd_ring.h"
+
+#include <stdio.h>
+
+#ifdef HOST_BUILD
+
+#include <pthread.h>
+
+/* A thread cannot be cancelled inside a push, which stands in for the critical section. */
+static inline int ddRingEnterPush(void)
+{
+	int state;
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &state);
+	return state;
+}
+
+static inline void ddRingExitPush(int state)
+{
+	pthread_setcancelstate(state, NULL);
+}
+
+#else
+
+#include "../FreeRTOS_Source/include/FreeRTOS.h"
+#include "../FreeRTOS_Source/include/task.h"
+
+static inline int ddRingEnterPush(void)
+{
+	taskENTER_CRITICAL();
+	return 0;
+}
+
+static inline void ddRingExitPush(int state)
+{
+	(void)state;
+	taskEXIT_CRITICAL();
+}
+
+#endif /* HOST_BUILD */
+
+static inline dd_atomic_u32* ddRingSequence(dd_ring* ring, uint32_t pos)
+{
+	return (dd_atomic_u32*)(ring->storage + (pos & ring->mask) * ring->stride);
+}
+
+static inline uint8_t* ddRingItem(dd_ring* ring, uint32_t pos)
+{
+	return ring->storage + (pos & ring->mask) * ring->stride + sizeof(dd_atomic_u32);
+}
+
+bool ddRingInit(dd_ring* ring, void* storage, uint32_t capacity, uint32_t item_size)
+{
+	if ((ring == NULL) || (storage == NULL))
+	{
+		printf("ddRingInit: ring or storage passed in was NULL.\n");
+		return false;
+	}
+
+	if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+	{
+		printf("ddRingInit: capacity must be a power of two.\n");
+		return false;
+	}
+
+	ring->head = 0;
+	ring->mask = capacity - 1;
+	ring->item_size = item_size;
+	ring->stride = DD_RING_STRIDE(item_size);
+	ring->storage = (uint8_t*)storage;
+	ddAtomicInit(&(ring->tail), 0);
+	ddAtomicInit(&(ring->consumer_waiting), 0);
+
+	for (uint32_t i = 0; i < capacity; i++)
+	{
+		ddAtomicInit(ddRingSequence(ring, i), i);
+	}
+
+	return true;
+}
+
+dd_ring_status ddRingPush(dd_ring* ring, const void* item)
+{
+	int state = ddRingEnterPush();
+	uint32_t pos = ddAtomicLoad(&(ring->tail));
+
+	while (1)
+	{
+		uint32_t seq = ddAtomicLoad(ddRingSequence(ring, pos));
+		int32_t diff = (int32_t)(seq - pos);
+
+		if (diff == 0)
+		{
+			// The slot is free for this lap, try to claim it
+			if (ddAtomicCompareAndSwap(&(ring->tail), pos, pos + 1))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			// The consumer has not freed this slot yet
+			ddRingExitPush(state);
+			return DD_RING_FULL;
+		}
+
+		// Another producer got there first
+		pos = ddAtomicLoad(&(ring->tail));
+	}
+
+	memcpy(ddRingItem(ring, pos), item, ring->item_size);
+	ddAtomicStore(ddRingSequence(ring, pos), pos + 1);
+	ddRingExitPush(state);
+
+	// Only the first producer to find the consumer asleep has to wake it
+	return (ddAtomicExchange(&(ring->consumer_waiting), 0) != 0) ? DD_RING_WAKE : DD_RING_OK;
+}
+
+bool ddRingPop(dd_ring* ring, void* item)
+{
+	uint32_t pos = ring->head;
+	uint32_t seq = ddAtomicLoad(ddRingSequence(ring, pos));
+
+	if (seq != pos + 1)
+	{
+		return false;
+	}
+
+	memcpy(item, ddRingItem(ring, pos), ring->item_size);
+	ddAtomicStore(ddRingSequence(ring, pos), pos + ring->mask + 1);
+	ring->head = pos + 1;
+
+	return true;
+}
+
+/*
+ * Called by the consumer when the ring looked empty. Returns true if the
+ * consumer should now block until it is woken, or false if an item arrived in
+ * the meantime and it should keep reading.
+ */
+bool ddRingPrepareWait(dd_ring* ring)
+{
+	// An exchange rather than a store, so that it is ordered against the producers' exchanges
+	ddAtomicExchange(&(ring->consumer_waiting), 1);
+
+	// A producer may have published between the failed pop and setting the flag
+	if (ddAtomicLoad(ddRingSequence(ring, ring->head)) == ring->head + 1)
+	{
+		// Take the flag back; if a producer already took it, it will send a wakeup we must absorb
+		return ddAtomicExchange(&(ring->consumer_waiting), 0) == 0;
+	}
+
+	return true;
+}
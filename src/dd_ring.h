@@ -0,0 +1,138 @@
+/*
+ * dd_ring.h
+ *
+ * Bounded, non-blocking, multi-producer single-consumer ring used to submit
+ * commands to the DD scheduler. Producers claim a slot with a compare and
+ * swap on the tail and publish it through a per-slot sequence number, so
+ * producers never block. On the target the claim and publish share one
+ * short critical section, so a producer cannot be stopped in between.
+ *
+ * The consumer only needs waking when it has gone to sleep on an empty ring,
+ * so at most one wakeup is requested per batch of submissions: ddRingPush
+ * returns DD_RING_WAKE to the producer that should notify it.
+ *
+ * The atomics are LDREX/STREX on the target and C11 atomics on the host build.
+ */
+
+#ifndef DD_RING_H_
+#define DD_RING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef HOST_BUILD
+
+#include <stdatomic.h>
+
+typedef _Atomic uint32_t dd_atomic_u32;
+
+static inline uint32_t ddAtomicLoad(dd_atomic_u32* ptr)
+{
+	return (uint32_t)atomic_load_explicit(ptr, memory_order_acquire);
+}
+
+static inline void ddAtomicStore(dd_atomic_u32* ptr, uint32_t value)
+{
+	atomic_store_explicit(ptr, value, memory_order_release);
+}
+
+static inline bool ddAtomicCompareAndSwap(dd_atomic_u32* ptr, uint32_t expected, uint32_t desired)
+{
+	uint32_t old = expected;
+	return atomic_compare_exchange_strong_explicit(ptr, &old, desired, memory_order_acq_rel, memory_order_relaxed);
+}
+
+static inline uint32_t ddAtomicExchange(dd_atomic_u32* ptr, uint32_t value)
+{
+	return (uint32_t)atomic_exchange_explicit(ptr, value, memory_order_acq_rel);
+}
+
+static inline void ddAtomicInit(dd_atomic_u32* ptr, uint32_t value)
+{
+	atomic_init(ptr, value);
+}
+
+#else
+
+#include "stm32f4xx.h"
+
+typedef volatile uint32_t dd_atomic_u32;
+
+static inline uint32_t ddAtomicLoad(dd_atomic_u32* ptr)
+{
+	uint32_t value = *ptr;
+	__DMB();
+	return value;
+}
+
+static inline void ddAtomicStore(dd_atomic_u32* ptr, uint32_t value)
+{
+	__DMB();
+	*ptr = value;
+}
+
+static inline bool ddAtomicCompareAndSwap(dd_atomic_u32* ptr, uint32_t expected, uint32_t desired)
+{
+	// STREX fails if anything (including an exception) touched the monitor since LDREX, so retry
+	do
+	{
+		if (__LDREXW(ptr) != expected)
+		{
+			__CLREX();
+			return false;
+		}
+	} while (__STREXW(desired, ptr) != 0);
+
+	__DMB();
+	return true;
+}
+
+static inline uint32_t ddAtomicExchange(dd_atomic_u32* ptr, uint32_t value)
+{
+	uint32_t old;
+
+	do
+	{
+		old = __LDREXW(ptr);
+	} while (__STREXW(value, ptr) != 0);
+
+	__DMB();
+	return old;
+}
+
+static inline void ddAtomicInit(dd_atomic_u32* ptr, uint32_t value)
+{
+	*ptr = value;
+}
+
+#endif /* HOST_BUILD */
+
+/* Each slot holds its sequence number followed by the item, padded to 4 bytes. */
+#define DD_RING_STRIDE(item_size)					( sizeof(dd_atomic_u32) + ( ( (item_size) + 3 ) & ~3UL ) )
+#define DD_RING_STORAGE_SIZE(capacity, item_size)	( (capacity) * DD_RING_STRIDE(item_size) )
+
+typedef enum dd_ring_status
+{
+	DD_RING_FULL,	// Nothing was written
+	DD_RING_OK,		// Written, the consumer is awake
+	DD_RING_WAKE	// Written, and the caller must wake the consumer
+} dd_ring_status;
+
+typedef struct dd_ring
+{
+	dd_atomic_u32 tail;				// Next slot to claim, shared by the producers
+	uint32_t head;					// Next slot to read, owned by the consumer
+	dd_atomic_u32 consumer_waiting;	// Set while the consumer is, or is about to be, blocked
+	uint32_t mask;					// Capacity - 1
+	uint32_t item_size;
+	uint32_t stride;
+	uint8_t* storage;
+} dd_ring;
+
+bool ddRingInit(dd_ring* ring, void* storage, uint32_t capacity, uint32_t item_size);
+dd_ring_status ddRingPush(dd_ring* ring, const void* item);
+bool ddRingPop(dd_ring* ring, void* item);
+bool ddRingPrepareWait(dd_ring* ring);
+
+#endif /* DD_RING_H_ */
@@ -0,0 +1,406 @@
+/*
+ * dd_ring_bench.c
+ *
+ * Host benchmark for the scheduler submission ring (host build only).
+ * Compares the ring from dd_ring.c against a locked, blocking bounded queue
+ * that stands in for xQueueSend (critical section per send, producers block
+ * while the queue is full). Reports submission throughput and p99
+ * submit-to-receive latency for 3, 8 and 32 producers.
+ *
+ * It first checks that a producer stopped in the middle of pushing does not
+ * leave a claimed slot behind, and exits non-zero if one does.
+ *
+ * Usage: dd_ring_bench [items per run]
+ */
+
+#ifdef HOST_BUILD
+
+#include "dd_ring.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#define BENCH_QUEUE_LENGTH		16
+#define BENCH_STOP_ROUNDS		200
+#define BENCH_STOP_PRODUCERS	4
+
+typedef struct bench_item
+{
+	uint64_t stamp_ns;
+	uint32_t producer;
+	uint32_t sequence;
+} bench_item;
+
+typedef struct locked_queue
+{
+	pthread_mutex_t lock;
+	pthread_cond_t not_empty;
+	pthread_cond_t not_full;
+	uint32_t head;
+	uint32_t count;
+	bench_item items[BENCH_QUEUE_LENGTH];
+} locked_queue;
+
+typedef struct bench_run
+{
+	bool use_ring;
+	uint32_t num_producers;
+	uint32_t items_per_producer;
+
+	dd_ring ring;
+	sem_t ring_wakeup;
+	locked_queue queue;
+
+	uint64_t* latencies;
+	uint32_t num_latencies;
+} bench_run;
+
+static uint64_t benchNowNs(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/*-------------------------- Locked Queue -----------------------------------*/
+
+static void lockedQueueSend(locked_queue* queue, const bench_item* item)
+{
+	pthread_mutex_lock(&(queue->lock));
+
+	while (queue->count == BENCH_QUEUE_LENGTH)
+	{
+		pthread_cond_wait(&(queue->not_full), &(queue->lock));
+	}
+
+	queue->items[(queue->head + queue->count) % BENCH_QUEUE_LENGTH] = *item;
+	queue->count++;
+	pthread_cond_signal(&(queue->not_empty));
+	pthread_mutex_unlock(&(queue->lock));
+}
+
+static void lockedQueueReceive(locked_queue* queue, bench_item* item)
+{
+	pthread_mutex_lock(&(queue->lock));
+
+	while (queue->count == 0)
+	{
+		pthread_cond_wait(&(queue->not_empty), &(queue->lock));
+	}
+
+	*item = queue->items[queue->head];
+	queue->head = (queue->head + 1) % BENCH_QUEUE_LENGTH;
+	queue->count--;
+	pthread_cond_signal(&(queue->not_full));
+	pthread_mutex_unlock(&(queue->lock));
+}
+
+/*-------------------------- Producers and Consumer -------------------------*/
+
+typedef struct producer_arg
+{
+	bench_run* run;
+	uint32_t id;
+	pthread_t thread;
+} producer_arg;
+
+static void* benchProducer(void* arg)
+{
+	producer_arg* producer = (producer_arg*)arg;
+	bench_run* run = producer->run;
+	bench_item item;
+
+	item.producer = producer->id;
+
+	for (uint32_t i = 0; i < run->items_per_producer; i++)
+	{
+		item.sequence = i;
+		item.stamp_ns = benchNowNs();
+
+		if (run->use_ring)
+		{
+			dd_ring_status status;
+
+			while ((status = ddRingPush(&(run->ring), &item)) == DD_RING_FULL)
+			{
+				sched_yield();
+			}
+
+			if (status == DD_RING_WAKE)
+			{
+				sem_post(&(run->ring_wakeup));
+			}
+		}
+		else
+		{
+			lockedQueueSend(&(run->queue), &item);
+		}
+	}
+
+	return NULL;
+}
+
+static void benchConsume(bench_run* run)
+{
+	uint32_t total = run->num_producers * run->items_per_producer;
+	bench_item item;
+
+	for (uint32_t received = 0; received < total; )
+	{
+		if (run->use_ring)
+		{
+			if (!ddRingPop(&(run->ring), &item))
+			{
+				if (ddRingPrepareWait(&(run->ring)))
+				{
+					sem_wait(&(run->ring_wakeup));
+				}
+				continue;
+			}
+		}
+		else
+		{
+			lockedQueueReceive(&(run->queue), &item);
+		}
+
+		run->latencies[received++] = benchNowNs() - item.stamp_ns;
+	}
+
+	run->num_latencies = total;
+}
+
+/*-------------------------- Stopped Producers ------------------------------*/
+
+/* Large enough that most of a push is the copy between claiming and publishing. */
+typedef struct stop_item
+{
+	uint32_t sequence;
+	uint32_t payload[1023];
+} stop_item;
+
+typedef struct stop_run
+{
+	dd_ring ring;
+	atomic_flag reading;		// Held by the producer standing in for the consumer
+	uint32_t storage[DD_RING_STORAGE_SIZE(BENCH_QUEUE_LENGTH, sizeof(stop_item)) / sizeof(uint32_t)];
+} stop_run;
+
+/*
+ * The profiling timer interrupts whichever producer is running and stops it
+ * there, as vTaskDelete() or vTaskSuspend() would stop a DD task.
+ */
+static void benchStopHandler(int signal)
+{
+	(void)signal;
+	pthread_cancel(pthread_self());
+}
+
+/* Reads the ring on behalf of the consumer, so the producers keep pushing rather than finding it full. */
+static void benchStopDrain(stop_run* run)
+{
+	stop_item item;
+	int state;
+
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &state);
+
+	if (!atomic_flag_test_and_set(&(run->reading)))
+	{
+		while (ddRingPop(&(run->ring), &item))
+		{
+		}
+
+		atomic_flag_clear(&(run->reading));
+	}
+
+	pthread_setcancelstate(state, NULL);
+}
+
+static void* benchStoppedProducer(void* arg)
+{
+	stop_run* run = (stop_run*)arg;
+	static const stop_item blank;
+	stop_item item = blank;
+	sigset_t stop;
+
+	pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, NULL);
+	sigemptyset(&stop);
+	sigaddset(&stop, SIGPROF);
+	pthread_sigmask(SIG_UNBLOCK, &stop, NULL);
+
+	while (1)
+	{
+		item.sequence++;
+
+		if (ddRingPush(&(run->ring), &item) == DD_RING_FULL)
+		{
+			benchStopDrain(run);
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Producers push until a timer has stopped each of them, mostly in the
+ * middle of a push. A producer stopped between claiming a slot and
+ * publishing it leaves the consumer stuck at that slot, which shows up as
+ * the ring draining to a position short of its tail. Returns the rounds
+ * that did.
+ */
+static uint32_t benchStoppedProducers(void)
+{
+	static stop_run run;
+	pthread_t producers[BENCH_STOP_PRODUCERS];
+	struct itimerval timer = { { 0, 1000 }, { 0, 1000 } };
+	struct itimerval disarm = { { 0, 0 }, { 0, 0 } };
+	struct sigaction action;
+	sigset_t stop;
+	uint32_t stuck = 0;
+	stop_item item;
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = benchStopHandler;
+	sigaction(SIGPROF, &action, NULL);
+
+	// Only the producers take the timer signal; they inherit the mask and unblock it
+	sigemptyset(&stop);
+	sigaddset(&stop, SIGPROF);
+	pthread_sigmask(SIG_BLOCK, &stop, NULL);
+
+	for (uint32_t round = 0; round < BENCH_STOP_ROUNDS; round++)
+	{
+		ddRingInit(&(run.ring), run.storage, BENCH_QUEUE_LENGTH, sizeof(stop_item));
+		atomic_flag_clear(&(run.reading));
+
+		for (uint32_t i = 0; i < BENCH_STOP_PRODUCERS; i++)
+		{
+			pthread_create(&producers[i], NULL, benchStoppedProducer, &run);
+		}
+
+		setitimer(ITIMER_PROF, &timer, NULL);
+
+		for (uint32_t i = 0; i < BENCH_STOP_PRODUCERS; i++)
+		{
+			pthread_join(producers[i], NULL);
+		}
+
+		setitimer(ITIMER_PROF, &disarm, NULL);
+
+		while (ddRingPop(&(run.ring), &item))
+		{
+		}
+
+		if (run.ring.head != ddAtomicLoad(&(run.ring.tail)))
+		{
+			stuck++;
+		}
+	}
+
+	pthread_sigmask(SIG_UNBLOCK, &stop, NULL);
+	printf("Stopped producers: %u of %u rounds left a claimed slot unpublished\n", (unsigned int)stuck,
+		   (unsigned int)BENCH_STOP_ROUNDS);
+	return stuck;
+}
+
+/*-------------------------- Throughput -------------------------------------*/
+
+static int compareLatency(const void* a, const void* b)
+{
+	uint64_t x = *(const uint64_t*)a;
+	uint64_t y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+static bool benchRun(bool use_ring, uint32_t num_producers, uint32_t total_items)
+{
+	bench_run run;
+	uint32_t ring_storage[DD_RING_STORAGE_SIZE(BENCH_QUEUE_LENGTH, sizeof(bench_item)) / sizeof(uint32_t)];
+
+	run.use_ring = use_ring;
+	run.num_producers = num_producers;
+	run.items_per_producer = total_items / num_producers;
+	run.latencies = (uint64_t*)malloc(num_producers * run.items_per_producer * sizeof(uint64_t));
+	producer_arg* producers = (producer_arg*)calloc(num_producers, sizeof(producer_arg));
+
+	if (run.latencies == NULL || producers == NULL)
+	{
+		printf("benchRun: out of memory.\n");
+		free(run.latencies);
+		free(producers);
+		return false;
+	}
+
+	ddRingInit(&(run.ring), ring_storage, BENCH_QUEUE_LENGTH, sizeof(bench_item));
+	sem_init(&(run.ring_wakeup), 0, 0);
+	pthread_mutex_init(&(run.queue.lock), NULL);
+	pthread_cond_init(&(run.queue.not_empty), NULL);
+	pthread_cond_init(&(run.queue.not_full), NULL);
+	run.queue.head = 0;
+	run.queue.count = 0;
+
+	uint64_t start = benchNowNs();
+
+	for (uint32_t i = 0; i < num_producers; i++)
+	{
+		producers[i].run = &run;
+		producers[i].id = i;
+		pthread_create(&(producers[i].thread), NULL, benchProducer, &producers[i]);
+	}
+
+	benchConsume(&run);
+
+	for (uint32_t i = 0; i < num_producers; i++)
+	{
+		pthread_join(producers[i].thread, NULL);
+	}
+
+	uint64_t elapsed = benchNowNs() - start;
+
+	qsort(run.latencies, run.num_latencies, sizeof(uint64_t), compareLatency);
+
+	printf("%-12s %9u %14.0f %12.1f %12.1f\n", use_ring ? "ring" : "locked queue", (unsigned int)num_producers,
+			(double)run.num_latencies * 1e9 / (double)elapsed,
+			run.latencies[run.num_latencies / 2] / 1000.0,
+			run.latencies[(uint32_t)((uint64_t)run.num_latencies * 99 / 100)] / 1000.0);
+
+	sem_destroy(&(run.ring_wakeup));
+	pthread_mutex_destroy(&(run.queue.lock));
+	pthread_cond_destroy(&(run.queue.not_empty));
+	pthread_cond_destroy(&(run.queue.not_full));
+	free(run.latencies);
+	free(producers);
+	return true;
+}
+
+/*-------------------------- Main -------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+	static const uint32_t producer_counts[] = {3, 8, 32};
+	uint32_t total_items = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000000;
+
+	if (benchStoppedProducers() > 0)
+	{
+		return 1;
+	}
+
+	printf("%-12s %9s %14s %12s %12s\n", "channel", "producers", "items/s", "p50 us", "p99 us");
+
+	for (uint32_t i = 0; i < sizeof(producer_counts) / sizeof(producer_counts[0]); i++)
+	{
+		if (!benchRun(false, producer_counts[i], total_items)) return 1;
+		if (!benchRun(true, producer_counts[i], total_items)) return 1;
+	}
+
+	return 0;
+}
+
+#endif /* HOST_BUILD */
@@ -0,0 +1,53 @@
+/*
+ * dd_slack.c
+ *
+ * EDF slack for background work. See dd_slack.h.
+ */
+
+#include "dd_slack.h"
+
+/* Adds a job to lists sorted by relative deadline, after any with the same deadline. Returns the new count. */
+uint32_t ddSlackInsert(uint32_t* deadlines, uint32_t* demands, uint32_t count, uint32_t deadline, uint32_t demand)
+{
+	uint32_t pos = count;
+
+	while (pos > 0 && deadlines[pos - 1] > deadline)
+	{
+		deadlines[pos] = deadlines[pos - 1];
+		demands[pos] = demands[pos - 1];
+		pos--;
+	}
+
+	deadlines[pos] = deadline;
+	demands[pos] = demand;
+	return count + 1;
+}
+
+/*
+ * Returns the slack of jobs given in deadline order, with deadlines relative
+ * to now and demands of execution left, all in the same unit, or
+ * DD_SLACK_UNBOUNDED if there are none.
+ */
+uint32_t ddSlack(const uint32_t* deadlines, const uint32_t* demands, uint32_t count)
+{
+	uint32_t slack = DD_SLACK_UNBOUNDED;
+	uint32_t demand = 0;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		demand += demands[i];
+
+		// A deadline that is already passed or cannot be met leaves no slack at all
+		if ((int32_t)deadlines[i] <= 0 || demand >= deadlines[i])
+		{
+			return 0;
+		}
+
+		if (deadlines[i] - demand < slack)
+		{
+			slack = deadlines[i] - demand;
+		}
+	}
+
+	return slack;
+}
@@ -0,0 +1,24 @@
+/*
+ * dd_slack.h
+ *
+ * EDF slack for background work. The jobs that are due, the active ones and
+ * the next release of every generator, are taken in deadline order, and the
+ * slack is the smallest gap between a deadline and the work that has to be
+ * done by it. Work that fits in that gap can run ahead of every job without
+ * any of them missing its deadline.
+ *
+ * No FreeRTOS dependencies, so the host benchmark (dd_slack_bench.c) runs
+ * the same computation.
+ */
+
+#ifndef DD_SLACK_H_
+#define DD_SLACK_H_
+
+#include <stdint.h>
+
+#define DD_SLACK_UNBOUNDED	UINT32_MAX
+
+uint32_t ddSlackInsert(uint32_t* deadlines, uint32_t* demands, uint32_t count, uint32_t deadline, uint32_t demand);
+uint32_t ddSlack(const uint32_t* deadlines, const uint32_t* demands, uint32_t count);
+
+#endif /* DD_SLACK_H_ */
@@ -0,0 +1,328 @@
+/*
+ * dd_slack_bench.c
+ *
+ * Host check for slack stealing (host build only). Random periodic task
+ * sets at 90% to 99% utilisation are run under EDF in a simulation with
+ * 1 us steps, once on their own and once with background jobs run the way
+ * runBackgroundJobs() runs them from the idle hook:
+ *
+ *   - A background job is due once its period has passed since it last ran,
+ *     and runs only when the slack from dd_slack.c, in whole ticks, exceeds
+ *     its WCET in ticks. Otherwise it is deferred.
+ *   - Once started it runs for its whole WCET without being preempted, as if
+ *     it kept the scheduler suspended. Jobs released meanwhile wait for it.
+ *
+ * Jobs still running at their deadline are stopped, as on the target, and
+ * counted as missed. The check fails if background work causes a single
+ * miss in a task set that has none on its own.
+ *
+ * Usage: dd_slack_bench [sets] [seconds per set]
+ */
+
+#ifdef HOST_BUILD
+
+#include "dd_slack.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_TASKS				6
+#define BENCH_NONE				( -1 )
+#define BENCH_US_PER_TICK		1000
+
+typedef struct bench_task
+{
+	/* Task parameters, us */
+	uint32_t period;
+	uint32_t execution;
+
+	/* Current job */
+	bool active;
+	uint64_t deadline;
+	uint64_t next_release;
+	uint32_t executed;
+} bench_task;
+
+/* Background work, in ticks like registerBackgroundJob(). */
+typedef struct bench_background
+{
+	uint32_t wcet;
+	uint32_t period;
+	uint64_t last_run;
+	uint32_t runs;
+	uint32_t deferrals;
+} bench_background;
+
+typedef struct bench_result
+{
+	uint64_t jobs;
+	uint64_t missed;
+	uint64_t runs;
+	uint64_t deferrals;
+	uint64_t background;			// us run by background jobs
+	uint64_t time;					// us simulated
+} bench_result;
+
+static const bench_background background_defaults[] =
+{
+	{ 1, 100, 0, 0, 0 },		// The heap check registered by main()
+	{ 1, 10, 0, 0, 0 },
+	{ 3, 250, 0, 0, 0 },
+};
+
+#define BENCH_BACKGROUND_COUNT	( sizeof(background_defaults) / sizeof(background_defaults[0]) )
+
+static uint32_t benchRandom(uint32_t* state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+/* Uniform in [low, high]. */
+static uint32_t benchRange(uint32_t* state, uint32_t low, uint32_t high)
+{
+	return low + benchRandom(state) % (high - low + 1);
+}
+
+/*-------------------------- Task Sets --------------------------------------*/
+
+/* Draws a task set with the given total utilisation (UUniFast, redrawn until no task exceeds 1). */
+static void benchMakeTaskSet(uint32_t* rng, bench_task* tasks, uint32_t count, double utilisation)
+{
+	double shares[BENCH_TASKS];
+	bool valid;
+
+	do
+	{
+		double remaining = utilisation;
+
+		valid = true;
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			shares[i] = remaining;
+
+			if (i + 1 < count)
+			{
+				double r = (double)(benchRandom(rng) % 1000000) / 1000000.0;
+				double next = remaining * pow(r, 1.0 / (count - 1 - i));
+
+				shares[i] = remaining - next;
+				remaining = next;
+			}
+
+			if (shares[i] > 1.0) valid = false;
+		}
+	} while (!valid);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		bench_task* task = &tasks[i];
+
+		memset(task, 0, sizeof(*task));
+
+		// Periods in whole ticks, like the generators
+		task->period = benchRange(rng, 5, 100) * BENCH_US_PER_TICK;
+		task->execution = (uint32_t)(shares[i] * task->period);
+		if (task->execution < 20) task->execution = 20;
+		if (task->execution > task->period) task->execution = task->period;
+		task->next_release = benchRandom(rng) % task->period;
+	}
+}
+
+/*-------------------------- Simulation -------------------------------------*/
+
+/* The slack in ticks, computed as ddAvailableSlack() does. */
+static uint32_t benchSlackTicks(const bench_task* tasks, uint32_t count, uint64_t now)
+{
+	uint32_t deadlines[2 * BENCH_TASKS];
+	uint32_t demands[2 * BENCH_TASKS];
+	uint32_t jobs = 0;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const bench_task* task = &tasks[i];
+
+		if (task->active)
+		{
+			jobs = ddSlackInsert(deadlines, demands, jobs, (uint32_t)(task->deadline - now), task->execution - task->executed);
+		}
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const bench_task* task = &tasks[i];
+
+		jobs = ddSlackInsert(deadlines, demands, jobs, (uint32_t)(task->next_release - now) + task->period, task->execution);
+	}
+
+	uint32_t slack = ddSlack(deadlines, demands, jobs);
+
+	return (slack == DD_SLACK_UNBOUNDED) ? UINT32_MAX : slack / BENCH_US_PER_TICK;
+}
+
+/* Runs the idle hook once. Returns the us of background work it started. */
+static uint32_t benchIdleHook(const bench_task* tasks, uint32_t count, bench_background* background, uint32_t background_count,
+							  uint64_t now)
+{
+	for (uint32_t i = 0; i < background_count; i++)
+	{
+		bench_background* job = &background[i];
+
+		if (job->runs != 0 && now - job->last_run < (uint64_t)job->period * BENCH_US_PER_TICK)
+		{
+			continue;
+		}
+
+		if (benchSlackTicks(tasks, count, now) <= job->wcet)
+		{
+			job->deferrals++;
+			continue;
+		}
+
+		job->last_run = now;
+		job->runs++;
+		return job->wcet * BENCH_US_PER_TICK;
+	}
+
+	return 0;
+}
+
+static void benchRun(bench_task* tasks, uint32_t count, bench_background* background, uint32_t background_count,
+					 uint64_t duration, bench_result* result)
+{
+	uint32_t busy = 0;				// us left of the background job running
+
+	for (uint64_t now = 0; now < duration; now++)
+	{
+		int32_t pick = BENCH_NONE;
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			bench_task* task = &tasks[i];
+
+			if (task->active && task->deadline <= now)
+			{
+				task->active = false;
+				result->missed++;
+			}
+
+			if (task->next_release == now)
+			{
+				task->active = true;
+				task->deadline = now + task->period;
+				task->next_release += task->period;
+				task->executed = 0;
+				result->jobs++;
+			}
+		}
+
+		if (busy > 0)
+		{
+			busy--;
+			result->background++;
+			continue;
+		}
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (tasks[i].active && (pick == BENCH_NONE || tasks[i].deadline < tasks[pick].deadline))
+			{
+				pick = (int32_t)i;
+			}
+		}
+
+		if (pick == BENCH_NONE)
+		{
+			busy = benchIdleHook(tasks, count, background, background_count, now);
+
+			if (busy > 0)
+			{
+				busy--;
+				result->background++;
+			}
+
+			continue;
+		}
+
+		if (++tasks[pick].executed == tasks[pick].execution)
+		{
+			tasks[pick].active = false;
+		}
+	}
+
+	for (uint32_t i = 0; i < background_count; i++)
+	{
+		result->runs += background[i].runs;
+		result->deferrals += background[i].deferrals;
+	}
+
+	result->time += duration;
+}
+
+/*-------------------------- Main -------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+	uint32_t sets = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 20;
+	uint32_t seconds = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : 2;
+	uint64_t caused = 0;
+
+	if (sets == 0 || seconds == 0)
+	{
+		printf("Usage: %s [sets] [seconds per set]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%u task sets of %u tasks per load, %u s each, %u background jobs\n", (unsigned int)sets,
+		   (unsigned int)BENCH_TASKS, (unsigned int)seconds, (unsigned int)BENCH_BACKGROUND_COUNT);
+	printf("%-5s %9s %13s %13s %9s %10s %13s\n", "load", "jobs", "missed alone", "missed w/ bg", "bg runs",
+		   "deferrals", "background %");
+
+	for (uint32_t load = 90; load <= 99; load++)
+	{
+		bench_result alone, shared;
+		uint32_t rng = 0x5eed1234 + load;
+
+		memset(&alone, 0, sizeof(alone));
+		memset(&shared, 0, sizeof(shared));
+
+		for (uint32_t set = 0; set < sets; set++)
+		{
+			bench_task tasks[BENCH_TASKS];
+			bench_task run[BENCH_TASKS];
+			bench_background background[BENCH_BACKGROUND_COUNT];
+			uint64_t missed_alone = alone.missed;
+			uint64_t missed_shared = shared.missed;
+
+			benchMakeTaskSet(&rng, tasks, BENCH_TASKS, load / 100.0);
+
+			memcpy(run, tasks, sizeof(run));
+			benchRun(run, BENCH_TASKS, NULL, 0, (uint64_t)seconds * 1000000, &alone);
+
+			memcpy(run, tasks, sizeof(run));
+			memcpy(background, background_defaults, sizeof(background));
+			benchRun(run, BENCH_TASKS, background, BENCH_BACKGROUND_COUNT, (uint64_t)seconds * 1000000, &shared);
+
+			// Only misses the task set does not have on its own are down to background work
+			if (alone.missed == missed_alone && shared.missed != missed_shared)
+			{
+				caused += shared.missed - missed_shared;
+			}
+		}
+
+		printf("%4u%% %9llu %13llu %13llu %9llu %10llu %13.2f\n", (unsigned int)load, (unsigned long long)shared.jobs,
+			   (unsigned long long)alone.missed, (unsigned long long)shared.missed, (unsigned long long)shared.runs,
+			   (unsigned long long)shared.deferrals, 100.0 * shared.background / shared.time);
+	}
+
+	printf("Misses caused by background work: %llu\n", (unsigned long long)caused);
+	return (caused == 0) ? 0 : 1;
+}
+
+#endif /* HOST_BUILD */
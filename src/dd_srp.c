@@ -0,0 +1,99 @@
+/*
+ * dd_srp.c
+ *
+ * Stack Resource Policy ceilings. See dd_srp.h.
+ */
+
+#include "dd_srp.h"
+
+void ddSrpInit(dd_srp* srp, uint32_t count)
+{
+	srp->count = (count > DD_SRP_MAX_RESOURCES) ? DD_SRP_MAX_RESOURCES : count;
+	srp->depth = 0;
+	srp->system_ceiling = 0;
+	srp->gated = false;
+
+	for (uint32_t i = 0; i < DD_SRP_MAX_RESOURCES; i++)
+	{
+		srp->ceiling[i] = 0;
+		srp->holder[i] = DD_SLOT_NONE;
+	}
+}
+
+/* Declares that jobs at this level use the resource, raising its ceiling to it. */
+void ddSrpUse(dd_srp* srp, uint32_t resource, dd_srp_level level)
+{
+	if (resource < srp->count && level > srp->ceiling[resource])
+	{
+		srp->ceiling[resource] = level;
+	}
+}
+
+/*
+ * Takes a resource for the job in slot. Under the SRP the resource is always
+ * free when a job that is allowed to run asks for it, so false means a job
+ * used a resource it was not declared for (or it took one twice).
+ */
+bool ddSrpTake(dd_srp* srp, uint32_t resource, dd_slot slot)
+{
+	if (resource >= srp->count || srp->holder[resource] != DD_SLOT_NONE || srp->depth == DD_SRP_MAX_RESOURCES)
+	{
+		return false;
+	}
+
+	srp->holder[resource] = slot;
+	srp->saved[srp->depth] = srp->system_ceiling;
+	srp->stack[srp->depth++] = (uint8_t)resource;
+
+	if (srp->ceiling[resource] > srp->system_ceiling)
+	{
+		srp->system_ceiling = srp->ceiling[resource];
+	}
+
+	return true;
+}
+
+/* Gives back the innermost resource taken. Returns false if that is not this job's resource. */
+bool ddSrpGive(dd_srp* srp, uint32_t resource, dd_slot slot)
+{
+	if (srp->depth == 0 || srp->stack[srp->depth - 1] != resource || srp->holder[resource] != slot)
+	{
+		return false;
+	}
+
+	srp->holder[resource] = DD_SLOT_NONE;
+	srp->system_ceiling = srp->saved[--srp->depth];
+	return true;
+}
+
+/*
+ * Gives back every resource the job in slot holds, wherever they are in the
+ * stack, for a job that is stopped or finishes while holding them. Returns
+ * the number released.
+ */
+uint32_t ddSrpReleaseAll(dd_srp* srp, dd_slot slot)
+{
+	uint32_t kept = 0;
+	dd_srp_level ceiling = 0;
+
+	for (uint32_t i = 0; i < srp->depth; i++)
+	{
+		uint8_t resource = srp->stack[i];
+
+		if (srp->holder[resource] == slot)
+		{
+			srp->holder[resource] = DD_SLOT_NONE;
+			continue;
+		}
+
+		srp->saved[kept] = ceiling;
+		srp->stack[kept++] = resource;
+		if (srp->ceiling[resource] > ceiling) ceiling = srp->ceiling[resource];
+	}
+
+	uint32_t released = srp->depth - kept;
+
+	srp->depth = kept;
+	srp->system_ceiling = ceiling;
+	return released;
+}
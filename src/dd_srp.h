@@ -0,0 +1,88 @@
+/*
+ * dd_srp.h
+ *
+ * Stack Resource Policy for DD jobs that share resources. Each job has a
+ * preemption level that is higher the shorter its relative deadline, and
+ * each resource a ceiling: the highest level of the jobs that use it. While
+ * resources are held, the system ceiling is the highest ceiling among them,
+ * and a job may only start if it has the earliest deadline of the jobs that
+ * have not started yet and its level is above the system ceiling. Jobs that
+ * have started, which includes every holder, keep their EDF order.
+ *
+ * Under EDF this means a job that starts never waits for a resource: any job
+ * that could hold one it needs is either finished or kept from starting. A
+ * job is blocked at most once, before it starts, for at most the longest
+ * critical section of a job with a later deadline. Resources must be
+ * released in the reverse order they were taken.
+ *
+ * The DD scheduler applies the rule when it maps the active list to
+ * priorities, see taskListReprioritise() in main.c. No FreeRTOS
+ * dependencies, so the host benchmark (dd_srp_bench.c) runs the same code.
+ */
+
+#ifndef DD_SRP_H_
+#define DD_SRP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "dd_jobs.h"
+
+#define DD_SRP_MAX_RESOURCES	8
+
+/* Preemption levels start at 1; a ceiling of 0 means no resource is held. */
+typedef uint8_t dd_srp_level;
+
+typedef struct dd_srp
+{
+	uint32_t count;
+	dd_srp_level ceiling[DD_SRP_MAX_RESOURCES];
+	dd_slot holder[DD_SRP_MAX_RESOURCES];			// DD_SLOT_NONE while free
+	uint8_t stack[DD_SRP_MAX_RESOURCES];			// Held resources, innermost last
+	dd_srp_level saved[DD_SRP_MAX_RESOURCES];		// System ceiling before each take
+	uint32_t depth;
+	dd_srp_level system_ceiling;
+	bool gated;		// The last priority mapping put a job below one with a later deadline
+} dd_srp;
+
+void ddSrpInit(dd_srp* srp, uint32_t count);
+void ddSrpUse(dd_srp* srp, uint32_t resource, dd_srp_level level);
+bool ddSrpTake(dd_srp* srp, uint32_t resource, dd_slot slot);
+bool ddSrpGive(dd_srp* srp, uint32_t resource, dd_slot slot);
+uint32_t ddSrpReleaseAll(dd_srp* srp, dd_slot slot);
+
+static inline bool ddSrpHolds(const dd_srp* srp, dd_slot slot)
+{
+	for (uint32_t i = 0; i < srp->depth; i++)
+	{
+		if (srp->holder[srp->stack[i]] == slot)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Whether a job may run ahead of the jobs holding resources. Call it for the
+ * jobs in deadline order, earliest first, with closed false before the first
+ * one: once a job that has not started is kept back, so is every later one.
+ */
+static inline bool ddSrpMayStart(const dd_srp* srp, dd_srp_level level, bool started, bool* closed)
+{
+	if (started)
+	{
+		return true;
+	}
+
+	if (*closed || level <= srp->system_ceiling)
+	{
+		*closed = true;
+		return false;
+	}
+
+	return true;
+}
+
+#endif /* DD_SRP_H_ */
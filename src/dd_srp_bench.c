@@ -0,0 +1,504 @@
+/*
+ * dd_srp_bench.c
+ *
+ * Host benchmark for the Stack Resource Policy (host build only). Random
+ * periodic task sets that share a few resources are run under EDF in a
+ * simulation with 1 us steps, once with the SRP from dd_srp.c and once with
+ * FreeRTOS style mutexes:
+ *
+ *   - Base priorities are EDF ranks, reassigned on every release and
+ *     completion the way taskListReprioritise() does it.
+ *   - A job that finds its mutex taken blocks, and the holder inherits the
+ *     waiter's priority as it was at that moment. Reassigning the holder's
+ *     base priority does not touch an inherited one (FreeRTOS V9
+ *     vTaskPrioritySet()), and the holder drops back to its base priority
+ *     when it gives the mutex.
+ *
+ * Each job has one critical section. A job is counted as blocked for every
+ * step in which it is ready, unfinished and has an earlier deadline than the
+ * job that runs. Under the SRP that is bounded by the longest critical
+ * section of a task with a longer relative deadline whose resource ceiling
+ * reaches the job's preemption level; jobs blocked for longer than that
+ * bound are counted as over it. Jobs still running at their deadline are
+ * stopped, as on the target.
+ *
+ * Usage: dd_srp_bench [sets] [utilisation %] [seconds per set]
+ */
+
+#ifdef HOST_BUILD
+
+#include "dd_srp.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_MAX_TASKS			8
+#define BENCH_TASKS				6
+#define BENCH_RESOURCES			2
+#define BENCH_NONE				( -1 )
+
+typedef enum bench_protocol
+{
+	BENCH_MUTEX,
+	BENCH_SRP,
+	BENCH_PROTOCOL_COUNT
+} bench_protocol;
+
+typedef struct bench_task
+{
+	/* Task parameters, us */
+	uint32_t period;
+	uint32_t execution;
+	int32_t resource;				// BENCH_NONE for no critical section
+	uint32_t cs_start;
+	uint32_t cs_length;
+	dd_srp_level level;
+	uint32_t bound;					// Longest blocking the SRP allows
+
+	/* Current job */
+	bool active;
+	bool holding;
+	bool waiting;					// Blocked on a mutex
+	uint64_t deadline;
+	uint64_t next_release;
+	uint32_t executed;
+	uint32_t blocked;
+	uint32_t base;					// Mutex run: EDF rank
+	uint32_t priority;				// Mutex run: with inheritance
+} bench_task;
+
+typedef struct bench_result
+{
+	uint64_t jobs;
+	uint64_t misses;
+	uint64_t switches;
+	uint64_t lock_waits;
+	uint64_t over_bound;
+	uint64_t srp_failures;			// Takes the SRP refused, always 0 with correct ceilings
+	uint32_t max_blocked;
+	uint32_t max_cs;
+} bench_result;
+
+static const char* const protocol_names[BENCH_PROTOCOL_COUNT] = { "mutex", "srp" };
+
+static uint32_t benchRandom(uint32_t* state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+/* Uniform in [low, high]. */
+static uint32_t benchRange(uint32_t* state, uint32_t low, uint32_t high)
+{
+	return low + benchRandom(state) % (high - low + 1);
+}
+
+/*-------------------------- Task Sets --------------------------------------*/
+
+/* Draws a task set with the given total utilisation (UUniFast). */
+static void benchMakeTaskSet(uint32_t* rng, bench_task* tasks, uint32_t count, double utilisation)
+{
+	double remaining = utilisation;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		double share = remaining;
+
+		if (i + 1 < count)
+		{
+			double r = (double)(benchRandom(rng) % 1000000) / 1000000.0;
+			double next = remaining * pow(r, 1.0 / (count - 1 - i));
+
+			share = remaining - next;
+			remaining = next;
+		}
+
+		bench_task* task = &tasks[i];
+		memset(task, 0, sizeof(*task));
+
+		task->period = benchRange(rng, 20, 200) * 100;
+		task->execution = (uint32_t)(share * task->period);
+		if (task->execution < 20) task->execution = 20;
+
+		// Most tasks have one critical section of 10 to 50% of their execution
+		task->resource = (benchRandom(rng) % 10 < 7) ? (int32_t)(benchRandom(rng) % BENCH_RESOURCES) : BENCH_NONE;
+
+		if (task->resource != BENCH_NONE)
+		{
+			task->cs_length = task->execution * benchRange(rng, 10, 50) / 100;
+			if (task->cs_length == 0) task->cs_length = 1;
+			task->cs_start = benchRandom(rng) % (task->execution - task->cs_length + 1);
+		}
+
+		task->next_release = benchRandom(rng) % task->period;
+	}
+
+	// Preemption levels: higher for shorter relative deadlines, equal for equal ones
+	for (uint32_t i = 0; i < count; i++)
+	{
+		tasks[i].level = 0;
+
+		for (uint32_t j = 0; j < count; j++)
+		{
+			if (tasks[j].period >= tasks[i].period) tasks[i].level++;
+		}
+	}
+}
+
+static void benchSetCeilings(dd_srp* srp, bench_task* tasks, uint32_t count)
+{
+	ddSrpInit(srp, BENCH_RESOURCES);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (tasks[i].resource != BENCH_NONE)
+		{
+			ddSrpUse(srp, (uint32_t)tasks[i].resource, tasks[i].level);
+		}
+	}
+
+	// A job can be blocked by one critical section of a longer deadline task whose ceiling reaches its level
+	for (uint32_t i = 0; i < count; i++)
+	{
+		tasks[i].bound = 0;
+
+		for (uint32_t j = 0; j < count; j++)
+		{
+			if (tasks[j].resource != BENCH_NONE && tasks[j].period > tasks[i].period &&
+				srp->ceiling[tasks[j].resource] >= tasks[i].level && tasks[j].cs_length > tasks[i].bound)
+			{
+				tasks[i].bound = tasks[j].cs_length;
+			}
+		}
+	}
+}
+
+/*-------------------------- Simulation -------------------------------------*/
+
+/* Gives each active job its EDF rank, as taskListReprioritise() does. */
+static void benchReprioritise(bench_task* tasks, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (!tasks[i].active)
+		{
+			continue;
+		}
+
+		uint32_t rank = 2;
+
+		for (uint32_t j = 0; j < count; j++)
+		{
+			if (j != i && tasks[j].active &&
+				(tasks[j].deadline > tasks[i].deadline || (tasks[j].deadline == tasks[i].deadline && j > i)))
+			{
+				rank++;
+			}
+		}
+
+		// An inherited priority is left alone, only the base changes
+		if (tasks[i].priority == tasks[i].base) tasks[i].priority = rank;
+		tasks[i].base = rank;
+	}
+}
+
+static void benchMutexGive(bench_task* tasks, uint32_t count, int32_t* holders, uint32_t holder)
+{
+	int32_t resource = tasks[holder].resource;
+	int32_t woken = BENCH_NONE;
+
+	holders[resource] = BENCH_NONE;
+	tasks[holder].holding = false;
+	tasks[holder].priority = tasks[holder].base;
+
+	// The highest priority waiter is unblocked and takes the mutex when it runs
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (tasks[i].active && tasks[i].waiting && tasks[i].resource == resource &&
+			(woken == BENCH_NONE || tasks[i].priority > tasks[woken].priority))
+		{
+			woken = (int32_t)i;
+		}
+	}
+
+	if (woken != BENCH_NONE) tasks[woken].waiting = false;
+}
+
+/* The earliest deadline job the SRP lets run, walking the active jobs in deadline order. */
+static int32_t benchPickSrp(const bench_task* tasks, uint32_t count, const dd_srp* srp)
+{
+	uint32_t order[BENCH_MAX_TASKS];
+	uint32_t active = 0;
+	bool closed = false;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t pos = active;
+
+		if (!tasks[i].active)
+		{
+			continue;
+		}
+
+		while (pos > 0 && tasks[order[pos - 1]].deadline > tasks[i].deadline)
+		{
+			order[pos] = order[pos - 1];
+			pos--;
+		}
+
+		order[pos] = i;
+		active++;
+	}
+
+	for (uint32_t i = 0; i < active; i++)
+	{
+		const bench_task* task = &tasks[order[i]];
+
+		if (ddSrpMayStart(srp, task->level, task->executed > 0 || task->holding, &closed))
+		{
+			return (int32_t)order[i];
+		}
+	}
+
+	return BENCH_NONE;
+}
+
+static int32_t benchPick(const bench_task* tasks, uint32_t count, bench_protocol protocol, const dd_srp* srp, int32_t running)
+{
+	int32_t best = BENCH_NONE;
+
+	if (protocol == BENCH_SRP)
+	{
+		return benchPickSrp(tasks, count, srp);
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const bench_task* task = &tasks[i];
+
+		if (!task->active || task->waiting)
+		{
+			continue;
+		}
+
+		if (best == BENCH_NONE || task->priority > tasks[best].priority ||
+			(task->priority == tasks[best].priority && (int32_t)i == running))
+		{
+			// Equal priorities only happen through inheritance; the running task keeps the core
+			best = (int32_t)i;
+		}
+	}
+
+	return best;
+}
+
+static void benchEndJob(bench_task* task, bench_result* result)
+{
+	task->active = false;
+	task->waiting = false;
+
+	if (task->blocked > result->max_blocked) result->max_blocked = task->blocked;
+	if (task->blocked > task->bound) result->over_bound++;
+}
+
+static void benchRun(bench_task* tasks, uint32_t count, bench_protocol protocol, uint64_t duration, bench_result* result)
+{
+	int32_t holders[BENCH_RESOURCES] = { BENCH_NONE, BENCH_NONE };
+	int32_t running = BENCH_NONE;
+	dd_srp srp;
+
+	benchSetCeilings(&srp, tasks, count);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (tasks[i].cs_length > result->max_cs) result->max_cs = tasks[i].cs_length;
+	}
+
+	for (uint64_t now = 0; now < duration; now++)
+	{
+		bool changed = false;
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			bench_task* task = &tasks[i];
+
+			// Stopped at the deadline, giving back what it holds
+			if (task->active && task->deadline <= now)
+			{
+				if (task->holding)
+				{
+					if (protocol == BENCH_SRP) ddSrpReleaseAll(&srp, (dd_slot)i);
+					else benchMutexGive(tasks, count, holders, i);
+				}
+
+				task->holding = false;
+				result->misses++;
+				benchEndJob(task, result);
+				changed = true;
+			}
+
+			if (task->next_release == now)
+			{
+				task->active = true;
+				task->holding = false;
+				task->waiting = false;
+				task->deadline = now + task->period;
+				task->next_release += task->period;
+				task->executed = 0;
+				task->blocked = 0;
+				task->base = task->priority = 0;
+				result->jobs++;
+				changed = true;
+			}
+		}
+
+		if (changed && protocol == BENCH_MUTEX)
+		{
+			benchReprioritise(tasks, count);
+		}
+
+		int32_t pick;
+
+		// Take the critical section's resource before running its first step
+		while ((pick = benchPick(tasks, count, protocol, &srp, running)) != BENCH_NONE)
+		{
+			bench_task* task = &tasks[pick];
+
+			if (task->resource == BENCH_NONE || task->holding || task->executed != task->cs_start)
+			{
+				break;
+			}
+
+			if (protocol == BENCH_SRP)
+			{
+				if (!ddSrpTake(&srp, (uint32_t)task->resource, (dd_slot)pick)) result->srp_failures++;
+				task->holding = true;
+				break;
+			}
+
+			int32_t holder = holders[task->resource];
+
+			if (holder == BENCH_NONE)
+			{
+				holders[task->resource] = pick;
+				task->holding = true;
+				break;
+			}
+
+			// Block and lend the holder this job's current priority
+			task->waiting = true;
+			result->lock_waits++;
+			if (tasks[holder].priority < task->priority) tasks[holder].priority = task->priority;
+		}
+
+		if (pick != running)
+		{
+			result->switches++;
+			running = pick;
+		}
+
+		if (pick == BENCH_NONE)
+		{
+			continue;
+		}
+
+		bench_task* task = &tasks[pick];
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if ((int32_t)i != pick && tasks[i].active && tasks[i].deadline < task->deadline)
+			{
+				tasks[i].blocked++;
+			}
+		}
+
+		task->executed++;
+
+		if (task->holding && task->executed == task->cs_start + task->cs_length)
+		{
+			if (protocol == BENCH_SRP)
+			{
+				ddSrpGive(&srp, (uint32_t)task->resource, (dd_slot)pick);
+				task->holding = false;
+			}
+			else
+			{
+				benchMutexGive(tasks, count, holders, (uint32_t)pick);
+			}
+		}
+
+		if (task->executed == task->execution)
+		{
+			benchEndJob(task, result);
+
+			if (protocol == BENCH_MUTEX)
+			{
+				benchReprioritise(tasks, count);
+			}
+		}
+	}
+}
+
+/*-------------------------- Main -------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+	uint32_t sets = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 50;
+	uint32_t percent = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : 80;
+	uint32_t seconds = (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 10) : 1;
+	bench_result results[BENCH_PROTOCOL_COUNT];
+	uint32_t rng = 0x5eed1234;
+
+	if (sets == 0 || percent == 0 || percent > 100 || seconds == 0)
+	{
+		printf("Usage: %s [sets] [utilisation %% <= 100] [seconds per set]\n", argv[0]);
+		return 1;
+	}
+
+	memset(results, 0, sizeof(results));
+
+	for (uint32_t set = 0; set < sets; set++)
+	{
+		bench_task tasks[BENCH_MAX_TASKS];
+
+		benchMakeTaskSet(&rng, tasks, BENCH_TASKS, percent / 100.0);
+
+		for (uint32_t protocol = 0; protocol < BENCH_PROTOCOL_COUNT; protocol++)
+		{
+			bench_task run[BENCH_MAX_TASKS];
+
+			// Both protocols see the same releases
+			memcpy(run, tasks, sizeof(run));
+			benchRun(run, BENCH_TASKS, (bench_protocol)protocol, (uint64_t)seconds * 1000000, &results[protocol]);
+		}
+	}
+
+	printf("%u task sets of %u tasks sharing %u resources, U = %u%%, %u s each\n",
+		   (unsigned int)sets, (unsigned int)BENCH_TASKS, (unsigned int)BENCH_RESOURCES, (unsigned int)percent, (unsigned int)seconds);
+	printf("%-8s %10s %8s %12s %11s %13s %13s %11s\n", "protocol", "jobs", "misses", "switches/job", "lock waits",
+		   "max block us", "longest cs us", "over bound");
+
+	for (uint32_t protocol = 0; protocol < BENCH_PROTOCOL_COUNT; protocol++)
+	{
+		bench_result* result = &results[protocol];
+
+		printf("%-8s %10llu %8llu %12.2f %11llu %13u %13u %11llu\n", protocol_names[protocol],
+			   (unsigned long long)result->jobs, (unsigned long long)result->misses,
+			   (result->jobs == 0) ? 0.0 : (double)result->switches / (double)result->jobs,
+			   (unsigned long long)result->lock_waits, (unsigned int)result->max_blocked, (unsigned int)result->max_cs,
+			   (unsigned long long)result->over_bound);
+	}
+
+	if (results[BENCH_SRP].srp_failures > 0)
+	{
+		printf("SRP refused %llu takes\n", (unsigned long long)results[BENCH_SRP].srp_failures);
+	}
+
+	return 0;
+}
+
+#endif /* HOST_BUILD */
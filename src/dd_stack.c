@@ -0,0 +1,66 @@
+/*
+ * dd_stack.c
+ *
+ * Stack high-water tracking per task type. See dd_stack.h.
+ */
+
+#include <stdio.h>
+
+#include "dd_stack.h"
+
+static const char* const type_names[DD_STACK_TYPE_COUNT] = { "Scheduler", "Monitor", "Generator", "DD Job", "Idle", "Timer" };
+
+static dd_stack_stats stack_stats[DD_STACK_TYPE_COUNT] =
+{
+	{ DD_STACK_SCHEDULER, UINT32_MAX, 0 },
+	{ DD_STACK_MONITOR, UINT32_MAX, 0 },
+	{ DD_STACK_GENERATOR, UINT32_MAX, 0 },
+	{ DD_STACK_JOB, UINT32_MAX, 0 },
+	{ configMINIMAL_STACK_SIZE, UINT32_MAX, 0 },
+	{ configTIMER_TASK_STACK_DEPTH, UINT32_MAX, 0 }
+};
+
+/* Samples a task of the given type. A NULL handle samples the calling task. */
+void ddStackSample(dd_stack_type type, TaskHandle_t handle)
+{
+	// Scans the untouched part of the stack, so it is done before entering the critical section
+	uint32_t free_words = (uint32_t)uxTaskGetStackHighWaterMark(handle);
+	dd_stack_stats* stats = &stack_stats[type];
+
+	taskENTER_CRITICAL();
+	stats->samples++;
+	if (free_words < stats->min_free) stats->min_free = free_words;
+	taskEXIT_CRITICAL();
+}
+
+uint32_t ddStackRecommended(const dd_stack_stats* stats)
+{
+	uint32_t used = (stats->min_free > stats->depth) ? 0 : stats->depth - stats->min_free;
+	uint32_t recommended = used + used / 4 + DD_STACK_MARGIN_WORDS;
+
+	return (recommended + 7) & ~7UL;
+}
+
+void ddStackPrintReport(void)
+{
+	for (uint32_t i = 0; i < DD_STACK_TYPE_COUNT; i++)
+	{
+		dd_stack_stats stats;
+
+		taskENTER_CRITICAL();
+		stats = stack_stats[i];
+		taskEXIT_CRITICAL();
+
+		if (stats.samples == 0)
+		{
+			printf("Stack %s: not sampled yet\n", type_names[i]);
+			continue;
+		}
+
+		uint32_t recommended = ddStackRecommended(&stats);
+
+		printf("Stack %s: Depth = %u, Max Used = %u, Recommended = %u words, Saves %d B per task\n", type_names[i],
+				(unsigned int)stats.depth, (unsigned int)(stats.depth - stats.min_free), (unsigned int)recommended,
+				(int)(((int32_t)stats.depth - (int32_t)recommended) * (int32_t)sizeof(StackType_t)));
+	}
+}
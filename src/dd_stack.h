@@ -0,0 +1,91 @@
+/*
+ * dd_stack.h
+ *
+ * Stack sizes and stack high-water tracking for every task type. FreeRTOS
+ * fills each stack with a known byte when the task is created (see
+ * configCHECK_FOR_STACK_OVERFLOW), so uxTaskGetStackHighWaterMark() can
+ * tell how much of it was never touched. The minimum seen for each task
+ * type is kept here, and the report recommends a depth that covers the
+ * deepest use seen plus a margin. Apply a recommendation by overriding the
+ * DD_STACK_* depth below with -D.
+ *
+ * Long lived tasks are sampled by the monitor; DD jobs are sampled once, when
+ * they finish or are stopped at their deadline, which is when they are
+ * deepest into the stack they will ever be.
+ */
+
+#ifndef DD_STACK_H_
+#define DD_STACK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../FreeRTOS_Source/include/FreeRTOS.h"
+#include "../FreeRTOS_Source/include/task.h"
+
+/* Deepest path of each task type in words. Frames are from -fstack-usage,
+calls into the kernel are taken as 64 B each, and a printf adds the VLA its
+line is formatted into (see tiny_printf.c). An interrupt and a context switch
+with the FPU context stacked on top add another 204 B.
+  - Scheduler: a job stopped at its deadline, through ddMissAnalyse(), 560 B
+  - Monitor: the heap report's printf, 480 B
+  - Generator: the error printf in schedulerRequest(), 272 B
+  - Job: the same printf from deleteDDTask(), 288 B
+  - Idle: ddAvailableSlack() from the idle hook, 256 B */
+#define DD_STACK_SCHEDULER_DEEPEST	191
+#define DD_STACK_MONITOR_DEEPEST	171
+#define DD_STACK_GENERATOR_DEEPEST	119
+#define DD_STACK_JOB_DEEPEST		123
+#define DD_STACK_IDLE_DEEPEST		115
+
+/* Stack depths in words for each task type. Each covers its deepest path
+the way ddStackRecommended() would. The idle task is created by the kernel
+with configMINIMAL_STACK_SIZE. */
+#ifndef DD_STACK_SCHEDULER
+	#define DD_STACK_SCHEDULER		256
+#endif
+#ifndef DD_STACK_MONITOR
+	#define DD_STACK_MONITOR		232
+#endif
+#ifndef DD_STACK_GENERATOR
+	#define DD_STACK_GENERATOR		168
+#endif
+#ifndef DD_STACK_JOB
+	#define DD_STACK_JOB			176
+#endif
+
+/* Recommended depths cover the deepest use seen plus a quarter and this many
+words, rounded up to a multiple of 8 words. The deepest paths (a printf in
+the monitor, an interrupt landing on top of a job) are rare, so a run that
+has not hit them under-reports. */
+#define DD_STACK_MARGIN_WORDS		16
+
+_Static_assert( DD_STACK_SCHEDULER >= DD_STACK_SCHEDULER_DEEPEST, "Scheduler stack is shallower than its deepest path" );
+_Static_assert( DD_STACK_MONITOR >= DD_STACK_MONITOR_DEEPEST, "Monitor stack is shallower than its deepest printf" );
+_Static_assert( DD_STACK_GENERATOR >= DD_STACK_GENERATOR_DEEPEST, "Generator stack is shallower than its deepest path" );
+_Static_assert( DD_STACK_JOB >= DD_STACK_JOB_DEEPEST, "Job stack is shallower than its deepest path" );
+_Static_assert( configMINIMAL_STACK_SIZE >= DD_STACK_IDLE_DEEPEST, "Idle stack is shallower than its deepest path" );
+
+typedef enum dd_stack_type
+{
+	DD_STACK_TYPE_SCHEDULER,
+	DD_STACK_TYPE_MONITOR,
+	DD_STACK_TYPE_GENERATOR,
+	DD_STACK_TYPE_JOB,
+	DD_STACK_TYPE_IDLE,
+	DD_STACK_TYPE_TIMER,
+	DD_STACK_TYPE_COUNT
+} dd_stack_type;
+
+typedef struct dd_stack_stats
+{
+	uint32_t depth;			// Words the tasks of this type are created with
+	uint32_t min_free;		// Fewest words never touched, over all samples
+	uint32_t samples;
+} dd_stack_stats;
+
+void ddStackSample(dd_stack_type type, TaskHandle_t handle);
+uint32_t ddStackRecommended(const dd_stack_stats* stats);
+void ddStackPrintReport(void);
+
+#endif /* DD_STACK_H_ */
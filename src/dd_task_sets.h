@@ -0,0 +1,127 @@
+/*
+ * dd_task_sets.h
+ *
+ * Task sets for the DD scheduler. Each task set is a table of generators,
+ * one DD_GENERATOR(period, execution, type, class) entry per generator, with
+ * times in microseconds. Every generator's type must be PERIODIC. The table
+ * is expanded at compile time into the generator configuration array in
+ * main.c, and checked with static assertions in definitions.h.
+ *
+ * Select a task set with -DDD_TASK_SET=<n>. Task sets that are deliberately
+ * overloaded must also define DD_TASK_SET_ALLOW_OVERLOAD, otherwise the
+ * utilisation check fails the build.
+ *
+ * A task set can also list the shared resources its jobs use, one
+ * DD_USE(generator, resource, length) entry per critical section, with
+ * generators numbered from 1 like task IDs and lengths in microseconds.
+ * Each job runs its critical sections first, in table order, as part of its
+ * execution time. See dd_srp.h.
+ *
+ * Generators whose jobs may occasionally be dropped under overload are
+ * listed with one DD_FIRM(generator, m, k) entry each: at least m of any k
+ * consecutive jobs must meet their deadline. Generators without an entry
+ * are hard, and the skip-over policy never drops their jobs. See
+ * dd_overload.h.
+ *
+ * To exercise budget enforcement (see dd_budget.h), a task set can make
+ * generators misbehave with DD_OVERRUN(generator, every, extra) entries:
+ * every job of the generator whose release count is a multiple of every
+ * runs extra microseconds past its declared execution time.
+ */
+
+#ifndef DD_TASK_SETS_H_
+#define DD_TASK_SETS_H_
+
+#ifndef DD_TASK_SET
+	#define DD_TASK_SET 1
+#endif
+
+#define DD_MS(ms)	( (ms) * 1000 )
+
+#if DD_TASK_SET == 1
+
+/* Test bench 1: U = 0.82 */
+#define DD_TASK_SET_TABLE(DD_GENERATOR) \
+	DD_GENERATOR( DD_MS(500), DD_MS( 95), PERIODIC, DD_CLASS_NORMAL ) \
+	DD_GENERATOR( DD_MS(500), DD_MS(150), PERIODIC, DD_CLASS_NORMAL ) \
+	DD_GENERATOR( DD_MS(750), DD_MS(250), PERIODIC, DD_CLASS_NORMAL )
+
+#elif DD_TASK_SET == 2
+
+/* Test bench 2: U = 1.01, overloaded */
+#define DD_TASK_SET_TABLE(DD_GENERATOR) \
+	DD_GENERATOR( DD_MS(250), DD_MS( 95), PERIODIC, DD_CLASS_CRITICAL ) \
+	DD_GENERATOR( DD_MS(500), DD_MS(150), PERIODIC, DD_CLASS_NORMAL ) \
+	DD_GENERATOR( DD_MS(750), DD_MS(250), PERIODIC, DD_CLASS_NORMAL )
+
+#define DD_TASK_SET_FIRM(DD_FIRM) \
+	DD_FIRM( 2, 1, 2 ) \
+	DD_FIRM( 3, 2, 3 )
+
+#elif DD_TASK_SET == 3
+
+/* Test bench 3: U = 1.00 */
+#define DD_TASK_SET_TABLE(DD_GENERATOR) \
+	DD_GENERATOR( DD_MS(500), DD_MS(100), PERIODIC, DD_CLASS_NORMAL ) \
+	DD_GENERATOR( DD_MS(500), DD_MS(200), PERIODIC, DD_CLASS_NORMAL ) \
+	DD_GENERATOR( DD_MS(500), DD_MS(200), PERIODIC, DD_CLASS_NORMAL )
+
+#elif DD_TASK_SET == 4
+
+/* High load bench for background work in slack: U = 0.91 */
+#define DD_TASK_SET_TABLE(DD_GENERATOR) \
+	DD_GENERATOR( DD_MS(500), DD_MS(125), PERIODIC, DD_CLASS_NORMAL ) \
+	DD_GENERATOR( DD_MS(500), DD_MS(150), PERIODIC, DD_CLASS_NORMAL ) \
+	DD_GENERATOR( DD_MS(750), DD_MS(270), PERIODIC, DD_CLASS_NORMAL )
+
+#elif DD_TASK_SET == 5
+
+/* Fast control loop below the tick period: U = 0.84 */
+#define DD_TASK_SET_TABLE(DD_GENERATOR) \
+	DD_GENERATOR(       250,         60, PERIODIC, DD_CLASS_CRITICAL ) \
+	DD_GENERATOR( DD_MS(  5), DD_MS(  1), PERIODIC, DD_CLASS_NORMAL ) \
+	DD_GENERATOR( DD_MS( 50), DD_MS( 20), PERIODIC, DD_CLASS_NORMAL )
+
+#elif DD_TASK_SET == 6
+
+/* Test bench 1 with shared peripherals: U = 0.82 */
+#define DD_TASK_SET_TABLE(DD_GENERATOR) \
+	DD_GENERATOR( DD_MS(500), DD_MS( 95), PERIODIC, DD_CLASS_NORMAL ) \
+	DD_GENERATOR( DD_MS(500), DD_MS(150), PERIODIC, DD_CLASS_NORMAL ) \
+	DD_GENERATOR( DD_MS(750), DD_MS(250), PERIODIC, DD_CLASS_NORMAL )
+
+#define DD_TASK_SET_RESOURCES(DD_USE) \
+	DD_USE( 1, DD_RESOURCE_SHIFT_REGISTER, DD_MS(10) ) \
+	DD_USE( 2, DD_RESOURCE_ADC,            DD_MS( 5) ) \
+	DD_USE( 3, DD_RESOURCE_SHIFT_REGISTER, DD_MS(40) ) \
+	DD_USE( 3, DD_RESOURCE_ADC,            DD_MS(20) )
+
+#elif DD_TASK_SET == 7
+
+/* Test bench 1 with a faulty generator: U = 0.82 as declared, but every
+third job of generator 3 runs 400 ms too long */
+#define DD_TASK_SET_TABLE(DD_GENERATOR) \
+	DD_GENERATOR( DD_MS(500), DD_MS( 95), PERIODIC, DD_CLASS_NORMAL ) \
+	DD_GENERATOR( DD_MS(500), DD_MS(150), PERIODIC, DD_CLASS_NORMAL ) \
+	DD_GENERATOR( DD_MS(750), DD_MS(250), PERIODIC, DD_CLASS_NORMAL )
+
+#define DD_TASK_SET_OVERRUNS(DD_OVERRUN) \
+	DD_OVERRUN( 3, 3, DD_MS(400) )
+
+#else
+	#error "Unknown DD_TASK_SET"
+#endif
+
+#ifndef DD_TASK_SET_RESOURCES
+	#define DD_TASK_SET_RESOURCES(DD_USE)
+#endif
+
+#ifndef DD_TASK_SET_FIRM
+	#define DD_TASK_SET_FIRM(DD_FIRM)
+#endif
+
+#ifndef DD_TASK_SET_OVERRUNS
+	#define DD_TASK_SET_OVERRUNS(DD_OVERRUN)
+#endif
+
+#endif /* DD_TASK_SETS_H_ */
@@ -0,0 +1,145 @@
+/*
+ * dd_trace.c
+ *
+ * Trace event ring. See dd_trace.h.
+ */
+
+#include "stm32f4xx.h"
+#include "../FreeRTOS_Source/include/FreeRTOS.h"
+#include "../FreeRTOS_Source/include/task.h"
+
+#include "dd_ring.h"
+#include "dd_clock.h"
+#include "dd_cycles.h"
+#include "dd_trace.h"
+
+#if DD_TRACE
+
+static dd_trace_event trace_events[DD_TRACE_LENGTH];
+static uint32_t trace_head;			// Written with interrupts masked
+static dd_atomic_u32 trace_tail;	// Owned by the monitor
+static uint32_t trace_lost;
+static uint32_t trace_next_task = 0;
+static uint32_t trace_next_object = 0;
+
+static inline void ddTracePut(dd_trace_type type, uint8_t aux, uint16_t object, uint32_t arg)
+{
+	dd_trace_event* event = &trace_events[trace_head & (DD_TRACE_LENGTH - 1)];
+
+	event->time = (uint32_t)ddClockNow();
+	event->type = (uint8_t)type;
+	event->aux = aux;
+	event->object = object;
+	event->arg = arg;
+	__DMB();
+	trace_head++;
+}
+
+/* Safe from any context, including the hooks and interrupts. */
+void ddTraceEvent(dd_trace_type type, uint8_t aux, uint16_t object, uint32_t arg)
+{
+	UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	DD_CYCLES_BEGIN(DD_CYCLES_TRACE);
+
+	// Keep a slot free for the LOST event while anything is being dropped
+	uint32_t used = trace_head - ddAtomicLoad(&trace_tail);
+
+	if (used + 1 + (trace_lost != 0) > DD_TRACE_LENGTH)
+	{
+		trace_lost++;
+	}
+	else
+	{
+		if (trace_lost != 0)
+		{
+			ddTracePut(DD_TRACE_LOST, 0, 0, trace_lost);
+			trace_lost = 0;
+		}
+
+		ddTracePut(type, aux, object, arg);
+	}
+
+	DD_CYCLES_END(DD_CYCLES_TRACE);
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+uint32_t ddTraceDrain(dd_trace_event* out, uint32_t max)
+{
+	uint32_t tail = ddAtomicLoad(&trace_tail);
+	uint32_t count = 0;
+
+	// The head only moves forward, so a stale read just drains less
+	while (tail != *(volatile uint32_t*)&trace_head && count < max)
+	{
+		__DMB();
+		out[count++] = trace_events[tail & (DD_TRACE_LENGTH - 1)];
+		tail++;
+	}
+
+	ddAtomicStore(&trace_tail, tail);
+	return count;
+}
+
+/* Returns the trace ID of a task, kept in its application task tag. */
+uint16_t ddTraceTaskId(void* handle)
+{
+	return (uint16_t)(uint32_t)xTaskGetApplicationTaskTag((TaskHandle_t)handle);
+}
+
+uint32_t ddTraceTaskCreated(const char* name, uint32_t priority)
+{
+	uint32_t chars = 0;
+	uint32_t id;
+
+	// Called with the kernel's critical section held
+	if (++trace_next_task > 0xFFFF) trace_next_task = 1;
+	id = trace_next_task;
+
+	for (uint32_t i = 0; i < 4 && name[i] != '\0'; i++)
+	{
+		chars |= (uint32_t)(uint8_t)name[i] << (8 * i);
+	}
+
+	ddTraceEvent(DD_TRACE_TASK_CREATE, (uint8_t)priority, (uint16_t)id, chars);
+	return id;
+}
+
+void ddTraceTaskSwitchedIn(uint32_t task)
+{
+	ddTraceEvent(DD_TRACE_SWITCH, 0, (uint16_t)task, 0);
+}
+
+/* Numbers queues, semaphores and timers as they are created. */
+uint32_t ddTraceObjectCreated(void)
+{
+	UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	uint32_t id;
+
+	if (++trace_next_object > 0xFFFF) trace_next_object = 1;
+	id = trace_next_object;
+
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+	return id;
+}
+
+void ddTraceQueueSend(uint32_t queue, uint32_t waiting)
+{
+	ddTraceEvent(DD_TRACE_QUEUE_SEND, 0, (uint16_t)queue, waiting);
+}
+
+void ddTraceQueueReceive(uint32_t queue, uint32_t waiting)
+{
+	ddTraceEvent(DD_TRACE_QUEUE_RECEIVE, 0, (uint16_t)queue, waiting);
+}
+
+void ddTraceQueueBlock(uint32_t queue)
+{
+	ddTraceEvent(DD_TRACE_QUEUE_BLOCK, 0, (uint16_t)queue, 0);
+}
+
+void ddTraceTimerExpired(uint32_t timer)
+{
+	ddTraceEvent(DD_TRACE_TIMER, 0, (uint16_t)timer, 0);
+}
+
+#endif /* DD_TRACE */
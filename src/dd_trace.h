@@ -0,0 +1,92 @@
+/*
+ * dd_trace.h
+ *
+ * Scheduling timeline from the FreeRTOS trace hooks. The hooks in
+ * FreeRTOSConfig.h write one 12-byte event per context switch, queue or
+ * semaphore operation, timer expiry and task creation into an in-RAM ring,
+ * and the DD scheduler adds an event for each job release, completion and
+ * deadline miss. The monitor drains the ring to the console as DDTRACE hex
+ * lines, which dd_trace_export turns into a Chrome trace (chrome://tracing
+ * or Perfetto) with one row per task and one per generator's jobs.
+ *
+ * Tasks are identified by a trace ID kept in the low 16 bits of their
+ * application task tag (the upper bits are dd_miss.h's task class), and
+ * queues and timers by their trace facility number, all assigned by the
+ * create hooks. Times are the low 32 bits of ddClockNow().
+ *
+ * Writing an event is a fixed number of stores with interrupts masked, and
+ * its cost is counted by the DD_CYCLES_TRACE probe (see dd_cycles.h). When
+ * the ring is full events are dropped, and a LOST event marks the gap.
+ *
+ * Build with -DDD_TRACE=0 to remove the hooks.
+ */
+
+#ifndef DD_TRACE_H_
+#define DD_TRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum dd_trace_type
+{
+	DD_TRACE_TASK_CREATE,		// object: task, aux: priority, arg: first four characters of the name
+	DD_TRACE_SWITCH,			// object: task switched in
+	DD_TRACE_QUEUE_SEND,		// object: queue, arg: messages waiting before the send
+	DD_TRACE_QUEUE_RECEIVE,		// object: queue, arg: messages waiting before the receive
+	DD_TRACE_QUEUE_BLOCK,		// object: queue the running task blocks on
+	DD_TRACE_TIMER,				// object: timer that expired
+	DD_TRACE_CLOCK,				// DD clock compare event
+	DD_TRACE_RELEASE,			// object: job's task, aux: task_id, arg: absolute deadline
+	DD_TRACE_COMPLETE,			// object: job's task, aux: task_id
+	DD_TRACE_MISS,				// object: job's task, aux: task_id
+	DD_TRACE_SHED,				// object: job's task, aux: task_id, arg: us it had run
+	DD_TRACE_BUDGET,			// object: job's task, aux: task_id, arg: dd_budget_policy applied
+	DD_TRACE_LOST				// arg: events dropped before this one
+} dd_trace_type;
+
+typedef struct __attribute__((packed)) dd_trace_event
+{
+	uint32_t time;			// us, low 32 bits of ddClockNow()
+	uint8_t type;			// dd_trace_type
+	uint8_t aux;
+	uint16_t object;
+	uint32_t arg;
+} dd_trace_event;
+
+_Static_assert( sizeof(dd_trace_event) == 12, "dd_trace_event must stay packed" );
+
+/* Events held in RAM, a power of two. */
+#define DD_TRACE_LENGTH			512
+
+/* Characters in the hex form of one event. */
+#define DD_TRACE_HEX_LENGTH		( 2 * sizeof(dd_trace_event) )
+
+/* DD_TRACE is set in FreeRTOSConfig.h, so it is 0 on the host build. */
+#if DD_TRACE
+
+void ddTraceEvent(dd_trace_type type, uint8_t aux, uint16_t object, uint32_t arg);
+uint32_t ddTraceDrain(dd_trace_event* out, uint32_t max);
+uint16_t ddTraceTaskId(void* handle);
+
+/* Called from the hooks in FreeRTOSConfig.h. */
+uint32_t ddTraceTaskCreated(const char* name, uint32_t priority);
+void ddTraceTaskSwitchedIn(uint32_t task);
+uint32_t ddTraceObjectCreated(void);
+void ddTraceQueueSend(uint32_t queue, uint32_t waiting);
+void ddTraceQueueReceive(uint32_t queue, uint32_t waiting);
+void ddTraceQueueBlock(uint32_t queue);
+void ddTraceTimerExpired(uint32_t timer);
+
+#else
+
+static inline void ddTraceEvent(dd_trace_type type, uint8_t aux, uint16_t object, uint32_t arg)
+{
+	(void)type; (void)aux; (void)object; (void)arg;
+}
+
+static inline uint32_t ddTraceDrain(dd_trace_event* out, uint32_t max) { (void)out; (void)max; return 0; }
+static inline uint16_t ddTraceTaskId(void* handle) { (void)handle; return 0; }
+
+#endif /* DD_TRACE */
+
+#endif /* DD_TRACE_H_ */
@@ -0,0 +1,282 @@
+/*
+ * dd_trace_export.c
+ *
+ * Converts the DDTRACE lines of a console capture (see dd_trace.h) into a
+ * Chrome trace for chrome://tracing or Perfetto (host build only).
+ *
+ * Usage: dd_trace_export [capture] > trace.json
+ *
+ * Each task gets a row of slices, from each time it was switched in to the
+ * next switch. DD jobs are created per release, so all jobs of a generator
+ * share one row, which also carries their release, deadline, completion and
+ * miss markers. Queue operations, DD clock events and timer expiries are
+ * markers on rows of their own.
+ */
+
+#ifdef HOST_BUILD
+
+#include "dd_record.h"
+#include "dd_trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EXPORT_LINE_LENGTH		4096
+#define EXPORT_MAX_TASKS		65536
+
+/* Rows that are not a single task. */
+#define EXPORT_ROW_GENERATOR	100000		// + task_id
+#define EXPORT_ROW_QUEUES		200000
+#define EXPORT_ROW_CLOCK		200001
+
+typedef struct export_task
+{
+	char name[5];
+	uint8_t priority;
+	uint8_t generator;		// task_id of the job it runs, 0 for other tasks
+	bool seen;
+} export_task;
+
+typedef struct export_state
+{
+	export_task tasks[EXPORT_MAX_TASKS];
+	uint32_t last_time;
+	uint64_t high;			// Wraps of the 32-bit event time, shifted up
+	uint16_t running;
+	uint64_t running_since;
+	bool started;
+	bool first_event;
+	uint64_t events;
+	uint64_t lost;
+	bool rows[EXPORT_ROW_GENERATOR + 256];
+} export_state;
+
+static uint64_t exportTime(export_state* state, uint32_t time)
+{
+	if (state->started && time < state->last_time)
+	{
+		state->high += 1ULL << 32;
+	}
+
+	state->last_time = time;
+	state->started = true;
+	return state->high | time;
+}
+
+static uint32_t exportRow(export_state* state, uint16_t task)
+{
+	uint8_t generator = state->tasks[task].generator;
+	uint32_t row = (generator != 0) ? EXPORT_ROW_GENERATOR + generator : task;
+
+	state->rows[row] = true;
+	return row;
+}
+
+static void exportSeparator(export_state* state)
+{
+	printf(state->first_event ? "\n" : ",\n");
+	state->first_event = false;
+}
+
+static void exportSlice(export_state* state, uint16_t task, uint64_t start, uint64_t end)
+{
+	const export_task* info = &state->tasks[task];
+
+	exportSeparator(state);
+
+	if (info->generator != 0)
+	{
+		printf("{\"name\":\"Job %u\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":%u,\"args\":{\"task\":%u}}",
+			   (unsigned int)info->generator, (unsigned long long)start, (unsigned long long)(end - start),
+			   (unsigned int)exportRow(state, task), (unsigned int)task);
+	}
+	else
+	{
+		printf("{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":%u}",
+			   info->seen ? info->name : "?", (unsigned long long)start, (unsigned long long)(end - start),
+			   (unsigned int)exportRow(state, task));
+	}
+}
+
+static void exportMarker(export_state* state, const char* name, uint64_t time, uint32_t row, uint32_t arg)
+{
+	exportSeparator(state);
+	printf("{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu,\"pid\":1,\"tid\":%u,\"args\":{\"arg\":%u}}",
+		   name, (unsigned long long)time, (unsigned int)row, (unsigned int)arg);
+}
+
+static void exportEvent(export_state* state, const dd_trace_event* event)
+{
+	uint64_t time = exportTime(state, event->time);
+	export_task* task = &state->tasks[event->object];
+	char name[32];
+
+	state->events++;
+
+	switch ((dd_trace_type)event->type)
+	{
+		case DD_TRACE_TASK_CREATE:
+			memcpy(task->name, &event->arg, 4);
+			task->name[4] = '\0';
+			task->priority = event->aux;
+			task->generator = 0;
+			task->seen = true;
+			break;
+
+		case DD_TRACE_SWITCH:
+			if (state->running != 0)
+			{
+				exportSlice(state, state->running, state->running_since, time);
+			}
+
+			state->running = event->object;
+			state->running_since = time;
+			break;
+
+		case DD_TRACE_RELEASE:
+		{
+			// The deadline is less than 2^31 us after the release
+			uint64_t deadline = time + (uint64_t)(int64_t)(int32_t)(event->arg - event->time);
+
+			task->generator = event->aux;
+			exportMarker(state, "Release", time, exportRow(state, event->object), event->object);
+			exportMarker(state, "Deadline", deadline, exportRow(state, event->object), event->object);
+			break;
+		}
+
+		case DD_TRACE_COMPLETE:
+			exportMarker(state, "Complete", time, exportRow(state, event->object), event->object);
+			break;
+
+		case DD_TRACE_MISS:
+			exportMarker(state, "Miss", time, exportRow(state, event->object), event->object);
+			break;
+
+		case DD_TRACE_SHED:
+			exportMarker(state, "Shed", time, exportRow(state, event->object), event->arg);
+			break;
+
+		case DD_TRACE_BUDGET:
+			exportMarker(state, "Budget Exhausted", time, exportRow(state, event->object), event->arg);
+			break;
+
+		case DD_TRACE_QUEUE_SEND:
+		case DD_TRACE_QUEUE_RECEIVE:
+			snprintf(name, sizeof(name), "Queue %u %s", (unsigned int)event->object,
+					 (event->type == DD_TRACE_QUEUE_SEND) ? "Send" : "Receive");
+			exportMarker(state, name, time, EXPORT_ROW_QUEUES, event->arg);
+			break;
+
+		case DD_TRACE_QUEUE_BLOCK:
+			snprintf(name, sizeof(name), "Block on Queue %u", (unsigned int)event->object);
+			exportMarker(state, name, time, (state->running != 0) ? exportRow(state, state->running) : EXPORT_ROW_QUEUES, event->object);
+			break;
+
+		case DD_TRACE_CLOCK:
+			exportMarker(state, "DD Clock", time, EXPORT_ROW_CLOCK, 0);
+			break;
+
+		case DD_TRACE_TIMER:
+			snprintf(name, sizeof(name), "Timer %u", (unsigned int)event->object);
+			exportMarker(state, name, time, EXPORT_ROW_CLOCK, event->object);
+			break;
+
+		case DD_TRACE_LOST:
+			state->lost += event->arg;
+			exportMarker(state, "Lost Events", time, EXPORT_ROW_CLOCK, event->arg);
+			break;
+
+		default:
+			break;
+	}
+}
+
+static void exportRowNames(export_state* state)
+{
+	for (uint32_t row = 1; row < EXPORT_ROW_GENERATOR + 256; row++)
+	{
+		if (!state->rows[row])
+		{
+			continue;
+		}
+
+		exportSeparator(state);
+
+		if (row >= EXPORT_ROW_GENERATOR)
+		{
+			printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Generator %u jobs\"}}",
+				   (unsigned int)row, (unsigned int)(row - EXPORT_ROW_GENERATOR));
+		}
+		else
+		{
+			printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u (priority %u)\"}}",
+				   (unsigned int)row, state->tasks[row].seen ? state->tasks[row].name : "Task", (unsigned int)row,
+				   (unsigned int)state->tasks[row].priority);
+		}
+	}
+
+	exportSeparator(state);
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Queues\"}},\n", EXPORT_ROW_QUEUES);
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"DD Clock and Timers\"}}", EXPORT_ROW_CLOCK);
+}
+
+int main(int argc, char** argv)
+{
+	static export_state state;
+	static const char prefix[] = "DDTRACE ";
+	char line[EXPORT_LINE_LENGTH];
+	dd_trace_event event;
+	FILE* in = stdin;
+
+	if (argc > 2 || (argc == 2 && argv[1][0] == '-'))
+	{
+		fprintf(stderr, "Usage: %s [capture] > trace.json\n", argv[0]);
+		return 1;
+	}
+
+	if (argc == 2 && (in = fopen(argv[1], "r")) == NULL)
+	{
+		fprintf(stderr, "Cannot open %s\n", argv[1]);
+		return 1;
+	}
+
+	state.first_event = true;
+	printf("{\"traceEvents\":[");
+
+	while (fgets(line, sizeof(line), in) != NULL)
+	{
+		char* hex = strstr(line, prefix);
+
+		if (hex == NULL)
+		{
+			continue;
+		}
+
+		for (hex += strlen(prefix); ddHexDecode(hex, &event, sizeof(event)); hex += DD_TRACE_HEX_LENGTH)
+		{
+			exportEvent(&state, &event);
+		}
+	}
+
+	if (state.running != 0)
+	{
+		exportSlice(&state, state.running, state.running_since, state.high | state.last_time);
+	}
+
+	exportRowNames(&state);
+	printf("\n],\"displayTimeUnit\":\"ms\"}\n");
+
+	if (in != stdin)
+	{
+		fclose(in);
+	}
+
+	fprintf(stderr, "%llu events", (unsigned long long)state.events);
+	if (state.lost > 0) fprintf(stderr, ", %llu lost on the target", (unsigned long long)state.lost);
+	fprintf(stderr, "\n");
+
+	return 0;
+}
+
+#endif /* HOST_BUILD */
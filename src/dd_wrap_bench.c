@@ -0,0 +1,374 @@
+/*
+ * dd_wrap_bench.c
+ *
+ * Host check of the time base across the TIM2 wrap (host build only). The
+ * 32-bit microsecond counter wraps every 2^32 us, about 71.6 minutes. Task
+ * sets at full load are run under EDF for several wraps, with every clock
+ * read going through ddTimeExtend() on a simulated raw count that starts
+ * just before a wrap, and with the jobs kept in dd_jobs.c slot lists:
+ *
+ *   - A job is inserted into the active list at release with its deadline
+ *     in extended time, and the head of the list is the job that runs.
+ *   - On each event the list is expired against the extended time with
+ *     ddSlotListExpire(), the way taskListCleanup() does.
+ *
+ * A job misses if it is expired or finishes after its deadline in true
+ * time. The check fails unless every set runs without a miss and extended
+ * time never goes backwards. For comparison, each set is also run on the
+ * raw 32-bit count, which misses as soon as the counter wraps.
+ *
+ * The compare event is checked the same way. Events from a few us in the
+ * past to several wraps ahead are armed at counts around the wrap, using
+ * the clamp and the already-passed test from ddClockArm(). The model of
+ * TIM2 fires when the 32-bit count next equals the compare value, or at
+ * once when the event is forced. Long events are re-armed in steps as each
+ * one fires. The check fails if an event fires early, or fires later than
+ * the arm's own counter reads can explain, or if a step is too long for the
+ * 64-bit extension to follow. Unclamped arming is run for comparison.
+ *
+ * Usage: dd_wrap_bench [minutes]
+ */
+
+#ifdef HOST_BUILD
+
+#include "dd_clock.h"
+#include "dd_jobs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WRAP_TASKS				4
+#define WRAP_SLOTS				( 2 * WRAP_TASKS )
+#define WRAP_US					( (uint64_t)1 << 32 )
+#define WRAP_LEAD_US			( 60ULL * 1000000 )		// Raw count starts a minute before it wraps
+
+DD_JOB_TABLE_DEFINE(wrap_table, WRAP_SLOTS);
+
+typedef struct wrap_task
+{
+	uint32_t period;			// us
+	uint32_t execution;			// us
+	uint64_t next_release;		// True time, us
+	uint64_t deadline;			// True time of the current job's deadline
+	uint32_t executed;
+	dd_slot slot;				// DD_SLOT_NONE when it has no job
+} wrap_task;
+
+typedef struct wrap_set
+{
+	const char* name;
+	uint32_t period[WRAP_TASKS];
+	uint32_t execution[WRAP_TASKS];
+} wrap_set;
+
+typedef struct wrap_result
+{
+	uint64_t jobs;
+	uint64_t missed;
+	uint64_t backwards;			// Clock reads earlier than the one before
+	uint32_t wraps;
+} wrap_result;
+
+/* Both use the whole CPU, give or take the rounding of the second. */
+static const wrap_set wrap_sets[] =
+{
+	{ "Harmonic U = 1.000",     { 1000, 2000, 4000, 8000 }, { 250, 500, 1000, 2000 } },
+	{ "Non-harmonic U = 0.999", { 700, 1100, 1300, 3000 },  { 175, 275, 325, 747 } },
+};
+
+#define WRAP_SET_COUNT			( sizeof(wrap_sets) / sizeof(wrap_sets[0]) )
+
+#define WRAP_ARM_MAX_STEPS		8
+
+/* Raw counts an event is armed at, around the wrap and half way round. */
+static const uint32_t arm_starts[] = { 0, 1, 0x7FFFFFFF, 0x80000000, 0xFFFFF000, 0xFFFFFFFE, 0xFFFFFFFF };
+
+/* Events, in us after the clock is read to arm them. */
+static const int64_t arm_offsets[] =
+{
+	-5, -1, 0, 1, 1000,
+	(int64_t)DD_CLOCK_MAX_ARM_US - 1, (int64_t)DD_CLOCK_MAX_ARM_US, (int64_t)DD_CLOCK_MAX_ARM_US + 1,
+	(int64_t)WRAP_US - 1, (int64_t)WRAP_US, (int64_t)WRAP_US + 5, 3 * (int64_t)WRAP_US + 7,
+};
+
+/* us between the two counter reads in ddClockArm(). */
+static const uint32_t arm_delays[] = { 0, 1, 3 };
+
+typedef struct arm_result
+{
+	uint32_t events;
+	uint32_t failed;
+	uint32_t early;				// Fired before the event
+	uint32_t max_steps;
+} arm_result;
+
+#define ARM_COUNT(array)		( sizeof(array) / sizeof((array)[0]) )
+
+/*-------------------------- Simulation -------------------------------------*/
+
+static void wrapRun(const wrap_set* set, bool extend, uint64_t duration, wrap_result* result)
+{
+	wrap_task tasks[WRAP_TASKS];
+	dd_time_counter counter;
+	dd_slot_list active_list;
+	dd_slot_list overdue_list;
+	uint32_t start_raw = (uint32_t)(WRAP_US - WRAP_LEAD_US);
+	dd_time_t last_now = 0;
+	uint32_t last_raw = start_raw;
+	uint64_t t = 0;
+
+	memset(result, 0, sizeof(*result));
+	ddJobTableInit(&wrap_table);
+	ddSlotListInit(&active_list);
+	ddSlotListInit(&overdue_list);
+
+	counter.last = start_raw;
+	counter.high = 0;
+
+	for (uint32_t i = 0; i < WRAP_TASKS; i++)
+	{
+		tasks[i].period = set->period[i];
+		tasks[i].execution = set->execution[i];
+		tasks[i].next_release = 0;
+		tasks[i].slot = DD_SLOT_NONE;
+	}
+
+	while (t < duration)
+	{
+		uint32_t raw = (uint32_t)(start_raw + t);
+		dd_time_t now = extend ? ddTimeExtend(&counter, raw) : raw;
+
+		if (raw < last_raw) result->wraps++;
+		if (ddTimeBefore(now, last_now)) result->backwards++;
+		last_raw = raw;
+		last_now = now;
+
+		// The job at the head has run up to now; it finishes before anything else happens at this instant
+		dd_slot head = active_list.list_head;
+
+		if (head != DD_SLOT_NONE)
+		{
+			wrap_task* task = (wrap_task*)wrap_table.handle[head];
+
+			if (task->executed == task->execution)
+			{
+				if (t > task->deadline) result->missed++;
+
+				ddSlotListRemove(&wrap_table, &active_list, head);
+				ddJobFree(&wrap_table, head);
+				task->slot = DD_SLOT_NONE;
+			}
+		}
+
+		// Jobs past their deadline are stopped, as by taskListCleanup()
+		result->missed += ddSlotListExpire(&wrap_table, &active_list, &overdue_list, now, NULL, NULL);
+
+		while (overdue_list.list_head != DD_SLOT_NONE)
+		{
+			dd_slot slot = overdue_list.list_head;
+
+			((wrap_task*)wrap_table.handle[slot])->slot = DD_SLOT_NONE;
+			ddSlotListRemove(&wrap_table, &overdue_list, slot);
+			ddJobFree(&wrap_table, slot);
+		}
+
+		for (uint32_t i = 0; i < WRAP_TASKS; i++)
+		{
+			wrap_task* task = &tasks[i];
+
+			if (task->next_release != t)
+			{
+				continue;
+			}
+
+			// Still running at its own deadline, which is this release
+			if (task->slot != DD_SLOT_NONE)
+			{
+				result->missed++;
+				ddSlotListRemove(&wrap_table, &active_list, task->slot);
+				ddJobFree(&wrap_table, task->slot);
+			}
+
+			task->slot = ddJobAlloc(&wrap_table);
+			task->deadline = t + task->period;
+			task->executed = 0;
+			task->next_release += task->period;
+
+			// Deadlines are set in the scheduler's time, like taskListInsert() does
+			wrap_table.deadline[task->slot] = extend ? now + task->period : (uint32_t)(raw + task->period);
+			wrap_table.handle[task->slot] = task;
+			wrap_table.t_class[task->slot] = 0;
+			ddSlotListInsertOrdered(&wrap_table, &active_list, task->slot);
+			result->jobs++;
+		}
+
+		// Next event: a release, or the head job finishing
+		uint64_t next = UINT64_MAX;
+
+		for (uint32_t i = 0; i < WRAP_TASKS; i++)
+		{
+			if (tasks[i].next_release < next) next = tasks[i].next_release;
+		}
+
+		head = active_list.list_head;
+
+		if (head != DD_SLOT_NONE)
+		{
+			wrap_task* task = (wrap_task*)wrap_table.handle[head];
+			uint64_t finish = t + (task->execution - task->executed);
+
+			if (finish < next) next = finish;
+			task->executed += (uint32_t)(next - t);
+		}
+
+		t = next;
+	}
+}
+
+/*-------------------------- Compare Event ----------------------------------*/
+
+/*
+ * Arms the compare at now for an event at when, as ddClockArm() does with
+ * delay us between its two counter reads, and returns when TIM2 raises it.
+ * Unclamped, the compare is set to the event however far away it is.
+ */
+static dd_time_t wrapArm(dd_time_counter* counter, dd_time_t now, dd_time_t when, uint32_t delay, bool clamp)
+{
+	dd_time_t target = clamp ? ddClockArmTarget(now, when) : when;
+	uint32_t compare = (uint32_t)target;
+	dd_time_t read = ddTimeExtend(counter, (uint32_t)(now + delay));
+
+	if (ddClockArmPassed(read, target))
+	{
+		return read;
+	}
+
+	// A compare equal to the count only matches once the counter comes round again
+	uint32_t wait = compare - (uint32_t)read;
+
+	return read + ((wait == 0) ? WRAP_US : wait);
+}
+
+/* Arms one event and re-arms it as each step fires. Returns false if it misbehaves. */
+static bool wrapArmEvent(uint32_t start, int64_t offset, uint32_t delay, bool clamp, arm_result* result)
+{
+	dd_time_counter counter = { start, 1 };
+	dd_time_t now = ddTimeExtend(&counter, start);
+	dd_time_t when = now + (dd_time_t)offset;
+	dd_time_t due = ddTimeBefore(when, now + delay) ? now + delay : when;
+
+	result->events++;
+
+	for (uint32_t steps = 1; steps <= WRAP_ARM_MAX_STEPS; steps++)
+	{
+		dd_time_t fired = wrapArm(&counter, now, when, delay, clamp);
+
+		// The handler reads the counter as the event fires, which must extend to the true time
+		if (fired - now > DD_CLOCK_MAX_ARM_US + delay || ddTimeExtend(&counter, (uint32_t)fired) != fired)
+		{
+			return false;
+		}
+
+		if (ddTimeBefore(fired, due) && !ddTimeBefore(fired, now + DD_CLOCK_MAX_ARM_US))
+		{
+			// A full step, re-armed from the time it fired
+			now = fired;
+			continue;
+		}
+
+		if (steps > result->max_steps) result->max_steps = steps;
+
+		if (ddTimeBefore(fired, due))
+		{
+			result->early++;
+			return false;
+		}
+
+		return fired - due <= delay;
+	}
+
+	return false;
+}
+
+static void wrapArmRun(bool clamp, arm_result* result)
+{
+	memset(result, 0, sizeof(*result));
+
+	for (uint32_t s = 0; s < ARM_COUNT(arm_starts); s++)
+	{
+		for (uint32_t o = 0; o < ARM_COUNT(arm_offsets); o++)
+		{
+			for (uint32_t d = 0; d < ARM_COUNT(arm_delays); d++)
+			{
+				if (!wrapArmEvent(arm_starts[s], arm_offsets[o], arm_delays[d], clamp, result))
+				{
+					result->failed++;
+				}
+			}
+		}
+	}
+}
+
+/*-------------------------- Main -------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+	uint32_t minutes = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 150;
+	bool failed = false;
+
+	if (minutes < 2)
+	{
+		printf("Usage: %s [minutes >= 2]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%u simulated minutes per set, raw count starting %u s before it wraps\n", (unsigned int)minutes,
+		   (unsigned int)(WRAP_LEAD_US / 1000000));
+	printf("%-24s %-9s %10s %6s %8s %10s\n", "set", "clock", "jobs", "wraps", "missed", "backwards");
+
+	for (uint32_t i = 0; i < WRAP_SET_COUNT; i++)
+	{
+		for (uint32_t mode = 0; mode < 2; mode++)
+		{
+			bool extend = (mode == 0);
+			wrap_result result;
+
+			wrapRun(&wrap_sets[i], extend, (uint64_t)minutes * 60 * 1000000, &result);
+
+			printf("%-24s %-9s %10llu %6u %8llu %10llu\n", wrap_sets[i].name, extend ? "extended" : "raw",
+				   (unsigned long long)result.jobs, (unsigned int)result.wraps, (unsigned long long)result.missed,
+				   (unsigned long long)result.backwards);
+
+			if (extend && (result.missed > 0 || result.backwards > 0 || result.wraps == 0))
+			{
+				failed = true;
+			}
+		}
+	}
+
+	printf("%s\n", failed ? "FAILED: the extended clock missed deadlines across the wrap" : "No misses across the wrap");
+
+	printf("\n%-24s %6s %6s %6s %9s\n", "compare event", "events", "failed", "early", "max steps");
+
+	for (uint32_t mode = 0; mode < 2; mode++)
+	{
+		bool clamp = (mode == 0);
+		arm_result result;
+
+		wrapArmRun(clamp, &result);
+
+		printf("%-24s %6u %6u %6u %9u\n", clamp ? "ddClockArm" : "unclamped", (unsigned int)result.events,
+			   (unsigned int)result.failed, (unsigned int)result.early, (unsigned int)result.max_steps);
+
+		if (clamp && result.failed > 0)
+		{
+			failed = true;
+			printf("FAILED: the compare event misfired across the wrap\n");
+		}
+	}
+
+	return failed ? 1 : 0;
+}
+
+#endif /* HOST_BUILD */
@@ -0,0 +1,358 @@
+/*
+ * definitions.h
+ *
+ * Types, constants and prototypes for the deadline-driven (DD) scheduler.
+ */
+
+#ifndef DEFINITIONS_H_
+#define DEFINITIONS_H_
+
+/* Standard includes. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "stm32f4_discovery.h"
+
+/* Kernel includes. */
+#include "stm32f4xx.h"
+#include "../FreeRTOS_Source/include/FreeRTOS.h"
+#include "../FreeRTOS_Source/include/queue.h"
+#include "../FreeRTOS_Source/include/semphr.h"
+#include "../FreeRTOS_Source/include/task.h"
+#include "../FreeRTOS_Source/include/timers.h"
+
+#include "dd_task_sets.h"
+#include "dd_ring.h"
+#include "dd_jobs.h"
+#include "dd_clock.h"
+#include "dd_record.h"
+#include "dd_heap.h"
+#include "dd_stack.h"
+#include "dd_arena.h"
+#include "dd_boot.h"
+#include "dd_cycles.h"
+#include "dd_trace.h"
+#include "dd_miss.h"
+#include "dd_srp.h"
+#include "dd_overload.h"
+#include "dd_budget.h"
+#include "dd_slack.h"
+
+/*-------------------------- Priorities -------------------------------------*/
+
+/* DD jobs are created at the minimum priority and suspended until the
+scheduler has placed them in the active list. The active list then maps each
+job to one priority level between DD_TASK_PRIORITY_EXECUTION_BASE (latest
+deadline) and DD_TASK_PRIORITY_GENERATOR - 1 (earliest deadline). */
+#define DD_TASK_PRIORITY_IDLE				( 0 )
+#define DD_TASK_PRIORITY_MINIMUM			( 1 )
+#define DD_TASK_PRIORITY_MONITOR			( 1 )
+#define DD_TASK_PRIORITY_EXECUTION_BASE		( 2 )
+#define DD_TASK_PRIORITY_GENERATOR			( configMAX_PRIORITIES - 2 )
+#define DD_TASK_PRIORITY_SCHEDULER			( configMAX_PRIORITIES - 1 )
+
+/* Number of jobs that can be active at once. */
+#define DD_TASK_RANGE						( DD_TASK_PRIORITY_GENERATOR - DD_TASK_PRIORITY_EXECUTION_BASE )
+
+/* Number of overdue jobs kept for the monitor. */
+#define DD_OVERDUE_LIST_MAX					4
+
+/* Job slots: active and overdue jobs plus one being created by each generator. */
+#define DD_MAX_JOBS							32
+
+/* Release times, deadlines and execution times are in microseconds. */
+#define DD_US_PER_TICK						( 1000000UL / configTICK_RATE_HZ )
+
+/* A busy-waiting job only counts the time between two clock reads as its own
+execution when the gap is shorter than this; a longer gap means it was
+preempted. */
+#define DD_JOB_PREEMPT_GAP_US				10
+
+/* Scheduler event log length in records, a power of two, and the number of
+records the monitor prints per DDLOG line. */
+#define DD_RECORD_LOG_LENGTH				512
+#define DD_RECORD_LINE_RECORDS				8
+
+/* Bytes for the list replies of one monitor cycle. Each reply takes
+configMAX_TASK_NAME_LEN + 50 bytes per job, plus one line. */
+#define DD_MONITOR_ARENA_SIZE				1024
+
+/*-------------------------- Types ------------------------------------------*/
+
+typedef enum task_type
+{
+	PERIODIC,
+	APERIODIC
+} task_type;
+
+/* Breaks ties between jobs with the same absolute deadline. */
+typedef enum task_class
+{
+	DD_CLASS_CRITICAL,
+	DD_CLASS_NORMAL,
+	DD_CLASS_BACKGROUND
+} task_class;
+
+typedef enum message_type
+{
+	CREATE,
+	DELETE,
+	ACTIVE,
+	COMPLETED,
+	OVERDUE
+} message_type;
+
+typedef struct dd_task
+{
+	TaskHandle_t t_handle;
+	TaskFunction_t task_func;
+	task_type type;
+	task_class t_class;
+	uint32_t task_id;
+	const char* name;
+	uint32_t execution_time;		// us
+	uint32_t executed_time;			// us
+	uint32_t overrun_time;			// us it runs past execution_time, see DD_TASK_SET_OVERRUNS
+	dd_time_t release_time;
+	dd_time_t absolute_deadline;
+	dd_time_t completion_time;
+	dd_slot slot;	// Index of the job's scheduling keys in the job table
+} dd_task;
+
+typedef dd_task* task;
+
+/* Lists link job slots through the job table, see dd_jobs.h. */
+typedef dd_slot_list dd_tasklist;
+
+typedef dd_tasklist* tasklist;
+
+/* Command sent to the scheduler task. The payload is the task for CREATE and
+DELETE, and the client's dd_reply mailbox for the list requests. */
+typedef struct __attribute__((packed)) dd_command
+{
+	uint8_t type;			// message_type
+	uint8_t reserved;
+	uint16_t request_id;
+	TaskHandle_t client;	// Notified with request_id once the command is done
+	void* payload;
+} dd_command;
+
+/* Length of the scheduler's submission ring, a power of two. */
+#define DD_SCHEDULER_RING_LENGTH	16
+
+/* Mailbox owned by a client, filled in by the scheduler before it replies. */
+typedef struct dd_reply
+{
+	void* data;
+} dd_reply;
+
+/*-------------------------- Task Set ---------------------------------------*/
+
+/* One generator of the selected task set (see dd_task_sets.h). */
+typedef struct dd_generator_config
+{
+	uint32_t period;				// us
+	uint32_t execution_time;		// us
+	task_type type;
+	task_class t_class;
+} dd_generator_config;
+
+/* Release statistics of one generator. Jitter is the delay in microseconds
+between a job's scheduled release and the generator actually submitting it.
+Useful time is the execution time of the jobs that completed. Overruns are
+the jobs that ran out of budget. */
+typedef struct dd_generator_stats
+{
+	uint32_t releases;
+	uint32_t jitter_max;
+	uint64_t jitter_total;
+	uint32_t completed;
+	uint32_t shed;
+	uint64_t useful_time;
+	uint32_t overruns;
+} dd_generator_stats;
+
+#define DD_GENERATOR_COUNT_ENTRY(period, execution, type, t_class)			+ 1
+#define DD_GENERATOR_UTILISATION_ENTRY(period, execution, type, t_class)	+ ( ( (execution) * 1000 + (period) - 1 ) / (period) )
+#define DD_GENERATOR_VALID_ENTRY(period, execution, type, t_class)			&& ( (period) > 0 ) && ( (execution) > 0 ) && ( (execution) <= (period) )
+#define DD_GENERATOR_PERIODIC_ENTRY(period, execution, type, t_class)		&& ( (type) == PERIODIC )
+
+#define DD_GENERATOR_COUNT			( 0 DD_TASK_SET_TABLE(DD_GENERATOR_COUNT_ENTRY) )
+
+/* Total utilisation in thousandths, rounded up per generator. */
+#define DD_TASK_SET_UTILISATION		( 0 DD_TASK_SET_TABLE(DD_GENERATOR_UTILISATION_ENTRY) )
+
+_Static_assert( DD_GENERATOR_COUNT > 0, "The task set has no generators" );
+_Static_assert( 1 DD_TASK_SET_TABLE(DD_GENERATOR_VALID_ENTRY), "Every generator needs 0 < execution <= period" );
+
+/* taskGenerator() only releases jobs once per period, and nothing arms a
+timer for an aperiodic job's deadline any more, so APERIODIC entries would
+silently run as periodic ones. */
+_Static_assert( 1 DD_TASK_SET_TABLE(DD_GENERATOR_PERIODIC_ENTRY), "Aperiodic generators are not supported" );
+
+#ifndef DD_TASK_SET_ALLOW_OVERLOAD
+_Static_assert( DD_TASK_SET_UTILISATION <= 1000, "Task set utilisation exceeds 1" );
+#endif
+
+/* Deadlines equal periods, so each generator has at most one job active at a
+time, and each active job needs its own priority level. */
+_Static_assert( DD_GENERATOR_COUNT <= DD_TASK_RANGE, "Not enough priority levels for the task set" );
+_Static_assert( DD_TASK_PRIORITY_SCHEDULER < configMAX_PRIORITIES, "Scheduler priority out of range" );
+_Static_assert( DD_MAX_JOBS >= DD_TASK_RANGE + DD_OVERDUE_LIST_MAX + 1 + DD_GENERATOR_COUNT, "Not enough job slots" );
+_Static_assert( DD_MAX_JOBS < DD_SLOT_NONE, "Too many job slots" );
+_Static_assert( DD_MAX_JOBS <= 256, "Job slots must fit the 8 bits of a task tag, see dd_miss.h" );
+
+/* Every stack comes from the FreeRTOS heap: the scheduler, the monitor, each
+generator with an active job and one being created, and the kernel's idle and
+timer tasks. */
+_Static_assert( ( DD_STACK_SCHEDULER + DD_STACK_MONITOR + DD_GENERATOR_COUNT * ( DD_STACK_GENERATOR + 2 * DD_STACK_JOB ) +
+				  configMINIMAL_STACK_SIZE + configTIMER_TASK_STACK_DEPTH ) * sizeof(StackType_t) < configTOTAL_HEAP_SIZE,
+				"Task stacks do not fit in the FreeRTOS heap" );
+_Static_assert( DD_MONITOR_ARENA_SIZE >= ( configMAX_TASK_NAME_LEN + 50 ) * ( DD_TASK_RANGE + DD_OVERDUE_LIST_MAX + 3 ) + 3 * DD_ARENA_ALIGN,
+				"The monitor arena cannot hold a full set of list replies" );
+
+/*-------------------------- Shared Resources -------------------------------*/
+
+/* Resources DD jobs share, guarded by the Stack Resource Policy (see
+dd_srp.h). Which jobs use them is part of the task set. */
+#define DD_RESOURCE_TABLE(DD_RESOURCE) \
+	DD_RESOURCE( DD_RESOURCE_SHIFT_REGISTER,	"Shift Register" ) \
+	DD_RESOURCE( DD_RESOURCE_ADC,				"ADC" )
+
+#define DD_RESOURCE_ENUM(resource, name)	resource,
+
+typedef enum dd_resource
+{
+	DD_RESOURCE_TABLE(DD_RESOURCE_ENUM)
+	DD_RESOURCE_COUNT
+} dd_resource;
+
+/* One critical section of a generator's jobs. */
+typedef struct dd_resource_use
+{
+	uint32_t generator;		// task_id of its jobs, 0 ends the table
+	dd_resource resource;
+	uint32_t length;		// us
+} dd_resource_use;
+
+typedef struct dd_resource_stats
+{
+	uint32_t takes;
+	uint32_t hold_max;		// us
+	uint64_t hold_total;
+	dd_time_t taken_at;
+} dd_resource_stats;
+
+#define DD_RESOURCE_USE_VALID_ENTRY(generator, resource, length)	&& ( (generator) >= 1 ) && ( (generator) <= DD_GENERATOR_COUNT ) && ( (length) > 0 )
+
+_Static_assert( DD_RESOURCE_COUNT <= DD_SRP_MAX_RESOURCES, "Too many shared resources" );
+_Static_assert( 1 DD_TASK_SET_RESOURCES(DD_RESOURCE_USE_VALID_ENTRY), "Every resource use needs a generator of the task set and a length" );
+
+/*-------------------------- Overload ---------------------------------------*/
+
+/* What the scheduler does when the active jobs cannot all make their
+deadlines, see dd_overload.h. Select a policy with
+-DDD_OVERLOAD_POLICY=DD_OVERLOAD_<policy>. */
+#ifndef DD_OVERLOAD_POLICY
+#define DD_OVERLOAD_POLICY			DD_OVERLOAD_NONE
+#endif
+
+/* Worth of one microsecond of a job of each class, for the value policy */
+#define DD_VALUE_CRITICAL			100
+#define DD_VALUE_NORMAL				10
+#define DD_VALUE_BACKGROUND			1
+
+#define DD_FIRM_VALID_ENTRY(generator, m, k)	&& ( (generator) >= 1 ) && ( (generator) <= DD_GENERATOR_COUNT ) && ( (m) >= 1 ) && ( (m) < (k) ) && ( (k) <= 32 )
+
+_Static_assert( 1 DD_TASK_SET_FIRM(DD_FIRM_VALID_ENTRY), "Every (m,k) constraint needs a generator of the task set and 1 <= m < k <= 32" );
+
+/*-------------------------- Budgets ----------------------------------------*/
+
+/* What the scheduler does with a job that runs out of budget, see
+dd_budget.h. Select a policy with -DDD_BUDGET_POLICY=DD_BUDGET_<policy>. */
+#ifndef DD_BUDGET_POLICY
+#define DD_BUDGET_POLICY			DD_BUDGET_DEMOTE
+#endif
+
+/* A job's budget in us: its execution time, with 1/32 of it and 50 us more
+for the interrupts and kernel calls charged to it. */
+#define DD_BUDGET(execution)		( (execution) + (execution) / 32 + 50 )
+
+#define DD_OVERRUN_VALID_ENTRY(generator, every, extra)	&& ( (generator) >= 1 ) && ( (generator) <= DD_GENERATOR_COUNT ) && ( (every) >= 1 ) && ( (extra) > 0 )
+
+_Static_assert( 1 DD_TASK_SET_OVERRUNS(DD_OVERRUN_VALID_ENTRY), "Every overrun needs a generator of the task set, a period and a length" );
+
+/*-------------------------- Tickless Idle ----------------------------------*/
+
+/* Sleep and wakeup statistics. Latencies are in CPU cycles, from the end of a
+tickless sleep to the scheduler dispatching the next DD job. */
+typedef struct dd_sleep_stats
+{
+	uint32_t wakeups;
+	uint32_t slept_ticks;
+	uint32_t dispatches;
+	uint32_t latency_max;
+	uint32_t latency_total;
+} dd_sleep_stats;
+
+/*-------------------------- Slack Stealing ---------------------------------*/
+
+#define DD_BACKGROUND_MAX_JOBS		4
+
+typedef void (*dd_background_func)(void);
+
+/* Background work run from the idle task, only when the EDF slack covers its
+worst case execution time. */
+typedef struct dd_background_job
+{
+	dd_background_func func;
+	const char* name;
+	TickType_t wcet;
+	TickType_t period;		// Minimum ticks between runs
+	dd_time_t last_run;
+	uint32_t runs;
+	uint32_t deferrals;		// Times it was due but the slack was too small
+} dd_background_job;
+
+/* Provided by the port when configUSE_TICKLESS_IDLE is 1. */
+extern void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
+
+/*-------------------------- Prototypes -------------------------------------*/
+
+void initTaskList(tasklist new_list);
+task createTask();
+bool deleteTask(task del_task);
+char* taskListReturnMessages(tasklist cur_list);
+void taskListInsert(task new_task, tasklist list);
+void taskListRemoveFront(tasklist rem_list);
+void taskListRemove(task rem_task, tasklist rem_list, bool clear);
+uint32_t taskListCleanup(tasklist active_list, tasklist overdue_list, dd_time_t now);
+
+void initScheduler(void);
+void schedulerTask(void *pvParameters);
+bool createDDTask(task new_task);
+bool deleteDDTask(task del_task);
+bool getActiveDDTaskList(void);
+bool getCompletedDDTaskList(void);
+bool getOverdueDDTaskList(void);
+bool lockDDResource(task self, dd_resource resource);
+bool unlockDDResource(task self, dd_resource resource);
+void printResourceStats(void);
+TickType_t ddTicksToNextEvent(dd_time_t now, TickType_t horizon);
+void printSleepStats(void);
+TickType_t ddAvailableSlack(dd_time_t now);
+bool registerBackgroundJob(dd_background_func func, const char* name, TickType_t wcet, TickType_t period);
+void printBackgroundStats(void);
+void printStackStats(void);
+void printEventLog(void);
+void printTraceLog(void);
+
+void taskGenerator(void *pvParameters);
+void ddJobTask(void *pvParameters);
+void printGeneratorStats(void);
+void monitorTask(void *pvParameters);
+
+#endif /* DEFINITIONS_H_ */
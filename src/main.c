@@ -139,13 +139,95 @@ functionality.
 #include "definitions.h"
 
 static void prvSetupHardware( void );
+static void backgroundHeapCheck(void);
+
+DD_JOB_TABLE_DEFINE(job_table, DD_MAX_JOBS);
+static task job_records[DD_MAX_JOBS];
 
 static dd_tasklist active_list;
 static dd_tasklist completed_list;
 static dd_tasklist overdue_list;
 
-static QueueHandle_t scheduler_queue;
-static QueueHandle_t monitor_queue;
+/* Submission ring for scheduler commands, see dd_ring.h */
+static dd_ring scheduler_ring;
+static dd_command scheduler_batch[DD_SCHEDULER_RING_LENGTH];
+static uint32_t scheduler_ring_storage[DD_RING_STORAGE_SIZE(DD_SCHEDULER_RING_LENGTH, sizeof(dd_command)) / sizeof(uint32_t)];
+static TaskHandle_t scheduler_handle = NULL;
+
+/* Scheduler event log, drained by the monitor, see dd_record.h */
+static dd_recorder scheduler_recorder;
+static dd_record scheduler_records[DD_RECORD_LOG_LENGTH];
+
+/* Class totals at each job's release, for explaining its miss, see dd_miss.h */
+static dd_miss_window miss_windows[DD_MAX_JOBS];
+
+/* Run time and budget of each job, see dd_budget.h */
+static dd_budget job_budgets[DD_MAX_JOBS];
+
+/* List replies of the current monitor cycle, see dd_arena.h. Only the
+scheduler allocates from it, while the monitor waits for its reply, and only
+the monitor resets it, between its requests. */
+static dd_arena monitor_arena;
+static uint64_t monitor_arena_storage[DD_MONITOR_ARENA_SIZE / sizeof(uint64_t)];
+
+#define DD_GENERATOR_CONFIG_ENTRY(period, execution, type, t_class)	{ (period), (execution), (type), (t_class) },
+
+/* The selected task set, expanded from its table in dd_task_sets.h */
+static const dd_generator_config generator_configs[DD_GENERATOR_COUNT] =
+{
+	DD_TASK_SET_TABLE(DD_GENERATOR_CONFIG_ENTRY)
+};
+
+static TaskHandle_t generator_handles[DD_GENERATOR_COUNT];
+static dd_generator_stats generator_stats[DD_GENERATOR_COUNT];
+static SemaphoreHandle_t generator_release[DD_GENERATOR_COUNT];
+static dd_time_t generator_next_release[DD_GENERATOR_COUNT];
+
+/* First release of every generator, taken by the scheduler as it starts and before any generator runs. */
+static dd_time_t generator_epoch = 0;
+
+#define DD_RESOURCE_USE_ENTRY(generator, resource, length)	{ (generator), (resource), (length) },
+#define DD_RESOURCE_NAME_ENTRY(resource, name)				name,
+
+/* Critical sections of the selected task set, ended by generator 0 */
+static const dd_resource_use resource_uses[] =
+{
+	DD_TASK_SET_RESOURCES(DD_RESOURCE_USE_ENTRY)
+	{ 0, 0, 0 }
+};
+
+static const char* const resource_names[DD_RESOURCE_COUNT] =
+{
+	DD_RESOURCE_TABLE(DD_RESOURCE_NAME_ENTRY)
+};
+
+/* Resource ceilings and the preemption level of each generator's jobs, see
+dd_srp.h. Jobs change it with the kernel suspended, the scheduler reads it
+while it maps priorities. */
+static dd_srp job_srp;
+static dd_srp_level generator_levels[DD_GENERATOR_COUNT];
+static dd_resource_stats resource_stats[DD_RESOURCE_COUNT];
+static uint32_t srp_gated_mappings = 0;
+
+#define DD_FIRM_INIT_ENTRY(generator, m, k)		ddMkInit(&generator_mk[(generator) - 1], (m), (k));
+
+/* Recent deadline outcomes of each generator's jobs and what a microsecond
+of each class is worth, for the overload policy, see dd_overload.h. Only the
+scheduler touches them. */
+static dd_mk_history generator_mk[DD_GENERATOR_COUNT];
+static const uint32_t class_values[] = { DD_VALUE_CRITICAL, DD_VALUE_NORMAL, DD_VALUE_BACKGROUND };
+
+/* When the earliest active deadline is missed, read by the clock interrupt. */
+static dd_time_t scheduler_deadline = DD_TIME_NEVER;
+
+static dd_background_job background_jobs[DD_BACKGROUND_MAX_JOBS];
+static uint32_t background_job_count = 0;
+static uint32_t deadline_misses = 0;
+
+static dd_sleep_stats sleep_stats;
+static volatile bool woke_from_sleep = false;
+static TickType_t wake_tick;
+static uint32_t wake_systick;
 
 /*-------------------------- Main Function ----------------------------------*/
 
@@ -154,13 +236,34 @@ int main(void)
 	/* Configure the system ready to run the demo.  The clock configuration
 	can be done here if it was not done before main() was called. */
 
+	ddBootStamp(DD_BOOT_MAIN);
+
+	// Switches to the PLL when DD_FAST_BOOT left it locking, see dd_boot.h
+	SystemClockFinish();
+	ddBootStamp(DD_BOOT_CLOCK_READY);
+
 	prvSetupHardware();
 	initScheduler();
+	ddBootStamp(DD_BOOT_SCHEDULER_READY);
+
+	registerBackgroundJob(backgroundHeapCheck, "Heap Check", 1, 100);
 
-	xTaskCreate(taskGenerator1, "Task Generator 1", configMINIMAL_STACK_SIZE, NULL, DD_TASK_PRIORITY_GENERATOR, &taskgen1_handle);
-	xTaskCreate(taskGenerator2, "Task Generator 2", configMINIMAL_STACK_SIZE, NULL, DD_TASK_PRIORITY_GENERATOR, &taskgen2_handle);
-	xTaskCreate(taskGenerator3, "Task Generator 3", configMINIMAL_STACK_SIZE, NULL, DD_TASK_PRIORITY_GENERATOR, &taskgen3_handle);
+	// One generator instance per entry of the task set, all sharing taskGenerator
+	for (uint32_t i = 0; i < DD_GENERATOR_COUNT; i++)
+	{
+		generator_release[i] = xSemaphoreCreateBinary();
+		generator_next_release[i] = DD_TIME_NEVER;
+
+		if (generator_release[i] == NULL)
+		{
+			printf("main: no heap for generator %u.\n", (unsigned int)(i + 1));
+			continue;
+		}
 
+		ddHeapTaskCreate(taskGenerator, "Task Gen", DD_STACK_GENERATOR, (void*)i, DD_TASK_PRIORITY_GENERATOR, &generator_handles[i]);
+	}
+
+	ddBootStamp(DD_BOOT_TASKS_CREATED);
 	vTaskStartScheduler();
 
 	return 0;
@@ -168,6 +271,16 @@ int main(void)
 
 /*-------------------------- Task List Code ---------------------------------*/
 
+/*
+ * Lists hold job slots rather than task pointers. The scheduling keys of each
+ * slot live in job_table (see dd_jobs.h) and the rest of the job in the
+ * dd_task record at job_records[slot], so the list walks below never touch
+ * the records.
+ *
+ * Generators allocate slots while the scheduler frees them, so the free list
+ * and job_records are only changed with the scheduler suspended.
+ */
+
 void initTaskList(tasklist new_list)
 {
 	if(new_list == NULL)
@@ -176,27 +289,49 @@ void initTaskList(tasklist new_list)
 		return;
 	}
 
-    new_list->list_length = 0;
-    new_list->list_head   = NULL;
-    new_list->list_tail   = NULL;
-
+	ddSlotListInit(new_list);
 }
 
 task createTask()
 {
-	task new_task = (task)pvPortMalloc(sizeof(dd_task));
+	task new_task = (task)ddHeapAlloc(DD_HEAP_SITE_JOB_RECORD, sizeof(dd_task));
+
+	if (new_task == NULL)
+	{
+		return NULL;
+	}
+
+	vTaskSuspendAll();
+
+	dd_slot slot = ddJobAlloc(&job_table);
+
+	if (slot != DD_SLOT_NONE)
+	{
+		job_records[slot] = new_task;
+	}
+
+	xTaskResumeAll();
+
+	if (slot == DD_SLOT_NONE)
+	{
+		printf("createTask: no free job slots.\n");
+		vPortFree((void*)new_task);
+		return NULL;
+	}
 
 	new_task->t_handle = NULL;
 	new_task->task_func = NULL;
 	new_task->type = PERIODIC;
+	new_task->t_class = DD_CLASS_NORMAL;
+	new_task->slot = slot;
 	new_task->task_id = 0;
 	new_task->name = "";
+	new_task->execution_time = 0;
+	new_task->executed_time = 0;
+	new_task->overrun_time = 0;
 	new_task->release_time = 0;
 	new_task->absolute_deadline = 0;
 	new_task->completion_time = 0;
-	new_task->aperiodic_timer = NULL;
-	new_task->next = NULL;
-	new_task->prev = NULL;
 
 	return new_task;
 }
@@ -210,24 +345,30 @@ bool deleteTask(task del_task)
 	}
 
 	// Return false if task wasn't removed from a list already
-	if (del_task->next != NULL || del_task->prev != NULL)
+	if (job_table.linked[del_task->slot])
 	{
 		printf("deleteTask: task needs to be removed from all lists first.\n");
 		return false;
 	}
 
+	vTaskSuspendAll();
+	job_records[del_task->slot] = NULL;
+	ddJobFree(&job_table, del_task->slot);
+	xTaskResumeAll();
+
 	// Reset each field and free the memory
 	del_task->t_handle = NULL;
 	del_task->task_func = NULL;
 	del_task->type = PERIODIC;
+	del_task->t_class = DD_CLASS_NORMAL;
+	del_task->slot = DD_SLOT_NONE;
 	del_task->task_id = 0;
 	del_task->name = "";
+	del_task->execution_time = 0;
+	del_task->executed_time = 0;
 	del_task->release_time = 0;
 	del_task->absolute_deadline = 0;
 	del_task->completion_time = 0;
-	del_task->aperiodic_timer = NULL;
-	del_task->next = NULL;
-	del_task->prev = NULL;
 
 	vPortFree((void*)del_task);
 
@@ -239,7 +380,13 @@ char* taskListReturnMessages(tasklist cur_list)
 	// Get the size of the list and create a buffer based on that size
 	uint32_t list_size = cur_list->list_length;
 	uint32_t buf_size = ( (configMAX_TASK_NAME_LEN + 50) * (list_size + 1)) ;
-	char* output_buf = (char*)pvPortMalloc(buf_size);
+	char* output_buf = (char*)ddArenaAlloc(&monitor_arena, buf_size);
+
+	if (output_buf == NULL)
+	{
+		return NULL;
+	}
+
 	output_buf[0] = '\0';
 
 	if (list_size == 0)
@@ -248,126 +395,181 @@ char* taskListReturnMessages(tasklist cur_list)
 		strcat(output_buf, buf);
 	}
 	else {
-		task cur_task = cur_list->list_head;
-		while (cur_task != NULL)
+		dd_slot cur_slot = cur_list->list_head;
+		while (cur_slot != DD_SLOT_NONE)
 		{
 			char cur_buf[70];
-			sprintf(cur_buf, "Task ID = %lu, Deadline = %u \n", cur_task->task_id, (unsigned int)cur_task->absolute_deadline );
+			sprintf(cur_buf, "Task ID = %u, Deadline = %u ms \n", (unsigned int)job_records[cur_slot]->task_id, (unsigned int)(job_table.deadline[cur_slot] / 1000) );
 			strcat(output_buf, cur_buf);
 
-			cur_task = cur_task->next;
+			cur_slot = job_table.next[cur_slot];
 		}
 	}
 
 	return output_buf;
 }
 
-void taskListInsert(task new_task, tasklist list)
+static dd_srp_level jobLevel(dd_slot slot)
 {
-	if ((new_task == NULL) || (list == NULL))
+	uint32_t generator = job_records[slot]->task_id - 1;
+
+	return (generator < DD_GENERATOR_COUNT) ? generator_levels[generator] : 0;
+}
+
+static bool jobStarted(dd_slot slot)
+{
+	return job_records[slot]->executed_time > 0 || ddSrpHolds(&job_srp, slot);
+}
+
+/*
+ * Whether a job is mapped below the others: the SRP does not let it start
+ * yet (gated), or it ran out of budget and holds no resource. Call it for
+ * the jobs in deadline order, see ddSrpMayStart().
+ */
+static bool jobHeldBack(dd_slot slot, bool* closed, bool* gated)
+{
+	if (ddBudgetExhausted(slot) && !ddSrpHolds(&job_srp, slot))
 	{
-		printf("taskListInsert: task or list passed in was NULL.\n");
-		return;
+		*gated = false;
+		return true;
 	}
 
-	// If the list is empty we can simply add the new task and return
-	if (list->list_length == 0)
+	*gated = !ddSrpMayStart(&job_srp, jobLevel(slot), jobStarted(slot), closed);
+	return *gated;
+}
+
+/* Execution a job still needs. None once it is past its budget, as it only gets time no other job wants. */
+static uint32_t jobRemaining(dd_slot slot)
+{
+	task job = job_records[slot];
+
+	if (ddBudgetExhausted(slot) || job->executed_time >= job->execution_time)
 	{
-		list->list_length = 1;
-		list->list_head = new_task;
-		list->list_tail = new_task;
-		vTaskPrioritySet(new_task->t_handle, DD_TASK_PRIORITY_EXECUTION_BASE);
-		return;
+		return 0;
 	}
 
-	// Set the current task to the head of the list and store its priority (current highest priority)
-	task cur_task = list->list_head;
-	uint32_t cur_priority = uxTaskPriorityGet(cur_task->t_handle);
+	return job->execution_time - job->executed_time;
+}
+
+/* Adds a job's outcome to its generator's (m,k) history. */
+static void jobRecordOutcome(task job, bool met)
+{
+	uint32_t generator = job->task_id - 1;
+
+	if (generator < DD_GENERATOR_COUNT) ddMkRecord(&generator_mk[generator], met);
+}
+
+/*
+ * Gives each job in the list its EDF priority: the tail (latest deadline)
+ * gets DD_TASK_PRIORITY_EXECUTION_BASE and each job closer to the head one
+ * level more. While jobs hold resources, the jobs the SRP does not let
+ * start yet are mapped below all the others, still in EDF order, and so are
+ * the jobs that ran out of budget.
+ */
+static void taskListReprioritise(tasklist list)
+{
+	uint32_t cur_priority = DD_TASK_PRIORITY_EXECUTION_BASE;
+	dd_slot cur_slot;
 
-	if(cur_priority == DD_TASK_PRIORITY_GENERATOR)
+	job_srp.gated = false;
+
+	if (job_srp.system_ceiling == 0 && !ddBudgetAnyExhausted())
 	{
-		printf("taskListInsert: cannot schedule any more tasks.\n");
+		for (cur_slot = list->list_tail; cur_slot != DD_SLOT_NONE; cur_slot = job_table.prev[cur_slot])
+		{
+			vTaskPrioritySet((TaskHandle_t)job_table.handle[cur_slot], cur_priority);
+			cur_priority++;
+		}
+
 		return;
 	}
 
-	cur_priority++;
+	uint32_t held = 0;
+	uint32_t gated = 0;
+	bool closed = false;
+	bool is_gated;
 
-	// Search for the proper location to add the new task based on deadlines
-	while (cur_task != NULL)
+	for (cur_slot = list->list_head; cur_slot != DD_SLOT_NONE; cur_slot = job_table.next[cur_slot])
 	{
-		if (new_task->absolute_deadline < cur_task->absolute_deadline)
+		if (jobHeldBack(cur_slot, &closed, &is_gated))
 		{
-			if (cur_task == list->list_head)
-			{
-				list->list_head = new_task;
-			}
+			held++;
+			if (is_gated) gated++;
+		}
+		else if (gated > 0)
+		{
+			// A job with a later deadline now runs ahead of a gated one
+			job_srp.gated = true;
+		}
+	}
 
-			new_task->next = cur_task;
-			new_task->prev = cur_task->prev;
-			cur_task->prev = new_task;
+	uint32_t held_priority = DD_TASK_PRIORITY_EXECUTION_BASE + held;
+	uint32_t open_priority = DD_TASK_PRIORITY_EXECUTION_BASE + list->list_length;
 
-			(list->list_length)++;
+	closed = false;
 
-			vTaskPrioritySet(new_task->t_handle, cur_priority);
-			return;
-		}
-		else
-		{
-			// If we have reached the end of the list, insert the new task here
-			if (cur_task->next == NULL)
-			{
-				new_task->next = NULL;
-				new_task->prev = cur_task;
-				cur_task->next = new_task;
-				list->list_tail = new_task;
-
-				(list->list_length)++;
-				vTaskPrioritySet(cur_task->t_handle, cur_priority );
-				vTaskPrioritySet(new_task->t_handle, DD_TASK_PRIORITY_EXECUTION_BASE);
-				return;
-			}
+	for (cur_slot = list->list_head; cur_slot != DD_SLOT_NONE; cur_slot = job_table.next[cur_slot])
+	{
+		bool held_back = jobHeldBack(cur_slot, &closed, &is_gated);
 
-			vTaskPrioritySet(cur_task->t_handle, cur_priority );
-			cur_priority--;
-			cur_task = cur_task->next;
-		}
+		vTaskPrioritySet((TaskHandle_t)job_table.handle[cur_slot], held_back ? --held_priority : --open_priority);
 	}
+
+	if (job_srp.gated) srp_gated_mappings++;
 }
 
-void taskListRemoveFront(tasklist rem_list)
+void taskListInsert(task new_task, tasklist list)
 {
-	if (rem_list == NULL)
+	if ((new_task == NULL) || (list == NULL))
 	{
-		printf("taskListRemoveFront: list passed in was NULL.\n");
+		printf("taskListInsert: task or list passed in was NULL.\n");
 		return;
 	}
 
-	if (rem_list->list_length == 0)
+	if (list->list_length >= DD_TASK_RANGE)
 	{
-		printf("taskListRemoveFront: list is already empty.\n");
+		printf("taskListInsert: cannot schedule any more tasks.\n");
 		return;
 	}
 
-	task head = rem_list->list_head;
+	DD_CYCLES_BEGIN(DD_CYCLES_INSERT);
+
+	// Copy the scheduling keys into the job table; they do not change once the job is scheduled
+	dd_slot slot = new_task->slot;
+	job_table.deadline[slot] = new_task->absolute_deadline;
+	job_table.handle[slot] = new_task->t_handle;
+	job_table.t_class[slot] = (uint8_t)new_task->t_class;
+	ddBudgetStart(slot, DD_BUDGET(new_task->execution_time));
 
-	if (rem_list->list_length == 1)
+	// Place the new task based on its deadline, breaking ties by class
+	ddSlotListInsertOrdered(&job_table, list, slot);
+	taskListReprioritise(list);
+
+	DD_CYCLES_END(DD_CYCLES_INSERT);
+
+	ddMissJobReleased(slot, new_task->t_handle, (uint8_t)new_task->task_id);
+	ddTraceEvent(DD_TRACE_RELEASE, (uint8_t)new_task->task_id, ddTraceTaskId(new_task->t_handle),
+				 (uint32_t)new_task->absolute_deadline);
+}
+
+void taskListRemoveFront(tasklist rem_list)
+{
+	if (rem_list == NULL)
 	{
-		// Remove the only task in the list
-		rem_list->list_head = NULL;
-		rem_list->list_tail = NULL;
+		printf("taskListRemoveFront: list passed in was NULL.\n");
+		return;
 	}
-	else
+
+	if (rem_list->list_length == 0)
 	{
-		// Remove the head of the list
-		rem_list->list_head = head->next;
-		head->next->prev = NULL;
+		printf("taskListRemoveFront: list is already empty.\n");
+		return;
 	}
 
-	// Decrement the list size and delete the task from memory
-	(rem_list->list_length)--;
-	head->next = NULL;
-	head->prev = NULL;
-	deleteTask(head);
+	// Remove the head of the list and delete the task from memory
+	dd_slot head = rem_list->list_head;
+	ddSlotListRemove(&job_table, rem_list, head);
+	deleteTask(job_records[head]);
 }
 
 void taskListRemove(task rem_task, tasklist rem_list, bool clear)
@@ -384,443 +586,1260 @@ void taskListRemove(task rem_task, tasklist rem_list, bool clear)
 		return;
 	}
 
-	// Set the current task to the head of the list and store its priority (current highest priority)
-	task cur_task = rem_list->list_head;
-	uint32_t cur_priority = uxTaskPriorityGet(cur_task->t_handle);
-
-	while (cur_task != NULL)
+	if (!ddSlotListContains(&job_table, rem_list, rem_task->slot))
 	{
-		// Found the task we want to delete
-		if (cur_task->t_handle == rem_task->t_handle)
-		{
-			// If the task is aperiodic we need to stop the timer first
-			if (cur_task->type == APERIODIC && cur_task->aperiodic_timer != NULL)
-			{
-				xTimerStop(cur_task->aperiodic_timer, 0);
-				xTimerDelete(cur_task->aperiodic_timer, 0);
-				cur_task->aperiodic_timer = NULL;
-			}
-
-			if (rem_task->t_handle == rem_list->list_head->t_handle)
-			{
-				// Remove the head of the list
-				rem_list->list_head = cur_task->next;
-				cur_task->next->prev = NULL;
-			}
-			else if (rem_task->t_handle == rem_list->list_tail->t_handle)
-			{
-				// Remove the tail of the list
-				rem_list->list_tail = cur_task->prev;
-				cur_task->prev->next = NULL;
-			}
-			else if (rem_list->list_length == 1)
-			{
-				// Remove the only item in the list
-				rem_list->list_head = NULL;
-				rem_list->list_tail = NULL;
-			}
-			else
-			{
-				cur_task->prev->next = cur_task->next;
-				cur_task->next->prev = cur_task->prev;
-			}
+		printf("taskListRemove: task is not in the list.\n");
+		return;
+	}
 
-			// Decrement the list size and delete the task from memory if clear is true
-			(rem_list->list_length)--;
-			cur_task->next = NULL;
-			cur_task->prev = NULL;
-			if (clear) deleteTask(cur_task);
+	DD_CYCLES_BEGIN(DD_CYCLES_REMOVE);
 
-			return;
-		}
+	ddSlotListRemove(&job_table, rem_list, rem_task->slot);
+	taskListReprioritise(rem_list);
 
-		cur_priority--;
-		vTaskPrioritySet(cur_task->t_handle, cur_priority);
-		cur_task = cur_task->next;
-	}
+	DD_CYCLES_END(DD_CYCLES_REMOVE);
 
-	cur_task = rem_list->list_tail;
-	cur_priority = DD_TASK_PRIORITY_EXECUTION_BASE;
-	vTaskPrioritySet(cur_task->t_handle, cur_priority);
+	// Delete the task from memory if clear is true
+	if (clear) deleteTask(rem_task);
+}
 
-	while (cur_task->prev != NULL)
-	{
-		cur_priority++;
-		cur_task = cur_task->prev;
-		vTaskPrioritySet(cur_task->t_handle, cur_priority);
-	}
+static void taskListStopMissed(dd_slot slot, void* context)
+{
+	task missed = job_records[slot];
+	dd_miss_job job;
+
+	// Explain the miss before the job is stopped, while its record is still complete
+	job.slot = slot;
+	job.task_id = (uint8_t)missed->task_id;
+	job.active_jobs = (uint8_t)active_list.list_length;
+	job.queued_commands = ddAtomicLoad(&scheduler_ring.tail) - scheduler_ring.head;
+	job.release = missed->release_time;
+	job.deadline = missed->absolute_deadline;
+	job.execution_time = missed->execution_time;
+	job.executed_time = missed->executed_time;
+	ddMissAnalyse(&job, *(const dd_time_t*)context);
+
+	// Jobs are stopped at their deadline
+	deadline_misses++;
+	jobRecordOutcome(missed, false);
+	ddTraceEvent(DD_TRACE_MISS, (uint8_t)job_records[slot]->task_id, ddTraceTaskId(job_table.handle[slot]), 0);
+	ddStackSample(DD_STACK_TYPE_JOB, (TaskHandle_t)job_table.handle[slot]);
+	vTaskSuspend((TaskHandle_t)job_table.handle[slot]);
+
+	// Whatever it was doing with a shared resource is abandoned, so others are not held up
+	ddSrpReleaseAll(&job_srp, slot);
+	ddBudgetStop(slot);
+	vTaskDelete((TaskHandle_t)job_table.handle[slot]);
 }
 
-void taskListCleanup(tasklist active_list, tasklist overdue_list)
+uint32_t taskListCleanup(tasklist active_list, tasklist overdue_list, dd_time_t now)
 {
 	if ((active_list == NULL) || (overdue_list == NULL))
 	{
 		printf("taskListCleanup: at least one of the lists passed in was NULL.\n");
-		return;
+		return 0;
 	}
 
-	task cur_task = active_list->list_head;
-	TickType_t cur_time = xTaskGetTickCount();
-
-	while (cur_task != NULL)
-	{
-		if (cur_task->absolute_deadline < cur_time)
-		{
-			taskListRemove(cur_task->t_handle, active_list, false);
-
-			if (overdue_list->list_length != 0)
-			{
-				// Add the overdue task to the end of the overdue list
-				task temp = overdue_list->list_tail;
-				overdue_list->list_tail = cur_task;
-				temp->next = cur_task;
-				cur_task->prev = temp;
-				(overdue_list->list_length)++;
-			}
-			else
-			{
-				// Add the overdue task as the only element in the overdue list
-				overdue_list->list_length = 1;
-				overdue_list->list_head = cur_task;
-				overdue_list->list_tail = cur_task;
-			}
+	DD_CYCLES_BEGIN(DD_CYCLES_CLEANUP);
 
-			if (cur_task->type == PERIODIC)
-			{
-				vTaskSuspend(cur_task->t_handle);
-				vTaskDelete(cur_task->t_handle);
-			}
-		}
-		else
-		{
-			return;
-		}
+	uint32_t moved = ddSlotListExpire(&job_table, active_list, overdue_list, now, taskListStopMissed, &now);
 
-		cur_task = cur_task->next;
+	if (moved > 0)
+	{
+		taskListReprioritise(active_list);
 	}
-}
 
-/*-------------------------- DD Scheduler Code ------------------------------*/
+	DD_CYCLES_END(DD_CYCLES_CLEANUP);
+	return moved;
+}
 
-void initScheduler(void)
+/*
+ * Stops an active job before its deadline, for the overload or the budget
+ * policy: it is stopped like a missed job and moved to the overdue list.
+ * The record type says which policy it was.
+ */
+static void taskListDrop(dd_slot slot, dd_time_t now, dd_record_type type)
 {
-	initTaskList(&active_list);
-	//initTaskList(&completed_list);
-	initTaskList(&overdue_list);
+	task dropped = job_records[slot];
 
-	scheduler_queue = xQueueCreate(DD_TASK_RANGE, sizeof(dd_message));
-	monitor_queue = xQueueCreate(2, sizeof(dd_message));
+	ddSlotListRemove(&job_table, &active_list, slot);
+	ddSlotListPushBack(&job_table, &overdue_list, slot);
+	ddRecord(&scheduler_recorder, type, now, slot, (uint8_t)dropped->task_id, (uint8_t)dropped->t_class,
+			 dropped->executed_time);
 
-	vQueueAddToRegistry(scheduler_queue, "Scheduler Queue");
-	vQueueAddToRegistry(monitor_queue, "Monitor Queue");
+	vTaskSuspend((TaskHandle_t)job_table.handle[slot]);
+	ddSrpReleaseAll(&job_srp, slot);
+	ddBudgetStop(slot);
+	vTaskDelete((TaskHandle_t)job_table.handle[slot]);
 
-	xTaskCreate(schedulerTask, "DD Scheduler Task", configMINIMAL_STACK_SIZE, NULL, DD_TASK_PRIORITY_SCHEDULER, NULL);
-	xTaskCreate(monitorTask, "Monitor Task", configMINIMAL_STACK_SIZE, NULL, DD_TASK_PRIORITY_MONITOR, NULL);
+	jobRecordOutcome(dropped, false);
 }
 
-void schedulerTask(void *pvParameters)
+/* Drops an active job for the overload policy, see dd_overload.h. */
+static void taskListShed(dd_slot slot, dd_time_t now)
 {
-	dd_message msg;
-	task cur_task = NULL;
-
-	while (1)
-	{
-		// Wait until a message is on the scheduler queue
-		if (xQueueReceive(scheduler_queue, (void*)&msg, portMAX_DELAY) == pdTRUE)
-		{
-			taskListCleanup(&active_list, &overdue_list);
-
-			while (overdue_list.list_length > 4)
-			{
-				taskListRemoveFront(&overdue_list);
-			}
-
-			if (msg.message_type == CREATE)
-			{
-				// Add the task to the active list since it has been created
-				cur_task = (task)msg.message_data;
-				taskListInsert(cur_task, &active_list);
-
-				// If aperiodic, we also need to start a timer
-				if (cur_task->type == APERIODIC)
-				{
-					TickType_t period = cur_task->absolute_deadline - xTaskGetTickCount();
-					cur_task->aperiodic_timer = xTimerCreate("aperiodic_timer", period, pdFALSE, (void*)cur_task, apTimerCallback);
-					xTimerStart(cur_task->aperiodic_timer, 0);
-				}
-
-				xTaskNotifyGive(msg.message_sender);
-			}
-			else if (msg.message_type == DELETE)
-			{
-				// Remove the task from the active list and add it to the completed list
-				taskListRemove(msg.message_sender, &active_list, false);
-				//taskListInsert(msg.message_sender, &completed_list);
-
-				xTaskNotifyGive(msg.message_sender);
-			}
-			else if (msg.message_type == ACTIVE)
-			{
-				msg.message_data = (void*)taskListReturnMessages(&active_list);
-
-				if(uxQueueSpacesAvailable(monitor_queue) == 0) xQueueReset(monitor_queue);
+	task shed = job_records[slot];
+	uint32_t generator = shed->task_id - 1;
 
-				if (monitor_queue != NULL)
-				{
-					if (xQueueSend(monitor_queue, &msg, (TickType_t)portMAX_DELAY) != pdPASS)
-					{
-						printf("Error: Can't send on Monitor Queue.\n");
-						return;
-					}
-				}
-				else
-				{
-					printf("Error: Monitor Queue has not been created.\n");
-					return;
-				}
-			}
-//			else if (msg.message_type == COMPLETED)
-//			{
-//				msg.message_data = (void*)taskListReturnMessages(&completed_list);
-//				if(uxQueueSpacesAvailable(monitor_queue) == 0) xQueueReset(monitor_queue);
-//
-//				if (monitor_queue != NULL)
-//				{
-//					if (xQueueSend(monitor_queue, &msg, (TickType_t)portMAX_DELAY) != pdPASS)
-//					{
-//						printf("Error: Can't send on Monitor Queue.\n");
-//						return;
-//					}
-//				}
-//				else
-//				{
-//					printf("Error: Monitor Queue has not been created.\n");
-//					return;
-//				}
-//			}
-			else if (msg.message_type == OVERDUE)
-			{
-				msg.message_data = (void*)taskListReturnMessages(&completed_list);
-				if(uxQueueSpacesAvailable(monitor_queue) == 0) xQueueReset(monitor_queue);
+	ddTraceEvent(DD_TRACE_SHED, (uint8_t)shed->task_id, ddTraceTaskId(job_table.handle[slot]), shed->executed_time);
+	taskListDrop(slot, now, DD_RECORD_SHED);
 
-				if (monitor_queue != NULL)
-				{
-					if (xQueueSend(monitor_queue, &msg, (TickType_t)portMAX_DELAY) != pdPASS)
-					{
-						printf("Error: Can't send on Monitor Queue.\n");
-						return;
-					}
-				}
-				else
-				{
-					printf("Error: Monitor Queue has not been created.\n");
-					return;
-				}
-			}
-		}
-	}
+	if (generator < DD_GENERATOR_COUNT) generator_stats[generator].shed++;
 }
 
-bool createDDTask(task new_task)
-{
-	if (new_task == NULL)
-	{
-		printf("createDDTask: task passed in was NULL.\n");
-		return false;
-	}
+/*-------------------------- DD Scheduler Code ------------------------------*/
 
-	xTaskCreate(new_task->task_func, new_task->name, configMINIMAL_STACK_SIZE, (void*)new_task, DD_TASK_PRIORITY_MINIMUM, &(new_task->t_handle));
+/*
+ * Arms the clock's compare event for whichever comes first: the next
+ * generator release or the moment the earliest active deadline is missed.
+ * Call with the clock interrupt masked, or from it.
+ */
+static void ddArmNextEvent(void)
+{
+	dd_time_t next_event = scheduler_deadline;
+	dd_time_t budget_expiry = ddBudgetExpiry();
 
-	if (new_task->t_handle == NULL)
+	if (budget_expiry != DD_TIME_NEVER && (next_event == DD_TIME_NEVER || ddTimeBefore(budget_expiry, next_event)))
 	{
-		printf("createDDTask: failed to create new task.\n");
-		return false;
+		next_event = budget_expiry;
 	}
 
-	// Suspend until the new task has been scheduled
-	vTaskSuspend(new_task->t_handle);
-
-	dd_message create_msg = {CREATE, xTaskGetCurrentTaskHandle(), new_task};
-
-	if (scheduler_queue != NULL)
+	for (uint32_t i = 0; i < DD_GENERATOR_COUNT; i++)
 	{
-		if (xQueueSend(scheduler_queue, &create_msg, portMAX_DELAY) != pdPASS)
+		if (generator_next_release[i] != DD_TIME_NEVER &&
+			(next_event == DD_TIME_NEVER || ddTimeBefore(generator_next_release[i], next_event)))
 		{
-			printf("createDDTask: could not send on scheduler queue.\n");
-			return false;
+			next_event = generator_next_release[i];
 		}
 	}
+
+	if (next_event == DD_TIME_NEVER)
+	{
+		ddClockDisarm();
+	}
 	else
 	{
-		printf("createDDTask: scheduler queue does not exist.\n");
-		return false;
+		ddClockArm(next_event);
 	}
-
-	ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-	vTaskResume(new_task->t_handle);
-	return true;
 }
 
-bool deleteDDTask(task del_task)
+/*
+ * Compare event handler, in the TIM2 interrupt. Releases every generator
+ * that is due, and wakes the scheduler once the earliest deadline is missed
+ * so the job is moved to the overdue list without waiting for a command.
+ */
+static void ddClockEvent(void)
 {
-	if (del_task == NULL)
-	{
-		printf("deleteDDTask: task passed in was NULL.\n");
-		return false;
-	}
+	BaseType_t woken = pdFALSE;
+	dd_time_t now = ddClockNow();
 
-	dd_message delete_msg = {DELETE, del_task, NULL};
+	ddTraceEvent(DD_TRACE_CLOCK, 0, 0, 0);
 
-	if (scheduler_queue != NULL)
+	for (uint32_t i = 0; i < DD_GENERATOR_COUNT; i++)
 	{
-		if (xQueueSend(scheduler_queue, &delete_msg, portMAX_DELAY) != pdPASS)
+		if (generator_next_release[i] != DD_TIME_NEVER && !ddTimeBefore(now, generator_next_release[i]))
 		{
-			printf("deleteDDTask: could not send on scheduler queue.\n");
-			return false;
+			generator_next_release[i] = DD_TIME_NEVER;
+			xSemaphoreGiveFromISR(generator_release[i], &woken);
 		}
 	}
-	else
+
+	if (scheduler_deadline != DD_TIME_NEVER && !ddTimeBefore(now, scheduler_deadline))
 	{
-		printf("deleteDDTask: scheduler queue does not exist.\n");
-		return false;
+		scheduler_deadline = DD_TIME_NEVER;
+		vTaskNotifyGiveFromISR(scheduler_handle, &woken);
 	}
 
-	ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
-	vTaskDelete(del_task);
-	return true;
+	// The running job has used up its budget
+	if (ddBudgetExpiry() != DD_TIME_NEVER && !ddTimeBefore(now, ddBudgetExpiry()))
+	{
+		ddBudgetExpired();
+		vTaskNotifyGiveFromISR(scheduler_handle, &woken);
+	}
+
+	ddArmNextEvent();
+	portYIELD_FROM_ISR(woken);
 }
 
-bool getActiveDDTaskList(void)
+/*
+ * Gives each generator's jobs a preemption level from their relative
+ * deadline: one for the longest, higher for shorter ones, equal for equal
+ * ones. Each resource's ceiling is the highest level among its users.
+ */
+static void initResources(void)
 {
-	dd_message active_msg = {ACTIVE, NULL, NULL};
+	ddSrpInit(&job_srp, DD_RESOURCE_COUNT);
 
-	if (scheduler_queue != NULL)
+	for (uint32_t i = 0; i < DD_GENERATOR_COUNT; i++)
 	{
-		if (xQueueSend(scheduler_queue, &active_msg, portMAX_DELAY) != pdPASS)
+		generator_levels[i] = 0;
+
+		for (uint32_t j = 0; j < DD_GENERATOR_COUNT; j++)
 		{
-			printf("getActiveDDTaskList: could not send on scheduler queue.\n");
-			return false;
+			if (generator_configs[j].period >= generator_configs[i].period) generator_levels[i]++;
 		}
 	}
-	else
-	{
-		printf("getActiveDDTaskList: scheduler queue does not exist.\n");
-		return false;
-	}
 
-	if (scheduler_queue != NULL)
+	for (const dd_resource_use* use = resource_uses; use->generator != 0; use++)
 	{
-		if (xQueueReceive(scheduler_queue, &active_msg, portMAX_DELAY) == pdTRUE)
-		{
-			printf("Active Task List: \n%s\n", (char*)(active_msg.message_data));
-			vPortFree(active_msg.message_data);
-			active_msg.message_data = NULL;
-		}
+		ddSrpUse(&job_srp, use->resource, generator_levels[use->generator - 1]);
 	}
-	else
+}
+
+/* Starts every generator with a clean record; those without an (m,k) constraint are hard. */
+static void initOverload(void)
+{
+	for (uint32_t i = 0; i < DD_GENERATOR_COUNT; i++)
 	{
-		printf("getActiveDDTaskList: scheduler queue does not exist.\n");
-		return false;
+		ddMkInit(&generator_mk[i], 0, 0);
 	}
 
-	return true;
+	DD_TASK_SET_FIRM(DD_FIRM_INIT_ENTRY)
 }
 
-bool getCompletedDDTaskList(void)
+void initScheduler(void)
 {
-	dd_message completed_msg = {ACTIVE, NULL, NULL};
+	ddClockInit(ddClockEvent, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+	ddCyclesInit();
+	ddJobTableInit(&job_table);
+	initTaskList(&active_list);
+	initTaskList(&completed_list);
+	initTaskList(&overdue_list);
 
-	if (scheduler_queue != NULL)
-	{
-		if (xQueueSend(scheduler_queue, &completed_msg, portMAX_DELAY) != pdPASS)
-		{
-			printf("getCompletedDDTaskList: could not send on scheduler queue.\n");
-			return false;
-		}
-	}
-	else
+	ddRingInit(&scheduler_ring, scheduler_ring_storage, DD_SCHEDULER_RING_LENGTH, sizeof(dd_command));
+	ddRecorderInit(&scheduler_recorder, scheduler_records, DD_RECORD_LOG_LENGTH);
+	ddMissInit(miss_windows, DD_MAX_JOBS, &job_table, &active_list);
+	ddBudgetInit(job_budgets, DD_MAX_JOBS, ddArmNextEvent);
+	initResources();
+	initOverload();
+	ddArenaInit(&monitor_arena, monitor_arena_storage, sizeof(monitor_arena_storage));
+
+	// The replayer needs the list limits to make the same decisions
+	ddRecord(&scheduler_recorder, DD_RECORD_BOOT, ddClockNow(), DD_SLOT_NONE, 0, 0,
+			 ((uint32_t)DD_MAX_JOBS << 16) | ((uint32_t)DD_OVERDUE_LIST_MAX << 8) | (uint32_t)DD_TASK_RANGE);
+
+	ddHeapTaskCreate(schedulerTask, "DD Scheduler Task", DD_STACK_SCHEDULER, NULL, DD_TASK_PRIORITY_SCHEDULER, &scheduler_handle);
+
+#ifndef DD_FAST_BOOT
+	// A fast boot leaves this to the scheduler, after the first job is dispatched
+	ddHeapTaskCreate(monitorTask, "Monitor Task", DD_STACK_MONITOR, NULL, DD_TASK_PRIORITY_MONITOR, NULL);
+#endif
+}
+
+/*
+ * Replies to a command by writing the client's mailbox (if it passed one) and
+ * then notifying the client with the request ID. The notification value is
+ * overwritten, so a client only ever sees the reply to its latest request.
+ */
+static void schedulerReply(const dd_command* cmd, dd_reply* reply, void* data)
+{
+	if (reply != NULL)
 	{
-		printf("getCompletedDDTaskList: scheduler queue does not exist.\n");
-		return false;
+		reply->data = data;
 	}
 
-	if (scheduler_queue != NULL)
+	xTaskNotify(cmd->client, cmd->request_id, eSetValueWithOverwrite);
+}
+
+/* Trims the overdue list to the newest DD_OVERDUE_LIST_MAX entries. */
+static void schedulerTrimOverdue(void)
+{
+	while (overdue_list.list_length > DD_OVERDUE_LIST_MAX)
 	{
-		if (xQueueReceive(scheduler_queue, &completed_msg, portMAX_DELAY) == pdTRUE)
+		taskListRemoveFront(&overdue_list);
+	}
+}
+
+/*
+ * Moves jobs missed by now to the overdue list and trims it. Returns the
+ * number of jobs moved.
+ */
+static uint32_t schedulerCleanup(dd_time_t now)
+{
+	uint32_t moved = taskListCleanup(&active_list, &overdue_list, now);
+
+	schedulerTrimOverdue();
+	return moved;
+}
+
+/*
+ * Applies the budget policy to the jobs found past their budget since the
+ * last check, see dd_budget.h. Returns the number found.
+ */
+static uint32_t schedulerEnforceBudgets(dd_time_t now)
+{
+	uint32_t overruns = 0;
+	dd_slot cur_slot = active_list.list_head;
+
+	while (cur_slot != DD_SLOT_NONE)
+	{
+		dd_slot next_slot = job_table.next[cur_slot];
+		task cur_task = job_records[cur_slot];
+		uint32_t generator = cur_task->task_id - 1;
+
+		if (ddBudgetOverrun(cur_slot))
 		{
-			printf("Completed Task List: \n%s\n", (char*)(completed_msg.message_data));
-			vPortFree(completed_msg.message_data);
-			completed_msg.message_data = NULL;
+			overruns++;
+			if (generator < DD_GENERATOR_COUNT) generator_stats[generator].overruns++;
+			ddTraceEvent(DD_TRACE_BUDGET, (uint8_t)cur_task->task_id, ddTraceTaskId(job_table.handle[cur_slot]), DD_BUDGET_POLICY);
+
+			if (DD_BUDGET_POLICY == DD_BUDGET_SUSPEND)
+			{
+				// Parked until its deadline, where it is stopped like any missed job
+				vTaskSuspend((TaskHandle_t)job_table.handle[cur_slot]);
+				ddSrpReleaseAll(&job_srp, cur_slot);
+			}
+			else if (DD_BUDGET_POLICY == DD_BUDGET_ABORT)
+			{
+				taskListDrop(cur_slot, now, DD_RECORD_ABORT);
+				schedulerTrimOverdue();
+			}
+		}
+
+		cur_slot = next_slot;
+	}
+
+	// Jobs past their budget drop below the others, who also get the levels of jobs stopped
+	if (overruns > 0)
+	{
+		taskListReprioritise(&active_list);
+	}
+
+	return overruns;
+}
+
+/*
+ * Sheds active jobs by the overload policy until the rest can all make their
+ * deadlines in EDF order, see dd_overload.h. Returns the number shed.
+ */
+static uint32_t schedulerShedOverload(dd_time_t now)
+{
+	dd_overload_job jobs[DD_TASK_RANGE];
+	dd_slot slots[DD_TASK_RANGE];
+	uint32_t shed = 0;
+
+	if (DD_OVERLOAD_POLICY == DD_OVERLOAD_NONE)
+	{
+		return 0;
+	}
+
+	while (1)
+	{
+		uint32_t count = 0;
+
+		// Rebuilt after each job shed, since that changes its generator's (m,k) history
+		for (dd_slot cur_slot = active_list.list_head; cur_slot != DD_SLOT_NONE; cur_slot = job_table.next[cur_slot])
+		{
+			task cur_task = job_records[cur_slot];
+			uint32_t generator = cur_task->task_id - 1;
+			int64_t deadline = (int64_t)(job_table.deadline[cur_slot] - now);
+
+			slots[count] = cur_slot;
+			jobs[count].deadline = (deadline > INT32_MAX) ? INT32_MAX : (deadline < INT32_MIN) ? INT32_MIN : (int32_t)deadline;
+			jobs[count].remaining = jobRemaining(cur_slot);
+			jobs[count].value = class_values[cur_task->t_class] * cur_task->execution_time;
+			jobs[count].skippable = (generator < DD_GENERATOR_COUNT) && ddMkSkippable(&generator_mk[generator]);
+			count++;
+		}
+
+		uint32_t victim = ddOverloadShed(DD_OVERLOAD_POLICY, jobs, count);
+
+		if (victim == DD_OVERLOAD_KEEP_ALL)
+		{
+			break;
 		}
+
+		taskListShed(slots[victim], now);
+		schedulerTrimOverdue();
+		shed++;
+	}
+
+	if (shed > 0)
+	{
+		taskListReprioritise(&active_list);
+	}
+
+	return shed;
+}
+
+/* Logs the hot path cycle counts, see dd_cycles.h. */
+static void schedulerRecordCycles(dd_time_t now)
+{
+	dd_cycle_stats stats;
+
+	for (uint32_t i = 0; i < DD_CYCLE_PROBE_COUNT; i++)
+	{
+		if (ddCyclesGet((dd_cycle_probe)i, &stats))
+		{
+			uint64_t average = stats.sum / stats.count;
+
+			ddRecord(&scheduler_recorder, DD_RECORD_CYCLES, now, (average < DD_SLOT_NONE) ? (dd_slot)average : DD_SLOT_NONE,
+					 (uint8_t)i, 0, stats.max);
+		}
+	}
+}
+
+/* Logs a command with the time its cleanup ran, see dd_record.h. */
+static void schedulerRecordCommand(const dd_command* cmd, dd_time_t now)
+{
+	task cur_task = (task)cmd->payload;
+
+	if (cmd->type == CREATE)
+	{
+		ddRecord(&scheduler_recorder, DD_RECORD_CREATE, now, cur_task->slot, (uint8_t)cur_task->task_id,
+				 (uint8_t)cur_task->t_class, (uint32_t)(int32_t)(cur_task->absolute_deadline - now));
+	}
+	else if (cmd->type == DELETE)
+	{
+		ddRecord(&scheduler_recorder, DD_RECORD_DELETE, now, cur_task->slot, (uint8_t)cur_task->task_id, 0, 0);
 	}
 	else
 	{
-		printf("getCompletedDDTaskList: scheduler queue does not exist.\n");
+		// The list requests carry a mailbox rather than a task
+		ddRecord(&scheduler_recorder, DD_RECORD_ACTIVE + (cmd->type - ACTIVE), now, DD_SLOT_NONE, 0, 0, 0);
+	}
+}
+
+/*
+ * Handles a DELETE: the job has finished, so it leaves the active list and
+ * its record is freed. Called before any cleanup in the same pass, so the
+ * job is still active even if its deadline has passed since it finished.
+ * A job that finished after its deadline is left to the cleanup, which
+ * stops it as missed, so it gets no reply.
+ */
+static void schedulerComplete(const dd_command* cmd, dd_time_t now)
+{
+	task cur_task = (task)cmd->payload;
+	dd_slot slot = cur_task->slot;
+
+	if (!ddSlotListContains(&job_table, &active_list, slot) || ddTimeBefore(job_table.deadline[slot], cur_task->completion_time))
+	{
+		return;
+	}
+
+	// Log the command before handling it, since the record is freed
+	schedulerRecordCommand(cmd, now);
+
+	// Completed in time, so its work was useful
+	generator_stats[cur_task->task_id - 1].completed++;
+	generator_stats[cur_task->task_id - 1].useful_time += cur_task->execution_time;
+	jobRecordOutcome(cur_task, true);
+
+	ddTraceEvent(DD_TRACE_COMPLETE, (uint8_t)cur_task->task_id, ddTraceTaskId(cur_task->t_handle), 0);
+	ddSrpReleaseAll(&job_srp, slot);
+	ddBudgetStop(slot);
+	taskListRemove(cur_task, &active_list, true);
+
+	schedulerReply(cmd, NULL, NULL);
+}
+
+/* Tells the clock interrupt when the head of the active list will be missed. */
+static void schedulerPublishDeadline(void)
+{
+	taskENTER_CRITICAL();
+
+	// Missed means strictly past the deadline, so wake up one microsecond after it
+	scheduler_deadline = (active_list.list_head == DD_SLOT_NONE) ? DD_TIME_NEVER : job_table.deadline[active_list.list_head] + 1;
+	ddArmNextEvent();
+
+	taskEXIT_CRITICAL();
+}
+
+void schedulerTask(void *pvParameters)
+{
+	task cur_task = NULL;
+	dd_time_t now;
+
+	ddBootStamp(DD_BOOT_SCHEDULER_RUNNING);
+
+	// The generators sit below the scheduler, so they all see the epoch; the boot time is not release jitter
+	generator_epoch = ddClockNow();
+
+	// The idle and timer tasks only exist once the kernel has started
+	ddMissSetClass(NULL, DD_MISS_CLASS_SCHEDULER, DD_SLOT_NONE);
+	ddMissSetClass(xTaskGetIdleTaskHandle(), DD_MISS_CLASS_IDLE, DD_SLOT_NONE);
+	ddMissSetClass(xTimerGetTimerDaemonTaskHandle(), DD_MISS_CLASS_RELEASE, DD_SLOT_NONE);
+
+	while (1)
+	{
+		uint32_t count = 0;
+
+		// Nothing else runs while the scheduler does, so everything queued so far is one batch
+		while (count < DD_SCHEDULER_RING_LENGTH && ddRingPop(&scheduler_ring, &scheduler_batch[count]))
+		{
+			count++;
+		}
+
+		now = ddClockNow();
+
+		// Completions first: a job that finished in time must not be stopped by the cleanup while its DELETE waits
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (scheduler_batch[i].type == DELETE)
+			{
+				schedulerComplete(&scheduler_batch[i], now);
+			}
+		}
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			dd_command* cmd = &scheduler_batch[i];
+
+			if (cmd->type == DELETE)
+			{
+				continue;
+			}
+
+			// Log the command before handling it
+			schedulerCleanup(now);
+			schedulerRecordCommand(cmd, now);
+
+			if (cmd->type == CREATE)
+			{
+				// Add the task to the active list since it has been created
+				cur_task = (task)cmd->payload;
+				taskListInsert(cur_task, &active_list);
+				bool admitted = ddSlotListContains(&job_table, &active_list, cur_task->slot);
+
+				// Admission: the new job may push others, or itself, past their deadlines
+				if (admitted) schedulerShedOverload(now);
+
+				// Jobs wait suspended for this, see createDDTask(). A job that was shed never runs, and one
+				// the full list turned away is never run either, so its record is freed here
+				if (!admitted)
+				{
+					vTaskDelete(cur_task->t_handle);
+					deleteTask(cur_task);
+				}
+				else if (ddSlotListContains(&job_table, &active_list, cur_task->slot))
+				{
+					vTaskResume(cur_task->t_handle);
+				}
+
+				if (woke_from_sleep)
+				{
+					// First dispatch since the core woke up from a tickless sleep
+					uint32_t cycles_per_tick = SysTick->LOAD + 1;
+					uint32_t latency = (xTaskGetTickCount() - wake_tick) * cycles_per_tick + wake_systick - SysTick->VAL;
+
+					woke_from_sleep = false;
+					sleep_stats.dispatches++;
+					sleep_stats.latency_total += latency;
+					if (latency > sleep_stats.latency_max) sleep_stats.latency_max = latency;
+				}
+
+				schedulerReply(cmd, NULL, NULL);
+
+#ifdef DD_FAST_BOOT
+				if (ddBootStamp(DD_BOOT_FIRST_DISPATCH))
+				{
+					// Reporting was deferred until the first job could run, see dd_boot.h
+					ddHeapTaskCreate(monitorTask, "Monitor Task", DD_STACK_MONITOR, NULL, DD_TASK_PRIORITY_MONITOR, NULL);
+				}
+#else
+				ddBootStamp(DD_BOOT_FIRST_DISPATCH);
+#endif
+			}
+			else if (cmd->type == ACTIVE)
+			{
+				// The monitor asks for the active list once per cycle, so the counts go out with it
+				schedulerRecordCycles(now);
+				schedulerReply(cmd, (dd_reply*)cmd->payload, taskListReturnMessages(&active_list));
+			}
+			else if (cmd->type == COMPLETED)
+			{
+				schedulerReply(cmd, (dd_reply*)cmd->payload, taskListReturnMessages(&completed_list));
+			}
+			else if (cmd->type == OVERDUE)
+			{
+				schedulerReply(cmd, (dd_reply*)cmd->payload, taskListReturnMessages(&overdue_list));
+			}
+		}
+
+		// Only with every queued command handled, so that no job is stopped while its DELETE waits.
+		// Passes that change nothing are not worth a record
+		if (schedulerCleanup(now) > 0)
+		{
+			ddRecord(&scheduler_recorder, DD_RECORD_WAKE, now, DD_SLOT_NONE, 0, 0, 0);
+		}
+
+		// Dispatch: time has passed, and jobs that fell behind may no longer fit
+		schedulerEnforceBudgets(now);
+		schedulerShedOverload(now);
+		schedulerPublishDeadline();
+
+		// Sleep until a producer finds the ring drained and wakes us for the next batch
+		// The clock also wakes us when the earliest deadline is missed or a budget runs out
+		if (ddRingPrepareWait(&scheduler_ring))
+		{
+			ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		}
+	}
+}
+
+static uint16_t nextRequestId(void)
+{
+	static uint16_t request_id = 0;
+	uint16_t id;
+
+	taskENTER_CRITICAL();
+	// Zero is never used so that a cleared notification value cannot match a request
+	if (++request_id == 0) request_id = 1;
+	id = request_id;
+	taskEXIT_CRITICAL();
+
+	return id;
+}
+
+/*
+ * Sends a command to the scheduler and blocks until the reply to that
+ * request arrives on the calling task's notification value.
+ */
+static bool schedulerRequest(message_type type, void* payload)
+{
+	dd_command cmd;
+	dd_ring_status status;
+	uint32_t reply_id = 0;
+
+	if (scheduler_handle == NULL)
+	{
+		printf("schedulerRequest: scheduler has not been created.\n");
+		return false;
+	}
+
+	cmd.type = (uint8_t)type;
+	cmd.reserved = 0;
+	cmd.request_id = nextRequestId();
+	cmd.client = xTaskGetCurrentTaskHandle();
+	cmd.payload = payload;
+
+	// The ring only fills up if the scheduler is starved, so back off for a tick and retry
+	while ((status = ddRingPush(&scheduler_ring, &cmd)) == DD_RING_FULL)
+	{
+		vTaskDelay(1);
+	}
+
+	if (status == DD_RING_WAKE)
+	{
+		xTaskNotifyGive(scheduler_handle);
+	}
+
+	// Discard anything that is not the reply to this request
+	while (reply_id != cmd.request_id)
+	{
+		xTaskNotifyWait(0, 0xFFFFFFFF, &reply_id, portMAX_DELAY);
+	}
+
+	return true;
+}
+
+bool createDDTask(task new_task)
+{
+	if (new_task == NULL)
+	{
+		printf("createDDTask: task passed in was NULL.\n");
+		return false;
+	}
+
+	ddHeapTaskCreate(new_task->task_func, new_task->name, DD_STACK_JOB, (void*)new_task, DD_TASK_PRIORITY_MINIMUM, &(new_task->t_handle));
+
+	if (new_task->t_handle == NULL)
+	{
+		// Out of heap for the stack, so the job is never scheduled and its record is freed here
+		printf("createDDTask: failed to create new task.\n");
+		deleteTask(new_task);
+		return false;
+	}
+
+	// Suspend until the new task has been scheduled; the scheduler resumes it unless it is shed or turned away on admission
+	vTaskSuspend(new_task->t_handle);
+
+	if (!schedulerRequest(CREATE, new_task))
+	{
+		printf("createDDTask: could not schedule the new task.\n");
 		return false;
 	}
 
 	return true;
 }
 
+bool deleteDDTask(task del_task)
+{
+	if (del_task == NULL)
+	{
+		printf("deleteDDTask: task passed in was NULL.\n");
+		return false;
+	}
+
+	// The scheduler frees the task record, so keep the handle
+	TaskHandle_t del_handle = del_task->t_handle;
+
+	// Whether the job met its deadline is decided by when it finished, not when the scheduler gets to it
+	del_task->completion_time = ddClockNow();
+
+	if (!schedulerRequest(DELETE, del_task))
+	{
+		printf("deleteDDTask: could not remove the task.\n");
+		return false;
+	}
+
+	// The job has been through its deepest path, the request to the scheduler
+	ddStackSample(DD_STACK_TYPE_JOB, del_handle);
+
+	vTaskDelete(del_handle);
+	return true;
+}
+
+static bool printDDTaskList(message_type type, const char* title)
+{
+	dd_reply reply = {NULL};
+
+	if (!schedulerRequest(type, &reply))
+	{
+		return false;
+	}
+
+	if (reply.data != NULL)
+	{
+		// The reply lives in the monitor arena until the next cycle resets it
+		printf("%s Task List: \n%s\n", title, (char*)(reply.data));
+	}
+	else
+	{
+		printf("%s Task List: \ndoes not fit in the monitor arena\n", title);
+	}
+
+	return true;
+}
+
+bool getActiveDDTaskList(void)
+{
+	return printDDTaskList(ACTIVE, "Active");
+}
+
+bool getCompletedDDTaskList(void)
+{
+	return printDDTaskList(COMPLETED, "Completed");
+}
+
 bool getOverdueDDTaskList(void)
 {
-	dd_message overdue_msg = {ACTIVE, NULL, NULL};
+	return printDDTaskList(OVERDUE, "Overdue");
+}
+
+/*-------------------------- Shared Resource Code ---------------------------*/
+
+/*
+ * Takes a shared resource for a running job. Under the SRP it is always free
+ * by the time the job runs, so this never blocks. Resources must be
+ * unlocked in the reverse order.
+ */
+bool lockDDResource(task self, dd_resource resource)
+{
+	vTaskSuspendAll();
+
+	bool taken = ddSrpTake(&job_srp, resource, self->slot);
+
+	// The job running is normally the head; if not, a job ahead of it may now have to wait
+	if (taken && active_list.list_head != self->slot)
+	{
+		taskListReprioritise(&active_list);
+	}
+
+	xTaskResumeAll();
+
+	if (!taken)
+	{
+		printf("lockDDResource: %s is held, so a job uses it without being declared for it.\n", resource_names[resource]);
+		return false;
+	}
+
+	resource_stats[resource].taken_at = ddClockNow();
+	return true;
+}
+
+bool unlockDDResource(task self, dd_resource resource)
+{
+	dd_time_t now = ddClockNow();
+
+	vTaskSuspendAll();
+
+	bool given = ddSrpGive(&job_srp, resource, self->slot);
+
+	// Jobs that were mapped below this one get their EDF priorities back, and a job past its budget drops below them
+	if (given && (job_srp.gated || ddBudgetExhausted(self->slot)))
+	{
+		taskListReprioritise(&active_list);
+	}
+
+	xTaskResumeAll();
+
+	if (!given)
+	{
+		printf("unlockDDResource: %s is not the last resource this job locked.\n", resource_names[resource]);
+		return false;
+	}
+
+	dd_resource_stats* stats = &resource_stats[resource];
+	uint32_t held = (uint32_t)(now - stats->taken_at);
+
+	stats->takes++;
+	stats->hold_total += held;
+	if (held > stats->hold_max) stats->hold_max = held;
+
+	return true;
+}
+
+void printResourceStats(void)
+{
+	bool used = false;
 
-	if (scheduler_queue != NULL)
+	for (uint32_t i = 0; i < DD_RESOURCE_COUNT; i++)
 	{
-		if (xQueueSend(scheduler_queue, &overdue_msg, portMAX_DELAY) != pdPASS)
+		dd_resource_stats stats;
+
+		// Resources the task set does not use have no ceiling
+		if (job_srp.ceiling[i] == 0)
 		{
-			printf("getOverdueDDTaskList: could not send on scheduler queue.\n");
-			return false;
+			continue;
 		}
+
+		taskENTER_CRITICAL();
+		stats = resource_stats[i];
+		taskEXIT_CRITICAL();
+
+		used = true;
+		printf("Resource %s: Ceiling = %u, Takes = %u, Max Hold = %u us, Avg Hold = %u us\n", resource_names[i],
+				(unsigned int)job_srp.ceiling[i], (unsigned int)stats.takes, (unsigned int)stats.hold_max,
+				(unsigned int)((stats.takes == 0) ? 0 : stats.hold_total / stats.takes));
 	}
-	else
+
+	if (used)
 	{
-		printf("getOverdueDDTaskList: scheduler queue does not exist.\n");
-		return false;
+		printf("SRP: Gated Priority Mappings = %u\n", (unsigned int)srp_gated_mappings);
+	}
+}
+
+/*-------------------------- Task Generator Code ----------------------------*/
+
+#define DD_OVERRUN_TIME_ENTRY(generator, every, extra)	if ((generator) == task_id && release % (every) == 0) overrun += (extra);
+
+/* How far the job of a release runs past its execution time, see DD_TASK_SET_OVERRUNS. */
+static uint32_t jobOverrunTime(uint32_t task_id, uint32_t release)
+{
+	uint32_t overrun = 0;
+
+	DD_TASK_SET_OVERRUNS(DD_OVERRUN_TIME_ENTRY)
+	return overrun;
+}
+
+void taskGenerator(void *pvParameters)
+{
+	uint32_t generator_id = (uint32_t)pvParameters;
+	const dd_generator_config* config = &generator_configs[generator_id];
+	dd_generator_stats* stats = &generator_stats[generator_id];
+
+	// Jobs are released at exact multiples of the period from the common epoch, so releases never drift
+	// and the generators stay in phase
+	dd_time_t release = generator_epoch;
+
+	ddMissSetClass(NULL, DD_MISS_CLASS_RELEASE, DD_SLOT_NONE);
+
+	while (1)
+	{
+		uint32_t jitter = (uint32_t)(ddClockNow() - release);
+
+		stats->releases++;
+		stats->jitter_total += jitter;
+		if (jitter > stats->jitter_max) stats->jitter_max = jitter;
+
+		task new_task = createTask();
+
+		// Out of slots or heap means this release is skipped
+		if (new_task != NULL)
+		{
+			new_task->task_func = ddJobTask;
+			new_task->name = "DD Job";
+			new_task->type = config->type;
+			new_task->t_class = config->t_class;
+			new_task->task_id = generator_id + 1;
+			new_task->execution_time = config->execution_time;
+			new_task->overrun_time = jobOverrunTime(generator_id + 1, stats->releases);
+			new_task->release_time = release;
+			new_task->absolute_deadline = release + config->period;
+
+			createDDTask(new_task);
+		}
+
+		// Advances release by exactly one period and blocks until the clock's compare event reaches it
+		release += config->period;
+
+		taskENTER_CRITICAL();
+		generator_next_release[generator_id] = release;
+		ddArmNextEvent();
+		taskEXIT_CRITICAL();
+
+		xSemaphoreTake(generator_release[generator_id], portMAX_DELAY);
+	}
+}
+
+void printGeneratorStats(void)
+{
+	dd_time_t now = ddClockNow();
+	uint64_t useful_time = 0;
+
+	for (uint32_t i = 0; i < DD_GENERATOR_COUNT; i++)
+	{
+		dd_generator_stats* stats = &generator_stats[i];
+		uint32_t jitter_avg = (stats->releases == 0) ? 0 : (uint32_t)(stats->jitter_total / stats->releases);
+
+		printf("Generator %u: Releases = %u, Completed = %u, Shed = %u, Overruns = %u, Max Jitter = %u us, Avg Jitter = %u us\n",
+				(unsigned int)(i + 1), (unsigned int)stats->releases, (unsigned int)stats->completed,
+				(unsigned int)stats->shed, (unsigned int)stats->overruns, (unsigned int)stats->jitter_max,
+				(unsigned int)jitter_avg);
+		useful_time += stats->useful_time;
 	}
 
-	if (scheduler_queue != NULL)
+	// Execution time of the jobs that made their deadline, per second of uptime
+	printf("Overload Policy = %s, Budget Policy = %s, Useful Work = %u us/s\n", ddOverloadPolicyName(DD_OVERLOAD_POLICY),
+			ddBudgetPolicyName(DD_BUDGET_POLICY), (unsigned int)((now == 0) ? 0 : useful_time * 1000000 / now));
+}
+
+/* Busy waits until the job has run for until us in all, only counting time while running. */
+static uint32_t jobExecute(task self, uint32_t executed, uint32_t until)
+{
+	dd_time_t prev_time = ddClockNow();
+
+	while (executed < until)
 	{
-		if (xQueueReceive(scheduler_queue, &overdue_msg, portMAX_DELAY) == pdTRUE)
+		dd_time_t cur_time = ddClockNow();
+		uint32_t gap = (uint32_t)(cur_time - prev_time);
+
+		if (gap < DD_JOB_PREEMPT_GAP_US)
 		{
-			printf("Overdue Task List: \n%s\n", (char*)(overdue_msg.message_data));
-			vPortFree(overdue_msg.message_data);
-			overdue_msg.message_data = NULL;
+			executed += gap;
+			self->executed_time = executed;
 		}
+
+		prev_time = cur_time;
 	}
-	else
+
+	return executed;
+}
+
+void ddJobTask(void *pvParameters)
+{
+	task self = (task)pvParameters;
+	uint32_t executed = 0;
+
+	// Critical sections come first and count towards the execution time, see dd_task_sets.h
+	for (const dd_resource_use* use = resource_uses; use->generator != 0; use++)
+	{
+		if (use->generator == self->task_id && lockDDResource(self, use->resource))
+		{
+			executed = jobExecute(self, executed, executed + use->length);
+			unlockDDResource(self, use->resource);
+		}
+	}
+
+	// A misbehaving job runs past what it declared, see dd_budget.h
+	jobExecute(self, executed, self->execution_time + self->overrun_time);
+	deleteDDTask(self);
+}
+
+/*-------------------------- Slack Stealing Code ----------------------------*/
+
+/*
+ * Returns the number of whole ticks from now that the CPU can spend on other
+ * work without any DD job missing its deadline. Every active job and the
+ * next release of every generator is taken in EDF order, see dd_slack.h.
+ * The computation itself is in microseconds.
+ */
+TickType_t ddAvailableSlack(dd_time_t now)
+{
+	uint32_t deadlines[DD_TASK_RANGE + DD_GENERATOR_COUNT];
+	uint32_t demands[DD_TASK_RANGE + DD_GENERATOR_COUNT];
+	dd_time_t next_release[DD_GENERATOR_COUNT];
+	uint32_t count = 0;
+
+	vTaskSuspendAll();
+
+	dd_slot cur_slot = active_list.list_head;
+
+	// The active list is already in deadline order
+	while (cur_slot != DD_SLOT_NONE && count < DD_TASK_RANGE)
+	{
+		// Relative to now, so a passed deadline shows up as negative
+		deadlines[count] = (uint32_t)(job_table.deadline[cur_slot] - now);
+		demands[count] = jobRemaining(cur_slot);
+		count++;
+		cur_slot = job_table.next[cur_slot];
+	}
+
+	// 64-bit loads are not atomic on the target, and the clock interrupt updates the releases too
+	taskENTER_CRITICAL();
+	memcpy(next_release, generator_next_release, sizeof(next_release));
+	taskEXIT_CRITICAL();
+
+	xTaskResumeAll();
+
+	for (uint32_t i = 0; i < DD_GENERATOR_COUNT; i++)
+	{
+		// Skip generators whose next release is not known yet or has already happened
+		if (next_release[i] == DD_TIME_NEVER || (uint32_t)(next_release[i] - now) > generator_configs[i].period)
+		{
+			continue;
+		}
+
+		count = ddSlackInsert(deadlines, demands, count, (uint32_t)(next_release[i] - now) + generator_configs[i].period,
+							  generator_configs[i].execution_time);
+	}
+
+	uint32_t slack = ddSlack(deadlines, demands, count);
+
+	return (slack == DD_SLACK_UNBOUNDED) ? portMAX_DELAY : slack / DD_US_PER_TICK;
+}
+
+bool registerBackgroundJob(dd_background_func func, const char* name, TickType_t wcet, TickType_t period)
+{
+	if (func == NULL)
+	{
+		printf("registerBackgroundJob: function passed in was NULL.\n");
+		return false;
+	}
+
+	if (background_job_count == DD_BACKGROUND_MAX_JOBS)
 	{
-		printf("getOverdueDDTaskList: scheduler queue does not exist.\n");
+		printf("registerBackgroundJob: cannot register any more background jobs.\n");
 		return false;
 	}
 
+	dd_background_job* job = &background_jobs[background_job_count];
+	job->func = func;
+	job->name = name;
+	job->wcet = wcet;
+	job->period = period;
+	job->last_run = 0;
+	job->runs = 0;
+	job->deferrals = 0;
+
+	background_job_count++;
 	return true;
 }
 
-static void apTimerCallback(xTimerHandle xTimer)
+static void runBackgroundJobs(void)
+{
+	dd_time_t now = ddClockNow();
+
+	for (uint32_t i = 0; i < background_job_count; i++)
+	{
+		dd_background_job* job = &background_jobs[i];
+
+		if (job->runs != 0 && now - job->last_run < (dd_time_t)job->period * DD_US_PER_TICK)
+		{
+			continue;
+		}
+
+		if (ddAvailableSlack(now) <= job->wcet)
+		{
+			job->deferrals++;
+			continue;
+		}
+
+		job->func();
+		job->last_run = now;
+		job->runs++;
+	}
+}
+
+static void backgroundHeapCheck(void)
+{
+	ddHeapSample();
+}
+
+void printBackgroundStats(void)
+{
+	printf("Deadline Misses = %u\n", (unsigned int)deadline_misses);
+
+	for (uint32_t i = 0; i < background_job_count; i++)
+	{
+		printf("Background %s: Runs = %u, Deferrals = %u\n", background_jobs[i].name,
+				(unsigned int)background_jobs[i].runs, (unsigned int)background_jobs[i].deferrals);
+	}
+}
+
+/*-------------------------- Tickless Idle Code -----------------------------*/
+
+/*
+ * Returns the number of whole ticks until the next DD scheduling event,
+ * which is the earliest of the next generator release and the moment the
+ * earliest active deadline is missed, capped at horizon. The clock's compare
+ * interrupt wakes the core for the event itself; this keeps the kernel from
+ * planning a sleep past it.
+ */
+TickType_t ddTicksToNextEvent(dd_time_t now, TickType_t horizon)
+{
+	dd_time_t next_event = now + (dd_time_t)horizon * DD_US_PER_TICK;
+
+	taskENTER_CRITICAL();
+
+	for (uint32_t i = 0; i < DD_GENERATOR_COUNT; i++)
+	{
+		if (generator_next_release[i] != DD_TIME_NEVER && ddTimeBefore(generator_next_release[i], next_event))
+		{
+			next_event = generator_next_release[i];
+		}
+	}
+
+	if (scheduler_deadline != DD_TIME_NEVER && ddTimeBefore(scheduler_deadline, next_event))
+	{
+		next_event = scheduler_deadline;
+	}
+
+	taskEXIT_CRITICAL();
+
+	return ddTimeBefore(next_event, now) ? 0 : (TickType_t)((next_event - now) / DD_US_PER_TICK);
+}
+
+void vDDSuppressTicksAndSleep(uint32_t xExpectedIdleTime)
+{
+	// Runs in the idle task with the kernel suspended
+	TickType_t now = xTaskGetTickCount();
+	TickType_t horizon = ddTicksToNextEvent(ddClockNow(), xExpectedIdleTime);
+	uint32_t wakeups = sleep_stats.wakeups;
+
+	if (horizon < configEXPECTED_IDLE_TIME_BEFORE_SLEEP)
+	{
+		return;
+	}
+
+	vPortSuppressTicksAndSleep(horizon);
+
+	if (sleep_stats.wakeups != wakeups)
+	{
+		wake_tick = xTaskGetTickCount();
+		wake_systick = SysTick->VAL;
+		sleep_stats.slept_ticks += wake_tick - now;
+		woke_from_sleep = true;
+	}
+}
+
+void vDDPostSleepProcessing(void)
+{
+	sleep_stats.wakeups++;
+}
+
+void printSleepStats(void)
+{
+	uint32_t seconds = xTaskGetTickCount() / configTICK_RATE_HZ;
+	uint32_t latency_avg = (sleep_stats.dispatches == 0) ? 0 : sleep_stats.latency_total / sleep_stats.dispatches;
+
+	printf("Sleep: Wakeups/s = %u, Slept Ticks = %u, Avg Wake Latency = %u cycles, Max Wake Latency = %u cycles\n",
+			(unsigned int)((seconds == 0) ? sleep_stats.wakeups : sleep_stats.wakeups / seconds),
+			(unsigned int)sleep_stats.slept_ticks, (unsigned int)latency_avg, (unsigned int)sleep_stats.latency_max);
+}
+
+/*-------------------------- Stack Report Code ------------------------------*/
+
+/* Samples the long lived tasks and prints the stack report, see dd_stack.h. */
+void printStackStats(void)
+{
+	ddStackSample(DD_STACK_TYPE_SCHEDULER, scheduler_handle);
+	ddStackSample(DD_STACK_TYPE_MONITOR, NULL);
+	ddStackSample(DD_STACK_TYPE_IDLE, xTaskGetIdleTaskHandle());
+	ddStackSample(DD_STACK_TYPE_TIMER, xTimerGetTimerDaemonTaskHandle());
+
+	for (uint32_t i = 0; i < DD_GENERATOR_COUNT; i++)
+	{
+		if (generator_handles[i] != NULL)
+		{
+			ddStackSample(DD_STACK_TYPE_GENERATOR, generator_handles[i]);
+		}
+	}
+
+	ddStackPrintReport();
+}
+
+/*-------------------------- Event Log Code ---------------------------------*/
+
+/*
+ * Prints the scheduler's event log as "DDLOG <hex>" lines of up to
+ * DD_RECORD_LINE_RECORDS records each, for dd_replay to read back.
+ */
+void printEventLog(void)
+{
+	// Only the monitor prints the log, so the line buffers stay off its stack
+	static dd_record records[DD_RECORD_LINE_RECORDS];
+	static char line[DD_RECORD_LINE_RECORDS * DD_RECORD_HEX_LENGTH + 1];
+	uint32_t count;
+
+	while ((count = ddRecorderDrain(&scheduler_recorder, records, DD_RECORD_LINE_RECORDS)) > 0)
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			ddRecordEncodeHex(&records[i], &line[i * DD_RECORD_HEX_LENGTH]);
+		}
+
+		printf("DDLOG %s\n", line);
+	}
+}
+
+/*
+ * Prints the trace ring as "DDTRACE <hex>" lines of up to
+ * DD_RECORD_LINE_RECORDS events each, for dd_trace_export to read back.
+ */
+void printTraceLog(void)
 {
-	task ap_task = (task)pvTimerGetTimerID(xTimer);
+	// Only the monitor prints the trace, so the line buffers stay off its stack
+	static dd_trace_event events[DD_RECORD_LINE_RECORDS];
+	static char line[DD_RECORD_LINE_RECORDS * DD_TRACE_HEX_LENGTH + 1];
+	uint32_t count;
 
-	xTimerDelete(ap_task->aperiodic_timer, 0);
-	ap_task->aperiodic_timer = NULL;
+	while ((count = ddTraceDrain(events, DD_RECORD_LINE_RECORDS)) > 0)
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			ddHexEncode(&events[i], sizeof(dd_trace_event), &line[i * DD_TRACE_HEX_LENGTH]);
+		}
 
-	vTaskSuspend(ap_task->t_handle);
-	vTaskDelete(ap_task->t_handle);
+		printf("DDTRACE %s\n", line);
+	}
 }
 
 /*-------------------------- Monitor Task Code ------------------------------*/
 
+static void printArenaStats(void)
+{
+	printf("Monitor Arena: Used = %u of %u B in %u, Peak = %u B, Failures = %u\n",
+			(unsigned int)monitor_arena.used, (unsigned int)monitor_arena.size, (unsigned int)monitor_arena.allocs,
+			(unsigned int)monitor_arena.peak, (unsigned int)monitor_arena.failures);
+}
+
 void monitorTask ( void *pvParameters )
 {
 	vTaskDelay(10000);
+	ddBootPrintProfile();
 
     while(1)
     {
     	printf("\nMonitorTask: Current Time = %u, Priority = %u\n", (unsigned int)xTaskGetTickCount(), (unsigned int)uxTaskPriorityGet(NULL));
+
+        // Last cycle's replies have been printed, so their memory can be reused
+        ddArenaReset(&monitor_arena);
         getActiveDDTaskList();
         getCompletedDDTaskList();
         getOverdueDDTaskList();
+        printGeneratorStats();
+        printSleepStats();
+        printBackgroundStats();
+        ddMissPrint();
+        printResourceStats();
+        ddCyclesPrint();
+        printArenaStats();
+        ddHeapPrintStats();
+        printStackStats();
+        printEventLog();
+        printTraceLog();
         vTaskDelay(100);
     }
 }
@@ -836,7 +1855,16 @@ void vApplicationMallocFailedHook( void )
 	free memory available in the FreeRTOS heap.  pvPortMalloc() is called
 	internally by FreeRTOS API functions that create tasks, queues, software 
 	timers, and semaphores.  The size of the FreeRTOS heap is set by the
-	configTOTAL_HEAP_SIZE configuration constant in FreeRTOSConfig.h. */
+	configTOTAL_HEAP_SIZE configuration constant in FreeRTOSConfig.h.
+
+	The heap probes of ddHeapSample() fail on purpose and are let through.
+	Any other failure has already been counted against its call site by the
+	heap telemetry (see dd_heap.h), and stops here. */
+	if( ddHeapProbing() )
+	{
+		return;
+	}
+
 	for( ;; );
 }
 
@@ -855,23 +1883,14 @@ void vApplicationStackOverflowHook( xTaskHandle pxTask, signed char *pcTaskName
 
 void vApplicationIdleHook( void )
 {
-volatile size_t xFreeStackSpace;
-
 	/* The idle task hook is enabled by setting configUSE_IDLE_HOOK to 1 in
 	FreeRTOSConfig.h.
 
-	This function is called on each cycle of the idle task.  In this case it
-	does nothing useful, other than report the amount of FreeRTOS heap that
-	remains unallocated. */
-	xFreeStackSpace = xPortGetFreeHeapSize();
-
-	if( xFreeStackSpace > 100 )
-	{
-		/* By now, the kernel has allocated everything it is going to, so
-		if there is a lot of heap remaining unallocated then
-		the value of configTOTAL_HEAP_SIZE in FreeRTOSConfig.h can be
-		reduced accordingly. */
-	}
+	This function is called on each cycle of the idle task.  It runs any
+	registered background jobs that are due, as long as the DD jobs have
+	enough slack to absorb them.  The largest free heap block is sampled by
+	one of these jobs (backgroundHeapCheck). */
+	runBackgroundJobs();
 }
 
 /*-------------------------- Hardware Setup ---------------------------------*/
@@ -71,6 +71,24 @@ defined in linker script */
   .type  Reset_Handler, %function
 Reset_Handler:  
 
+/* Start the DWT cycle counter for the boot profile (see dd_boot.h):
+   set TRCENA in DEMCR, clear CYCCNT and set CYCCNTENA in DWT_CTRL. */
+  ldr  r0, =0xE000EDFC
+  ldr  r1, [r0]
+  orr  r1, r1, #0x01000000
+  str  r1, [r0]
+  ldr  r0, =0xE0001004
+  movs  r1, #0
+  str  r1, [r0]
+  ldr  r0, =0xE0001000
+  ldr  r1, [r0]
+  orr  r1, r1, #1
+  str  r1, [r0]
+
+/* Start the HSE oscillator so that it settles while memory is initialised.
+   Does nothing unless built with DD_FAST_BOOT. */
+  bl  SystemClockStart
+
 /* Copy the data segment initializers from flash to SRAM */  
   movs  r1, #0
   b  LoopCopyDataInit
@@ -99,8 +117,15 @@ LoopFillZerobss:
   cmp  r2, r3
   bcc  FillZerobss
 
+/* Stamp DD_BOOT_MEMORY_READY */
+  movs  r0, #1
+  bl  ddBootStamp
+
 /* Call the clock system intitialization function.*/
   bl  SystemInit   
+/* Stamp DD_BOOT_SYSTEM_INIT */
+  movs  r0, #2
+  bl  ddBootStamp
 /* Call static constructors */
     bl __libc_init_array
 /* Call the application's entry point.*/
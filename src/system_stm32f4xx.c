@@ -182,6 +182,9 @@
   */
 
 static void SetSysClock(void);
+#ifdef DD_FAST_BOOT
+  static void SetSysClockStart(void);
+#endif /* DD_FAST_BOOT */
 #ifdef DATA_IN_ExtSRAM
   static void SystemInit_ExtMemCtl(void); 
 #endif /* DATA_IN_ExtSRAM */
@@ -215,8 +218,13 @@ void SystemInit(void)
   /* Reset CFGR register */
   RCC->CFGR = 0x00000000;
 
+#ifdef DD_FAST_BOOT
+  /* Reset CSSON and PLLON bits, HSEON was set by SystemClockStart() */
+  RCC->CR &= (uint32_t)0xFEF7FFFF;
+#else
   /* Reset HSEON, CSSON and PLLON bits */
   RCC->CR &= (uint32_t)0xFEF6FFFF;
+#endif /* DD_FAST_BOOT */
 
   /* Reset PLLCFGR register */
   RCC->PLLCFGR = 0x24003010;
@@ -233,7 +241,12 @@ void SystemInit(void)
          
   /* Configure the System clock source, PLL Multiplier and Divider factors, 
      AHB/APBx prescalers and Flash settings ----------------------------------*/
+#ifdef DD_FAST_BOOT
+  /* The switch to the PLL is left to SystemClockFinish() */
+  SetSysClockStart();
+#else
   SetSysClock();
+#endif /* DD_FAST_BOOT */
 
   /* Configure the Vector Table location add offset address ------------------*/
 #ifdef VECT_TAB_SRAM
@@ -407,6 +420,102 @@ static void SetSysClock(void)
 
 }
 
+/**
+  * @brief  Starts the HSE oscillator. Called by Reset_Handler before .data
+  *         and .bss are initialised, so it must not use either.
+  * @note   Does nothing unless built with DD_FAST_BOOT, see dd_boot.h.
+  * @param  None
+  * @retval None
+  */
+void SystemClockStart(void)
+{
+#ifdef DD_FAST_BOOT
+  RCC->CR |= ((uint32_t)RCC_CR_HSEON);
+#endif /* DD_FAST_BOOT */
+}
+
+/**
+  * @brief  Waits for the PLL started by SystemInit() to lock and selects it
+  *         as the system clock source. Until then the core runs from the HSI.
+  * @note   Does nothing unless built with DD_FAST_BOOT, see dd_boot.h.
+  * @param  None
+  * @retval None
+  */
+void SystemClockFinish(void)
+{
+#ifdef DD_FAST_BOOT
+  /* The PLL is only on if the HSE started */
+  if ((RCC->CR & RCC_CR_PLLON) == 0)
+  {
+    return;
+  }
+
+  /* Wait till the main PLL is ready */
+  while((RCC->CR & RCC_CR_PLLRDY) == 0)
+  {
+  }
+
+  /* Configure Flash prefetch, Instruction cache, Data cache and wait state */
+  FLASH->ACR = FLASH_ACR_ICEN |FLASH_ACR_DCEN |FLASH_ACR_LATENCY_5WS;
+
+  /* Select the main PLL as system clock source */
+  RCC->CFGR &= (uint32_t)((uint32_t)~(RCC_CFGR_SW));
+  RCC->CFGR |= RCC_CFGR_SW_PLL;
+
+  /* Wait till the main PLL is used as system clock source */
+  while ((RCC->CFGR & (uint32_t)RCC_CFGR_SWS ) != RCC_CFGR_SWS_PLL)
+  {
+  }
+#endif /* DD_FAST_BOOT */
+}
+
+#ifdef DD_FAST_BOOT
+/**
+  * @brief  First half of SetSysClock(): waits for the HSE started by
+  *         SystemClockStart(), configures the prescalers and starts the PLL,
+  *         without waiting for it to lock.
+  * @param  None
+  * @retval None
+  */
+static void SetSysClockStart(void)
+{
+  __IO uint32_t StartUpCounter = 0, HSEStatus = 0;
+
+  /* Wait till HSE is ready and if Time out is reached exit */
+  do
+  {
+    HSEStatus = RCC->CR & RCC_CR_HSERDY;
+    StartUpCounter++;
+  } while((HSEStatus == 0) && (StartUpCounter != HSE_STARTUP_TIMEOUT));
+
+  if ((RCC->CR & RCC_CR_HSERDY) == RESET)
+  {
+    /* Stay on the HSI, SystemClockFinish() sees the PLL is off */
+    return;
+  }
+
+  /* Enable high performance mode, System frequency up to 168 MHz */
+  RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+  PWR->CR |= PWR_CR_PMODE;  
+
+  /* HCLK = SYSCLK / 1*/
+  RCC->CFGR |= RCC_CFGR_HPRE_DIV1;
+
+  /* PCLK2 = HCLK / 2*/
+  RCC->CFGR |= RCC_CFGR_PPRE2_DIV2;
+
+  /* PCLK1 = HCLK / 4*/
+  RCC->CFGR |= RCC_CFGR_PPRE1_DIV4;
+
+  /* Configure the main PLL */
+  RCC->PLLCFGR = PLL_M | (PLL_N << 6) | (((PLL_P >> 1) -1) << 16) |
+                 (RCC_PLLCFGR_PLLSRC_HSE) | (PLL_Q << 24);
+
+  /* Enable the main PLL */
+  RCC->CR |= RCC_CR_PLLON;
+}
+#endif /* DD_FAST_BOOT */
+
 /**
   * @brief  Setup the external memory controller. Called in startup_stm32f4xx.s 
   *          before jump to __main
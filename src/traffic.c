@@ -0,0 +1,303 @@
+/*
+ * traffic.c
+ *
+ * Corridor traffic model. See traffic.h for an overview.
+ *
+ * Cars enter at cell 0 and move one cell towards the end of the road per
+ * step. A car is blocked if the next cell is occupied, or if it is waiting on
+ * a light's stop cell and that light is not green. The road is walked from
+ * the far end back to the entry so that a queue that starts moving moves as
+ * a whole in the same step, and each step costs time linear in the road
+ * length (empty words of the bitmap are skipped).
+ */
+
+#include "traffic.h"
+
+#ifndef HOST_BUILD
+#include <stdio.h>
+#endif
+
+/*-------------------------- Light Controller Code --------------------------*/
+
+static void trafficLightRetime(traffic_light* light, const traffic_timing* timing, uint32_t flow)
+{
+	// Green is proportional to the flow, red is inversely proportional. Red is
+	// rounded the other way to green so that equal ranges always add up to the
+	// same cycle length.
+	light->green_steps = timing->green_min_steps + (timing->green_range_steps * flow) / TRAFFIC_FLOW_MAX;
+	light->red_steps = timing->red_min_steps + timing->red_range_steps - (timing->red_range_steps * flow) / TRAFFIC_FLOW_MAX;
+}
+
+static void trafficLightUpdate(traffic_light* light, const traffic_timing* timing, uint64_t step)
+{
+	uint32_t cycle = light->green_steps + timing->yellow_steps + light->red_steps;
+	uint32_t phase = (uint32_t)((step + cycle - (light->offset % cycle)) % cycle);
+
+	if (phase < light->green_steps)
+	{
+		light->state = LIGHT_GREEN;
+	}
+	else if (phase < light->green_steps + timing->yellow_steps)
+	{
+		light->state = LIGHT_YELLOW;
+	}
+	else
+	{
+		light->state = LIGHT_RED;
+	}
+}
+
+/*-------------------------- Corridor Code ----------------------------------*/
+
+void trafficTimingDefault(traffic_timing* timing)
+{
+	timing->green_min_steps = TRAFFIC_GREEN_MIN_STEPS;
+	timing->green_range_steps = TRAFFIC_PHASE_RANGE_STEPS;
+	timing->red_min_steps = TRAFFIC_RED_MIN_STEPS;
+	timing->red_range_steps = TRAFFIC_PHASE_RANGE_STEPS;
+	timing->yellow_steps = TRAFFIC_YELLOW_STEPS;
+}
+
+bool trafficCorridorSetTiming(traffic_corridor* corridor, const traffic_timing* timing)
+{
+	if ((corridor == NULL) || (timing == NULL))
+	{
+		printf("trafficCorridorSetTiming: corridor or timing passed in was NULL.\n");
+		return false;
+	}
+
+	// Every light needs a green phase, otherwise no car can ever leave the road
+	if (timing->green_min_steps == 0)
+	{
+		printf("trafficCorridorSetTiming: minimum green time must be at least one step.\n");
+		return false;
+	}
+
+	corridor->timing = *timing;
+
+	for (uint32_t i = 0; i < corridor->num_lights; i++)
+	{
+		trafficLightRetime(&(corridor->lights[i]), &(corridor->timing), corridor->flow);
+	}
+
+	return true;
+}
+
+bool trafficCorridorInit(traffic_corridor* corridor, uint32_t num_lights, uint32_t spacing, coord_mode mode, uint32_t seed)
+{
+	if (corridor == NULL)
+	{
+		printf("trafficCorridorInit: corridor passed in was NULL.\n");
+		return false;
+	}
+
+	if (num_lights == 0 || num_lights > TRAFFIC_MAX_LIGHTS || spacing == 0)
+	{
+		printf("trafficCorridorInit: invalid number of lights or spacing.\n");
+		return false;
+	}
+
+	// One block of road before each light, plus one block after the last light
+	corridor->road_length = (num_lights + 1) * spacing;
+	corridor->road_words = (corridor->road_length + 31) / 32;
+	corridor->num_lights = num_lights;
+	corridor->spacing = spacing;
+	corridor->mode = mode;
+	corridor->flow = 0;
+	corridor->rng_state = seed;
+	trafficTimingDefault(&(corridor->timing));
+
+	corridor->road = (uint32_t*)TRAFFIC_MALLOC(corridor->road_words * sizeof(uint32_t));
+	corridor->stopped = (uint32_t*)TRAFFIC_MALLOC(corridor->road_words * sizeof(uint32_t));
+	corridor->entry_step = (uint32_t*)TRAFFIC_MALLOC(corridor->road_length * sizeof(uint32_t));
+	corridor->stops = (uint16_t*)TRAFFIC_MALLOC(corridor->road_length * sizeof(uint16_t));
+	corridor->lights = (traffic_light*)TRAFFIC_MALLOC(num_lights * sizeof(traffic_light));
+
+	if (corridor->road == NULL || corridor->stopped == NULL || corridor->entry_step == NULL ||
+		corridor->stops == NULL || corridor->lights == NULL)
+	{
+		printf("trafficCorridorInit: could not allocate the corridor.\n");
+		trafficCorridorFree(corridor);
+		return false;
+	}
+
+	for (uint32_t i = 0; i < corridor->road_words; i++)
+	{
+		corridor->road[i] = 0;
+		corridor->stopped[i] = 0;
+	}
+
+	for (uint32_t i = 0; i < num_lights; i++)
+	{
+		traffic_light* light = &(corridor->lights[i]);
+		light->stop_cell = (i + 1) * spacing - 1;
+
+		// In a green wave a car that enters at the start of a cycle reaches each light as it turns green
+		light->offset = (mode == COORD_GREEN_WAVE) ? light->stop_cell : 0;
+		light->state = LIGHT_GREEN;
+		trafficLightRetime(light, &(corridor->timing), corridor->flow);
+	}
+
+	corridor->stats.steps = 0;
+	corridor->stats.cars_entered = 0;
+	corridor->stats.cars_exited = 0;
+	corridor->stats.cars_on_road = 0;
+	corridor->stats.total_travel_steps = 0;
+	corridor->stats.total_stops = 0;
+
+	return true;
+}
+
+void trafficCorridorFree(traffic_corridor* corridor)
+{
+	if (corridor == NULL)
+	{
+		return;
+	}
+
+	if (corridor->road != NULL) TRAFFIC_FREE(corridor->road);
+	if (corridor->stopped != NULL) TRAFFIC_FREE(corridor->stopped);
+	if (corridor->entry_step != NULL) TRAFFIC_FREE(corridor->entry_step);
+	if (corridor->stops != NULL) TRAFFIC_FREE(corridor->stops);
+	if (corridor->lights != NULL) TRAFFIC_FREE(corridor->lights);
+
+	corridor->road = NULL;
+	corridor->stopped = NULL;
+	corridor->entry_step = NULL;
+	corridor->stops = NULL;
+	corridor->lights = NULL;
+	corridor->num_lights = 0;
+}
+
+void trafficCorridorSetFlow(traffic_corridor* corridor, uint32_t flow)
+{
+	if (flow > TRAFFIC_FLOW_MAX)
+	{
+		flow = TRAFFIC_FLOW_MAX;
+	}
+
+	corridor->flow = flow;
+
+	for (uint32_t i = 0; i < corridor->num_lights; i++)
+	{
+		trafficLightRetime(&(corridor->lights[i]), &(corridor->timing), flow);
+	}
+}
+
+static inline bool trafficCellBlockedByLight(const traffic_corridor* corridor, uint32_t cell)
+{
+	uint32_t block = (cell + 1) / corridor->spacing;
+
+	if ((cell + 1) % corridor->spacing != 0 || block > corridor->num_lights)
+	{
+		return false;
+	}
+
+	return corridor->lights[block - 1].state != LIGHT_GREEN;
+}
+
+void trafficCorridorStep(traffic_corridor* corridor)
+{
+	uint32_t last_cell = corridor->road_length - 1;
+	uint32_t now = (uint32_t)corridor->stats.steps;
+
+	for (uint32_t i = 0; i < corridor->num_lights; i++)
+	{
+		trafficLightUpdate(&(corridor->lights[i]), &(corridor->timing), corridor->stats.steps);
+	}
+
+	// Walk the road from the far end so that cars ahead move out of the way first
+	for (uint32_t w = corridor->road_words; w-- > 0; )
+	{
+		uint32_t bits = corridor->road[w];
+
+		while (bits != 0)
+		{
+			uint32_t bit = 31 - __builtin_clz(bits);
+			uint32_t cell = (w << 5) + bit;
+			uint32_t mask = 1UL << bit;
+			bits &= ~mask;
+
+			if (cell == last_cell)
+			{
+				// The car leaves the road
+				corridor->road[w] &= ~mask;
+				corridor->stopped[w] &= ~mask;
+				corridor->stats.cars_exited++;
+				corridor->stats.cars_on_road--;
+				corridor->stats.total_travel_steps += (uint32_t)(now - corridor->entry_step[cell]) + 1;
+				corridor->stats.total_stops += corridor->stops[cell];
+				continue;
+			}
+
+			uint32_t next = cell + 1;
+
+			if (trafficCellOccupied(corridor, next) || trafficCellBlockedByLight(corridor, cell))
+			{
+				// Only count a stop when a moving car comes to rest
+				if ((corridor->stopped[w] & mask) == 0)
+				{
+					corridor->stopped[w] |= mask;
+					corridor->stops[cell]++;
+				}
+				continue;
+			}
+
+			corridor->road[w] &= ~mask;
+			corridor->stopped[w] &= ~mask;
+			corridor->road[next >> 5] |= (1UL << (next & 31));
+			corridor->stopped[next >> 5] &= ~(1UL << (next & 31));
+			corridor->entry_step[next] = corridor->entry_step[cell];
+			corridor->stops[next] = corridor->stops[cell];
+		}
+	}
+
+	// A new car appears at the entry with a probability proportional to the flow
+	corridor->rng_state = corridor->rng_state * 1664525UL + 1013904223UL;
+
+	if (((corridor->rng_state >> 20) & TRAFFIC_FLOW_MAX) < corridor->flow && !trafficCellOccupied(corridor, 0))
+	{
+		corridor->road[0] |= 1;
+		corridor->stopped[0] &= ~1UL;
+		corridor->entry_step[0] = now;
+		corridor->stops[0] = 0;
+		corridor->stats.cars_entered++;
+		corridor->stats.cars_on_road++;
+	}
+
+	corridor->stats.steps++;
+}
+
+/*-------------------------- Statistics Code --------------------------------*/
+
+uint32_t trafficAverageTravelSteps(const traffic_stats* stats)
+{
+	if (stats->cars_exited == 0)
+	{
+		return 0;
+	}
+
+	return (uint32_t)(stats->total_travel_steps / stats->cars_exited);
+}
+
+uint32_t trafficStopsPerCarX100(const traffic_stats* stats)
+{
+	if (stats->cars_exited == 0)
+	{
+		return 0;
+	}
+
+	return (uint32_t)((stats->total_stops * 100) / stats->cars_exited);
+}
+
+void trafficCorridorReport(traffic_corridor* corridor)
+{
+	traffic_stats* stats = &(corridor->stats);
+
+	printf("Corridor: %u lights, %u cells, mode = %s\n", (unsigned int)corridor->num_lights,
+			(unsigned int)corridor->road_length, (corridor->mode == COORD_GREEN_WAVE) ? "green wave" : "independent");
+	printf("Steps = %u, Cars entered = %u, Cars exited = %u\n", (unsigned int)stats->steps,
+			(unsigned int)stats->cars_entered, (unsigned int)stats->cars_exited);
+	printf("Average travel time = %u steps, Stops per car x100 = %u\n",
+			(unsigned int)trafficAverageTravelSteps(stats), (unsigned int)trafficStopsPerCarX100(stats));
+}
@@ -0,0 +1,129 @@
+/*
+ * traffic.h
+ *
+ * Traffic model for a one-way, single lane road with one or more traffic
+ * lights (a corridor). The road is stored as a bitmap, one bit per car
+ * position, exactly as it is clocked out to the shift register. Each light
+ * has its own phase controller whose green time is proportional to the
+ * traffic flow and whose red time is inversely proportional to it.
+ *
+ * The model has no FreeRTOS dependencies so that it can also be compiled
+ * into the host build (HOST_BUILD) for offline simulation.
+ */
+
+#ifndef TRAFFIC_H_
+#define TRAFFIC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef HOST_BUILD
+	#include <stdio.h>
+	#include <stdlib.h>
+	#define TRAFFIC_MALLOC(size)	malloc(size)
+	#define TRAFFIC_FREE(ptr)		free(ptr)
+#else
+	#include "../FreeRTOS_Source/include/FreeRTOS.h"
+	#define TRAFFIC_MALLOC(size)	pvPortMalloc(size)
+	#define TRAFFIC_FREE(ptr)		vPortFree(ptr)
+#endif
+
+/* Flow values come straight from the 12-bit ADC reading of the potentiometer. */
+#define TRAFFIC_FLOW_MAX			4095
+
+/* Default phase durations, in road steps. Green and red share the same range,
+and red takes whatever part of it green does not, so the cycle length is
+independent of the flow, which keeps a green wave intact while the flow
+changes. */
+#define TRAFFIC_GREEN_MIN_STEPS		4
+#define TRAFFIC_RED_MIN_STEPS		4
+#define TRAFFIC_PHASE_RANGE_STEPS	8
+#define TRAFFIC_YELLOW_STEPS		2
+#define TRAFFIC_CYCLE_STEPS			( TRAFFIC_GREEN_MIN_STEPS + TRAFFIC_RED_MIN_STEPS + TRAFFIC_PHASE_RANGE_STEPS + TRAFFIC_YELLOW_STEPS )
+
+/* Single light system on the board: 8 cells before the light, 11 after it. */
+#define TRAFFIC_DEFAULT_SPACING		8
+#define TRAFFIC_MAX_LIGHTS			1024
+
+typedef enum light_state
+{
+	LIGHT_GREEN,
+	LIGHT_YELLOW,
+	LIGHT_RED
+} light_state;
+
+typedef enum coord_mode
+{
+	COORD_INDEPENDENT,	// Every light starts its cycle at step 0
+	COORD_GREEN_WAVE	// Each light is offset by the travel time from the road entry
+} coord_mode;
+
+/* Phase timing constants of the light controllers. Green time grows from
+green_min_steps by up to green_range_steps as the flow rises, red time grows
+from red_min_steps by up to red_range_steps as the flow falls. */
+typedef struct traffic_timing
+{
+	uint32_t green_min_steps;
+	uint32_t green_range_steps;
+	uint32_t red_min_steps;
+	uint32_t red_range_steps;
+	uint32_t yellow_steps;
+} traffic_timing;
+
+typedef struct traffic_light
+{
+	uint32_t stop_cell;		// Cars on this cell may only advance on green
+	uint32_t offset;		// Phase offset in steps, set by the coordination mode
+	uint32_t green_steps;
+	uint32_t red_steps;
+	light_state state;
+} traffic_light;
+
+typedef struct traffic_stats
+{
+	uint64_t steps;
+	uint32_t cars_entered;
+	uint32_t cars_exited;
+	uint32_t cars_on_road;
+	uint64_t total_travel_steps;	// Summed over cars that have exited
+	uint64_t total_stops;			// Summed over cars that have exited
+} traffic_stats;
+
+typedef struct traffic_corridor
+{
+	uint32_t road_length;		// Number of car positions
+	uint32_t road_words;		// Number of 32 bit words in each bitmap
+	uint32_t* road;				// Bit set = car present
+	uint32_t* entry_step;		// Per cell: step at which the car on it entered (low 32 bits)
+	uint16_t* stops;			// Per cell: number of times the car on it has stopped
+	uint32_t* stopped;			// Bit set = car on this cell did not move last step
+
+	uint32_t num_lights;
+	uint32_t spacing;
+	traffic_light* lights;
+	coord_mode mode;
+	traffic_timing timing;
+
+	uint32_t flow;
+	uint32_t rng_state;			// Private per corridor so corridors can run on separate threads
+	traffic_stats stats;
+} traffic_corridor;
+
+bool trafficCorridorInit(traffic_corridor* corridor, uint32_t num_lights, uint32_t spacing, coord_mode mode, uint32_t seed);
+void trafficCorridorFree(traffic_corridor* corridor);
+void trafficTimingDefault(traffic_timing* timing);
+bool trafficCorridorSetTiming(traffic_corridor* corridor, const traffic_timing* timing);
+void trafficCorridorSetFlow(traffic_corridor* corridor, uint32_t flow);
+void trafficCorridorStep(traffic_corridor* corridor);
+void trafficCorridorReport(traffic_corridor* corridor);
+
+uint32_t trafficAverageTravelSteps(const traffic_stats* stats);
+uint32_t trafficStopsPerCarX100(const traffic_stats* stats);
+
+static inline bool trafficCellOccupied(const traffic_corridor* corridor, uint32_t cell)
+{
+	return (corridor->road[cell >> 5] >> (cell & 31)) & 1;
+}
+
+#endif /* TRAFFIC_H_ */
@@ -0,0 +1,317 @@
+/*
+ * traffic_sim.c
+ *
+ * Headless traffic simulator for the host build. See traffic_sim.h.
+ */
+
+#ifdef HOST_BUILD
+
+#include "traffic_sim.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+
+/*-------------------------- Flow Trace Code --------------------------------*/
+
+static bool flowTraceAppend(flow_trace* trace, uint32_t time_ms, uint32_t flow)
+{
+	if (trace->length == trace->capacity)
+	{
+		uint32_t new_capacity = (trace->capacity == 0) ? 256 : trace->capacity * 2;
+		flow_sample* new_samples = (flow_sample*)realloc(trace->samples, new_capacity * sizeof(flow_sample));
+
+		if (new_samples == NULL)
+		{
+			return false;
+		}
+
+		trace->samples = new_samples;
+		trace->capacity = new_capacity;
+	}
+
+	trace->samples[trace->length].time_ms = time_ms;
+	trace->samples[trace->length].flow = (flow > TRAFFIC_FLOW_MAX) ? TRAFFIC_FLOW_MAX : flow;
+	(trace->length)++;
+
+	return true;
+}
+
+/*
+ * Trace files are plain text with one sample per line: the simulated time in
+ * milliseconds followed by the flow (raw ADC value). Blank lines and lines
+ * starting with '#' are ignored. Samples must be in time order.
+ */
+bool flowTraceLoad(flow_trace* trace, const char* path)
+{
+	if ((trace == NULL) || (path == NULL))
+	{
+		printf("flowTraceLoad: trace or path passed in was NULL.\n");
+		return false;
+	}
+
+	trace->length = 0;
+	trace->capacity = 0;
+	trace->samples = NULL;
+
+	FILE* file = fopen(path, "r");
+
+	if (file == NULL)
+	{
+		printf("flowTraceLoad: could not open %s.\n", path);
+		return false;
+	}
+
+	char line[128];
+	uint32_t line_number = 0;
+
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		unsigned long time_ms;
+		unsigned long flow;
+		line_number++;
+
+		if (line[0] == '#' || line[0] == '\n' || line[0] == '\r')
+		{
+			continue;
+		}
+
+		if (sscanf(line, "%lu %lu", &time_ms, &flow) != 2)
+		{
+			printf("flowTraceLoad: %s:%u is not a valid sample.\n", path, (unsigned int)line_number);
+			fclose(file);
+			flowTraceFree(trace);
+			return false;
+		}
+
+		if (trace->length != 0 && time_ms < trace->samples[trace->length - 1].time_ms)
+		{
+			printf("flowTraceLoad: %s:%u is out of time order.\n", path, (unsigned int)line_number);
+			fclose(file);
+			flowTraceFree(trace);
+			return false;
+		}
+
+		if (!flowTraceAppend(trace, (uint32_t)time_ms, (uint32_t)flow))
+		{
+			printf("flowTraceLoad: out of memory.\n");
+			fclose(file);
+			flowTraceFree(trace);
+			return false;
+		}
+	}
+
+	fclose(file);
+
+	if (trace->length == 0)
+	{
+		printf("flowTraceLoad: %s has no samples.\n", path);
+		return false;
+	}
+
+	return true;
+}
+
+void flowTraceFree(flow_trace* trace)
+{
+	if (trace == NULL)
+	{
+		return;
+	}
+
+	free(trace->samples);
+	trace->samples = NULL;
+	trace->length = 0;
+	trace->capacity = 0;
+}
+
+uint32_t flowTraceDurationMs(const flow_trace* trace)
+{
+	if (trace == NULL || trace->length == 0)
+	{
+		return 0;
+	}
+
+	// The last sample holds for one more step so that it is actually simulated
+	return trace->samples[trace->length - 1].time_ms + TRAFFIC_SIM_STEP_MS;
+}
+
+/*-------------------------- Scenario Code ----------------------------------*/
+
+void trafficScenarioInit(traffic_scenario* scenario, const flow_trace* trace)
+{
+	scenario->trace = trace;
+	scenario->num_lights = 1;
+	scenario->spacing = TRAFFIC_DEFAULT_SPACING;
+	scenario->mode = COORD_INDEPENDENT;
+	scenario->seed = 1;
+	scenario->duration_ms = 0;
+	trafficTimingDefault(&(scenario->timing));
+	memset(&(scenario->stats), 0, sizeof(scenario->stats));
+	scenario->wall_seconds = 0.0;
+	scenario->ok = false;
+}
+
+static double trafficSimWallTime(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+bool trafficSimRun(traffic_scenario* scenario)
+{
+	traffic_corridor corridor;
+
+	if (scenario == NULL || scenario->trace == NULL || scenario->trace->length == 0)
+	{
+		printf("trafficSimRun: scenario has no flow trace.\n");
+		return false;
+	}
+
+	if (!trafficCorridorInit(&corridor, scenario->num_lights, scenario->spacing, scenario->mode, scenario->seed))
+	{
+		scenario->ok = false;
+		return false;
+	}
+
+	if (!trafficCorridorSetTiming(&corridor, &(scenario->timing)))
+	{
+		trafficCorridorFree(&corridor);
+		scenario->ok = false;
+		return false;
+	}
+
+	const flow_trace* trace = scenario->trace;
+	uint32_t duration_ms = (scenario->duration_ms != 0) ? scenario->duration_ms : flowTraceDurationMs(trace);
+	uint32_t next_sample = 0;
+	double start = trafficSimWallTime();
+
+	// No tick sleeps: simulated time only advances as fast as the model can be stepped
+	for (uint64_t sim_ms = 0; sim_ms < duration_ms; sim_ms += TRAFFIC_SIM_STEP_MS)
+	{
+		while (next_sample < trace->length && trace->samples[next_sample].time_ms <= sim_ms)
+		{
+			trafficCorridorSetFlow(&corridor, trace->samples[next_sample].flow);
+			next_sample++;
+		}
+
+		trafficCorridorStep(&corridor);
+	}
+
+	scenario->wall_seconds = trafficSimWallTime() - start;
+	scenario->stats = corridor.stats;
+	scenario->ok = true;
+
+	trafficCorridorFree(&corridor);
+	return true;
+}
+
+typedef struct sim_pool
+{
+	traffic_scenario* scenarios;
+	uint32_t count;
+	atomic_uint next;
+	atomic_bool failed;
+} sim_pool;
+
+static void* trafficSimWorker(void* arg)
+{
+	sim_pool* pool = (sim_pool*)arg;
+	uint32_t index;
+
+	while ((index = atomic_fetch_add(&(pool->next), 1)) < pool->count)
+	{
+		if (!trafficSimRun(&(pool->scenarios[index])))
+		{
+			atomic_store(&(pool->failed), true);
+		}
+	}
+
+	return NULL;
+}
+
+bool trafficSimRunParallel(traffic_scenario* scenarios, uint32_t count, uint32_t num_threads)
+{
+	if (scenarios == NULL || count == 0)
+	{
+		printf("trafficSimRunParallel: no scenarios passed in.\n");
+		return false;
+	}
+
+	if (num_threads == 0) num_threads = 1;
+	if (num_threads > count) num_threads = count;
+
+	sim_pool pool;
+	pool.scenarios = scenarios;
+	pool.count = count;
+	atomic_init(&(pool.next), 0);
+	atomic_init(&(pool.failed), false);
+
+	pthread_t* threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+
+	if (threads == NULL)
+	{
+		printf("trafficSimRunParallel: could not allocate threads.\n");
+		return false;
+	}
+
+	uint32_t started = 0;
+
+	// The calling thread also works, so only num_threads - 1 helpers are needed
+	for (uint32_t i = 1; i < num_threads; i++)
+	{
+		if (pthread_create(&threads[started], NULL, trafficSimWorker, &pool) != 0)
+		{
+			printf("trafficSimRunParallel: could not start thread %u.\n", (unsigned int)i);
+			break;
+		}
+		started++;
+	}
+
+	trafficSimWorker(&pool);
+
+	for (uint32_t i = 0; i < started; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+
+	free(threads);
+	return !atomic_load(&(pool.failed));
+}
+
+double trafficSimSpeedup(const traffic_scenario* scenario)
+{
+	if (scenario->wall_seconds <= 0.0)
+	{
+		return 0.0;
+	}
+
+	double sim_seconds = (double)scenario->stats.steps * TRAFFIC_SIM_STEP_MS / 1000.0;
+	return sim_seconds / scenario->wall_seconds;
+}
+
+void trafficSimReport(const traffic_scenario* scenario)
+{
+	const traffic_stats* stats = &(scenario->stats);
+	double sim_seconds = (double)stats->steps * TRAFFIC_SIM_STEP_MS / 1000.0;
+
+	printf("Scenario: %u lights, seed %u, mode = %s\n", (unsigned int)scenario->num_lights, (unsigned int)scenario->seed,
+			(scenario->mode == COORD_GREEN_WAVE) ? "green wave" : "independent");
+
+	// A scenario that could not be set up has no results
+	if (!scenario->ok)
+	{
+		printf("  Failed, no results\n");
+		return;
+	}
+
+	printf("  Simulated %.0f s in %.3f s wall (%.0f simulated s per wall s)\n",
+			sim_seconds, scenario->wall_seconds, trafficSimSpeedup(scenario));
+	printf("  Cars exited = %u, Average travel time = %u steps, Stops per car = %.2f\n",
+			(unsigned int)stats->cars_exited, (unsigned int)trafficAverageTravelSteps(stats),
+			trafficStopsPerCarX100(stats) / 100.0);
+}
+
+#endif /* HOST_BUILD */
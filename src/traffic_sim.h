@@ -0,0 +1,64 @@
+/*
+ * traffic_sim.h
+ *
+ * Headless, host only traffic simulator. Runs the corridor model and light
+ * controllers from traffic.c as fast as the CPU allows, with the flow driven
+ * from a recorded flow-rate trace instead of the potentiometer, so a day of
+ * recorded traffic can be replayed in seconds. Independent scenarios can be
+ * run in parallel threads; each one owns its corridor, and traces are only
+ * ever read.
+ */
+
+#ifndef TRAFFIC_SIM_H_
+#define TRAFFIC_SIM_H_
+
+#ifdef HOST_BUILD
+
+#include "traffic.h"
+
+/* Simulated time covered by one road step (one shift of the shift register). */
+#define TRAFFIC_SIM_STEP_MS			500
+
+typedef struct flow_sample
+{
+	uint32_t time_ms;	// Simulated time at which the flow takes effect
+	uint32_t flow;		// 0 to TRAFFIC_FLOW_MAX
+} flow_sample;
+
+typedef struct flow_trace
+{
+	uint32_t length;
+	uint32_t capacity;
+	flow_sample* samples;	// Sorted by time_ms
+} flow_trace;
+
+typedef struct traffic_scenario
+{
+	// Inputs
+	const flow_trace* trace;
+	uint32_t num_lights;
+	uint32_t spacing;
+	coord_mode mode;
+	uint32_t seed;
+	uint32_t duration_ms;	// 0 = run until the end of the trace
+	traffic_timing timing;
+
+	// Outputs
+	traffic_stats stats;
+	double wall_seconds;
+	bool ok;
+} traffic_scenario;
+
+bool flowTraceLoad(flow_trace* trace, const char* path);
+void flowTraceFree(flow_trace* trace);
+uint32_t flowTraceDurationMs(const flow_trace* trace);
+
+void trafficScenarioInit(traffic_scenario* scenario, const flow_trace* trace);
+bool trafficSimRun(traffic_scenario* scenario);
+bool trafficSimRunParallel(traffic_scenario* scenarios, uint32_t count, uint32_t num_threads);
+double trafficSimSpeedup(const traffic_scenario* scenario);
+void trafficSimReport(const traffic_scenario* scenario);
+
+#endif /* HOST_BUILD */
+
+#endif /* TRAFFIC_SIM_H_ */
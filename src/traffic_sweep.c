@@ -0,0 +1,365 @@
+/*
+ * traffic_sweep.c
+ *
+ * Light timing parameter sweep for the host build. See traffic_sweep.h.
+ *
+ * Every (candidate, trace) pair is one job. Jobs are dealt out to the
+ * workers in contiguous ranges; a worker takes jobs from the front of its own
+ * range, and once that is empty it steals the back half of the largest range
+ * left among the other workers. A range is a single 64 bit atomic word (begin
+ * in the low half, end in the high half), so both taking and stealing are one
+ * compare and swap and no locks are needed.
+ */
+
+#ifdef HOST_BUILD
+
+#include "traffic_sweep.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+/*-------------------------- Candidate Generation ---------------------------*/
+
+static const uint32_t grid_green_min[] = {2, 4, 6, 8};
+static const uint32_t grid_green_range[] = {0, 4, 8, 12};
+static const uint32_t grid_red_min[] = {2, 4, 6, 8};
+static const uint32_t grid_red_range[] = {0, 4, 8, 12};
+
+#define GRID_LENGTH(array)	(sizeof(array) / sizeof((array)[0]))
+
+/* Bounds used by the random search, in road steps. */
+#define SWEEP_RANDOM_MIN_STEPS		1
+#define SWEEP_RANDOM_MAX_STEPS		16
+
+uint32_t sweepGridSize(void)
+{
+	return GRID_LENGTH(grid_green_min) * GRID_LENGTH(grid_green_range) *
+		   GRID_LENGTH(grid_red_min) * GRID_LENGTH(grid_red_range);
+}
+
+void sweepGridCandidate(uint32_t index, traffic_timing* timing)
+{
+	trafficTimingDefault(timing);
+
+	timing->red_range_steps = grid_red_range[index % GRID_LENGTH(grid_red_range)];
+	index /= GRID_LENGTH(grid_red_range);
+	timing->red_min_steps = grid_red_min[index % GRID_LENGTH(grid_red_min)];
+	index /= GRID_LENGTH(grid_red_min);
+	timing->green_range_steps = grid_green_range[index % GRID_LENGTH(grid_green_range)];
+	index /= GRID_LENGTH(grid_green_range);
+	timing->green_min_steps = grid_green_min[index % GRID_LENGTH(grid_green_min)];
+}
+
+static uint32_t sweepRandomBetween(uint32_t* rng_state, uint32_t low, uint32_t high)
+{
+	*rng_state = *rng_state * 1664525UL + 1013904223UL;
+	return low + ((*rng_state >> 16) % (high - low + 1));
+}
+
+void sweepRandomCandidate(uint32_t* rng_state, traffic_timing* timing)
+{
+	trafficTimingDefault(timing);
+
+	timing->green_min_steps = sweepRandomBetween(rng_state, SWEEP_RANDOM_MIN_STEPS, SWEEP_RANDOM_MAX_STEPS);
+	timing->green_range_steps = sweepRandomBetween(rng_state, 0, SWEEP_RANDOM_MAX_STEPS);
+	timing->red_min_steps = sweepRandomBetween(rng_state, SWEEP_RANDOM_MIN_STEPS, SWEEP_RANDOM_MAX_STEPS);
+	timing->red_range_steps = sweepRandomBetween(rng_state, 0, SWEEP_RANDOM_MAX_STEPS);
+}
+
+/*-------------------------- Work Stealing Pool -----------------------------*/
+
+typedef struct sweep_worker
+{
+	_Alignas(64) atomic_uint_least64_t range;	// One cache line per worker to avoid false sharing
+} sweep_worker;
+
+typedef struct sweep_pool
+{
+	const sweep_config* config;
+	const sweep_result* results;
+	traffic_stats* job_stats;	// One slot per job, written only by the worker that ran it
+	bool* job_ok;
+	sweep_worker* workers;
+	uint32_t num_workers;
+} sweep_pool;
+
+typedef struct sweep_thread_arg
+{
+	sweep_pool* pool;
+	uint32_t id;
+	pthread_t thread;
+} sweep_thread_arg;
+
+static inline uint64_t sweepPackRange(uint32_t begin, uint32_t end)
+{
+	return ((uint64_t)end << 32) | begin;
+}
+
+static bool sweepTakeJob(sweep_worker* worker, uint32_t* job)
+{
+	uint64_t old_range = atomic_load(&(worker->range));
+
+	while (1)
+	{
+		uint32_t begin = (uint32_t)old_range;
+		uint32_t end = (uint32_t)(old_range >> 32);
+
+		if (begin >= end)
+		{
+			return false;
+		}
+
+		if (atomic_compare_exchange_weak(&(worker->range), &old_range, sweepPackRange(begin + 1, end)))
+		{
+			*job = begin;
+			return true;
+		}
+	}
+}
+
+static bool sweepSteal(sweep_pool* pool, uint32_t thief)
+{
+	while (1)
+	{
+		// Pick the victim with the most jobs left
+		uint32_t victim = thief;
+		uint32_t most = 0;
+
+		for (uint32_t i = 0; i < pool->num_workers; i++)
+		{
+			uint64_t range = atomic_load(&(pool->workers[i].range));
+			uint32_t begin = (uint32_t)range;
+			uint32_t end = (uint32_t)(range >> 32);
+
+			if (i != thief && end > begin && end - begin > most)
+			{
+				most = end - begin;
+				victim = i;
+			}
+		}
+
+		if (victim == thief)
+		{
+			return false;
+		}
+
+		uint64_t old_range = atomic_load(&(pool->workers[victim].range));
+		uint32_t begin = (uint32_t)old_range;
+		uint32_t end = (uint32_t)(old_range >> 32);
+
+		if (begin >= end)
+		{
+			continue;
+		}
+
+		uint32_t stolen = (end - begin + 1) / 2;
+
+		if (atomic_compare_exchange_strong(&(pool->workers[victim].range), &old_range, sweepPackRange(begin, end - stolen)))
+		{
+			// Our own range is empty, so nobody else can be modifying it
+			atomic_store(&(pool->workers[thief].range), sweepPackRange(end - stolen, end));
+			return true;
+		}
+	}
+}
+
+static void sweepRunJob(sweep_pool* pool, uint32_t job)
+{
+	const sweep_config* config = pool->config;
+	traffic_scenario scenario;
+
+	trafficScenarioInit(&scenario, &(config->traces[job % config->num_traces]));
+	scenario.num_lights = config->num_lights;
+	scenario.mode = config->mode;
+	scenario.seed = config->seed;
+	scenario.timing = pool->results[job / config->num_traces].timing;
+
+	pool->job_ok[job] = trafficSimRun(&scenario);
+	pool->job_stats[job] = scenario.stats;
+}
+
+static void* sweepWorker(void* arg)
+{
+	sweep_thread_arg* thread_arg = (sweep_thread_arg*)arg;
+	sweep_pool* pool = thread_arg->pool;
+	sweep_worker* self = &(pool->workers[thread_arg->id]);
+	uint32_t job;
+
+	while (1)
+	{
+		while (sweepTakeJob(self, &job))
+		{
+			sweepRunJob(pool, job);
+		}
+
+		if (!sweepSteal(pool, thread_arg->id))
+		{
+			return NULL;
+		}
+	}
+}
+
+/*-------------------------- Sweep Code -------------------------------------*/
+
+static void sweepAggregate(const sweep_config* config, sweep_result* result, const traffic_stats* stats, const bool* ok)
+{
+	// A car that is never stopped needs one step per cell to cross the corridor
+	uint32_t free_flow_steps = (config->num_lights + 1) * TRAFFIC_DEFAULT_SPACING;
+	double throughput = 0.0;
+	double wait_steps = 0.0;
+	uint64_t cars = 0;
+
+	result->ok = true;
+
+	for (uint32_t t = 0; t < config->num_traces; t++)
+	{
+		if (!ok[t] || stats[t].steps == 0)
+		{
+			result->ok = false;
+			return;
+		}
+
+		double hours = (double)stats[t].steps * TRAFFIC_SIM_STEP_MS / 3600000.0;
+		throughput += stats[t].cars_exited / hours;
+		wait_steps += (double)stats[t].total_travel_steps - (double)free_flow_steps * stats[t].cars_exited;
+		cars += stats[t].cars_exited;
+	}
+
+	result->throughput = throughput / config->num_traces;
+	result->average_wait_ms = (cars == 0) ? 0.0 : (wait_steps / cars) * TRAFFIC_SIM_STEP_MS;
+}
+
+bool sweepRun(const sweep_config* config, sweep_result* results, uint32_t num_candidates)
+{
+	if (config == NULL || results == NULL || config->traces == NULL || config->num_traces == 0 || num_candidates == 0)
+	{
+		printf("sweepRun: nothing to sweep.\n");
+		return false;
+	}
+
+	uint32_t num_jobs = num_candidates * config->num_traces;
+	uint32_t num_workers = (config->num_threads == 0) ? 1 : config->num_threads;
+	if (num_workers > num_jobs) num_workers = num_jobs;
+
+	sweep_pool pool;
+	pool.config = config;
+	pool.results = results;
+	pool.num_workers = num_workers;
+	pool.job_stats = (traffic_stats*)calloc(num_jobs, sizeof(traffic_stats));
+	pool.job_ok = (bool*)calloc(num_jobs, sizeof(bool));
+	pool.workers = (sweep_worker*)aligned_alloc(64, num_workers * sizeof(sweep_worker));
+	sweep_thread_arg* args = (sweep_thread_arg*)calloc(num_workers, sizeof(sweep_thread_arg));
+
+	if (pool.job_stats == NULL || pool.job_ok == NULL || pool.workers == NULL || args == NULL)
+	{
+		printf("sweepRun: could not allocate the worker pool.\n");
+		free(pool.job_stats);
+		free(pool.job_ok);
+		free(pool.workers);
+		free(args);
+		return false;
+	}
+
+	// Deal the jobs out in equal contiguous ranges
+	for (uint32_t i = 0; i < num_workers; i++)
+	{
+		uint32_t begin = (uint32_t)(((uint64_t)num_jobs * i) / num_workers);
+		uint32_t end = (uint32_t)(((uint64_t)num_jobs * (i + 1)) / num_workers);
+		atomic_init(&(pool.workers[i].range), sweepPackRange(begin, end));
+		args[i].pool = &pool;
+		args[i].id = i;
+	}
+
+	uint32_t started = 0;
+
+	for (uint32_t i = 1; i < num_workers; i++)
+	{
+		if (pthread_create(&(args[i].thread), NULL, sweepWorker, &args[i]) != 0)
+		{
+			// Jobs dealt to a worker that never started are stolen by the others
+			printf("sweepRun: could not start thread %u.\n", (unsigned int)i);
+			break;
+		}
+		started++;
+	}
+
+	sweepWorker(&args[0]);
+
+	for (uint32_t i = 1; i <= started; i++)
+	{
+		pthread_join(args[i].thread, NULL);
+	}
+
+	bool ok = true;
+
+	for (uint32_t c = 0; c < num_candidates; c++)
+	{
+		uint32_t first_job = c * config->num_traces;
+		sweepAggregate(config, &results[c], &(pool.job_stats[first_job]), &(pool.job_ok[first_job]));
+		ok = ok && results[c].ok;
+	}
+
+	sweepMarkPareto(results, num_candidates);
+
+	free(pool.job_stats);
+	free(pool.job_ok);
+	free(pool.workers);
+	free(args);
+	return ok;
+}
+
+uint32_t sweepMarkPareto(sweep_result* results, uint32_t num_candidates)
+{
+	uint32_t front_size = 0;
+
+	for (uint32_t i = 0; i < num_candidates; i++)
+	{
+		results[i].pareto = results[i].ok;
+
+		for (uint32_t j = 0; j < num_candidates && results[i].pareto; j++)
+		{
+			if (j == i || !results[j].ok)
+			{
+				continue;
+			}
+
+			// j dominates i if it is at least as good on both axes and better on one
+			bool no_worse = results[j].throughput >= results[i].throughput &&
+							results[j].average_wait_ms <= results[i].average_wait_ms;
+			bool better = results[j].throughput > results[i].throughput ||
+						  results[j].average_wait_ms < results[i].average_wait_ms;
+
+			if (no_worse && better)
+			{
+				results[i].pareto = false;
+			}
+		}
+
+		if (results[i].pareto) front_size++;
+	}
+
+	return front_size;
+}
+
+void sweepReport(const sweep_result* results, uint32_t num_candidates)
+{
+	printf("Pareto front (throughput vs average wait):\n");
+	printf("green_min green_range red_min red_range  cars/hour  wait_ms\n");
+
+	for (uint32_t i = 0; i < num_candidates; i++)
+	{
+		const sweep_result* result = &results[i];
+
+		if (!result->pareto)
+		{
+			continue;
+		}
+
+		printf("%9u %11u %7u %9u %10.1f %8.1f\n",
+				(unsigned int)result->timing.green_min_steps, (unsigned int)result->timing.green_range_steps,
+				(unsigned int)result->timing.red_min_steps, (unsigned int)result->timing.red_range_steps,
+				result->throughput, result->average_wait_ms);
+	}
+}
+
+#endif /* HOST_BUILD */
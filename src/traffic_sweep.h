@@ -0,0 +1,48 @@
+/*
+ * traffic_sweep.h
+ *
+ * Parameter sweep for the light phase timing constants (host build only).
+ * Every candidate traffic_timing is run against every recorded flow trace
+ * with the headless simulator, on a pool of worker threads that steal work
+ * from each other. Each job writes only its own result slot and builds its
+ * own corridor, so workers share no mutable simulator state. The candidates
+ * on the Pareto front of throughput versus average wait are reported.
+ */
+
+#ifndef TRAFFIC_SWEEP_H_
+#define TRAFFIC_SWEEP_H_
+
+#ifdef HOST_BUILD
+
+#include "traffic_sim.h"
+
+typedef struct sweep_result
+{
+	traffic_timing timing;
+	double throughput;		// Cars leaving the corridor per simulated hour, averaged over traces
+	double average_wait_ms;	// Travel time beyond free flow, averaged over cars and traces
+	bool pareto;			// Not dominated by any other candidate
+	bool ok;
+} sweep_result;
+
+typedef struct sweep_config
+{
+	const flow_trace* traces;
+	uint32_t num_traces;
+	uint32_t num_lights;
+	coord_mode mode;
+	uint32_t seed;
+	uint32_t num_threads;
+} sweep_config;
+
+uint32_t sweepGridSize(void);
+void sweepGridCandidate(uint32_t index, traffic_timing* timing);
+void sweepRandomCandidate(uint32_t* rng_state, traffic_timing* timing);
+
+bool sweepRun(const sweep_config* config, sweep_result* results, uint32_t num_candidates);
+uint32_t sweepMarkPareto(sweep_result* results, uint32_t num_candidates);
+void sweepReport(const sweep_result* results, uint32_t num_candidates);
+
+#endif /* HOST_BUILD */
+
+#endif /* TRAFFIC_SWEEP_H_ */
@@ -0,0 +1,113 @@
+/*
+ * traffic_sweep_main.c
+ *
+ * Command line entry point for the light timing sweep (host build only).
+ *
+ * Usage: traffic_sweep [-r candidates] [-l lights] [-t threads] [-w] <trace file>...
+ *
+ * Without -r the full grid of timing constants is evaluated, with -r the
+ * given number of random candidates is drawn instead. -w runs the lights as
+ * a green wave.
+ */
+
+#ifdef HOST_BUILD
+
+#include "traffic_sweep.h"
+
+#include <string.h>
+#include <time.h>
+
+int main(int argc, char** argv)
+{
+	uint32_t num_random = 0;
+	uint32_t num_lights = 1;
+	uint32_t num_threads = 1;
+	coord_mode mode = COORD_INDEPENDENT;
+	int arg = 1;
+
+	while (arg < argc && argv[arg][0] == '-')
+	{
+		if (strcmp(argv[arg], "-w") == 0)
+		{
+			mode = COORD_GREEN_WAVE;
+			arg++;
+			continue;
+		}
+
+		if (arg + 1 >= argc)
+		{
+			break;
+		}
+
+		uint32_t value = (uint32_t)strtoul(argv[arg + 1], NULL, 10);
+
+		if (strcmp(argv[arg], "-r") == 0) num_random = value;
+		else if (strcmp(argv[arg], "-l") == 0) num_lights = value;
+		else if (strcmp(argv[arg], "-t") == 0) num_threads = value;
+		else break;
+
+		arg += 2;
+	}
+
+	if (arg >= argc)
+	{
+		printf("Usage: %s [-r candidates] [-l lights] [-t threads] [-w] <trace file>...\n", argv[0]);
+		return 1;
+	}
+
+	uint32_t num_traces = (uint32_t)(argc - arg);
+	flow_trace* traces = (flow_trace*)calloc(num_traces, sizeof(flow_trace));
+	uint32_t num_candidates = (num_random != 0) ? num_random : sweepGridSize();
+	sweep_result* results = (sweep_result*)calloc(num_candidates, sizeof(sweep_result));
+
+	if (traces == NULL || results == NULL)
+	{
+		printf("Could not allocate the sweep.\n");
+		return 1;
+	}
+
+	for (uint32_t t = 0; t < num_traces; t++)
+	{
+		if (!flowTraceLoad(&traces[t], argv[arg + t]))
+		{
+			return 1;
+		}
+	}
+
+	uint32_t rng_state = 1;
+
+	for (uint32_t c = 0; c < num_candidates; c++)
+	{
+		if (num_random != 0) sweepRandomCandidate(&rng_state, &(results[c].timing));
+		else sweepGridCandidate(c, &(results[c].timing));
+	}
+
+	sweep_config config;
+	config.traces = traces;
+	config.num_traces = num_traces;
+	config.num_lights = num_lights;
+	config.mode = mode;
+	config.seed = 1;
+	config.num_threads = num_threads;
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	bool ok = sweepRun(&config, results, num_candidates);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	sweepReport(results, num_candidates);
+	printf("Evaluated %u candidates x %u traces in %.3f s on %u threads\n", (unsigned int)num_candidates,
+			(unsigned int)num_traces, (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) * 1e-9,
+			(unsigned int)num_threads);
+
+	for (uint32_t t = 0; t < num_traces; t++)
+	{
+		flowTraceFree(&traces[t]);
+	}
+
+	free(traces);
+	free(results);
+	return ok ? 0 : 1;
+}
+
+#endif /* HOST_BUILD */